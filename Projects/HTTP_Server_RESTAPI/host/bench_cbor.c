@@ -0,0 +1,369 @@
+/**
+ * @file	bench_cbor.c
+ * @brief	Host benchmark - JSON vs. CBOR representations of the REST API resources
+ *
+ * Renders the document of every resource with the jsonWriter in both formats (the same calls as the handlers)
+ * and reports the size and the encode ns/op, then the client side decode ns/op of each document:
+ * JSON with the frozen tokenizer, CBOR with a minimal item walker. The last rows compare json_decode()
+ * and cbor_decode() on the 'PUT /userio/:id/info' body.
+ *
+ * Build and run on the host (from Projects/HTTP_Server_RESTAPI):
+ *
+ * gcc -O2 -Isrc/HTTPServer -Isrc/HTTPServer/frozen host/bench_cbor.c src/HTTPServer/jsonWriter.c src/HTTPServer/jsonDecoder.c src/HTTPServer/frozen/frozen.c -o bench_cbor
+ * ./bench_cbor [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "frozen.h"
+#include "jsonWriter.h"
+#include "jsonDecoder.h"
+
+#define DATA_BUF_SIZE		2048
+#define MAX_TOKENS			200
+#define USER_IOn			4
+
+static const char * USER_IO_STR[USER_IOn] = { "a", "b", "c", "d" };
+static const char * USER_IO_PIN_STR[USER_IOn] = { "p30", "p29", "p28", "p27" };
+static const char * USER_IO_TYPE[USER_IOn] = { "digital", "analog", "digital", "digital" };
+static const char * USER_IO_DIR[USER_IOn] = { "output", "input", "input", "input" };
+
+// Built-in resources of RESTapiHandler.c: uri / method list / description
+static const char * resources[][3] =
+{
+	{ "http://192.168.0.100/index",           "GET, HEAD", "index page" },
+	{ "http://192.168.0.100/uptime",          "GET, HEAD", "uptime" },
+	{ "http://192.168.0.100/netinfo",         "GET, HEAD", "network configration" },
+	{ "http://192.168.0.100/userio",          "GET, HEAD", "enabled io list" },
+	{ "http://192.168.0.100/userio/:id",      "GET, HEAD", "get io status or value" },
+	{ "http://192.168.0.100/userio/:id",      "POST",      "enable new io pin" },
+	{ "http://192.168.0.100/userio/:id",      "PUT",       "set the io status (digital output only)" },
+	{ "http://192.168.0.100/userio/:id",      "DELETE",    "disable the io pin" },
+	{ "http://192.168.0.100/userio/:id/info", "GET, HEAD", "get the io configuration, type and direction" },
+	{ "http://192.168.0.100/userio/:id/info", "PUT",       "set the io configuration, type and direction" },
+	{ NULL, NULL, NULL }
+};
+
+/*****************************************************************************
+ * Resource documents: the writer calls of the handlers
+ ****************************************************************************/
+static void index_doc(st_json_writer * w)
+{
+	int i;
+
+	json_begin_object(w);
+	json_key(w, "target");
+	json_str(w, "wizwiki-7500eco");
+	json_key(w, "io");
+	json_begin_array(w);
+	for(i = 0; i < USER_IOn; i++)
+	{
+		json_begin_object(w);
+		json_key(w, "id");
+		json_str(w, USER_IO_STR[i]);
+		json_key(w, "pin");
+		json_str(w, USER_IO_PIN_STR[i]);
+		json_end(w);
+	}
+	json_end(w);
+	json_key(w, "resource");
+	json_begin_array(w);
+	for(i = 0; resources[i][0] != NULL; i++)
+	{
+		json_begin_object(w);
+		json_key(w, "uri");
+		json_str(w, resources[i][0]);
+		json_key(w, "method");
+		json_str(w, resources[i][1]);
+		json_key(w, "description");
+		json_str(w, resources[i][2]);
+		json_end(w);
+	}
+	json_end(w);
+	json_end(w);
+}
+
+static void uptime_doc(st_json_writer * w)
+{
+	json_begin_object(w);
+	json_key(w, "uptime");
+	json_begin_object(w);
+	json_key(w, "hour");
+	json_int(w, 1234);
+	json_key(w, "min");
+	json_int(w, 56);
+	json_key(w, "sec");
+	json_int(w, 7);
+	json_key(w, "msec");
+	json_int(w, 890);
+	json_end(w);
+	json_end(w);
+}
+
+static void netinfo_doc(st_json_writer * w)
+{
+	json_begin_object(w);
+	json_key(w, "netinfo");
+	json_begin_object(w);
+	json_key(w, "mac");
+	json_str(w, "00:08:DC:12:34:56");
+	json_key(w, "ip");
+	json_str(w, "192.168.0.100");
+	json_key(w, "gw");
+	json_str(w, "192.168.0.1");
+	json_key(w, "sn");
+	json_str(w, "255.255.255.0");
+	json_key(w, "dns");
+	json_str(w, "8.8.8.8");
+	json_key(w, "dhcp");
+	json_str(w, "disabled");
+	json_end(w);
+	json_end(w);
+}
+
+static void userio_doc(st_json_writer * w)
+{
+	int i;
+
+	json_begin_object(w);
+	json_key(w, "userio");
+	json_begin_array(w);
+	for(i = 0; i < USER_IOn; i++)
+	{
+		json_begin_object(w);
+		json_key(w, "id");
+		json_str(w, USER_IO_STR[i]);
+		json_key(w, "type");
+		json_str(w, USER_IO_TYPE[i]);
+		json_key(w, "direction");
+		json_str(w, USER_IO_DIR[i]);
+		json_end(w);
+	}
+	json_end(w);
+	json_end(w);
+}
+
+// Analog input: the value in volts with 3 decimals
+static void userio_id_doc(st_json_writer * w)
+{
+	json_begin_object(w);
+	json_key(w, "b");
+	json_fixed(w, 3305, 3);
+	json_end(w);
+}
+
+static void userio_info_doc(st_json_writer * w)
+{
+	json_begin_object(w);
+	json_key(w, "id");
+	json_str(w, "a");
+	json_key(w, "type");
+	json_str(w, "digital");
+	json_key(w, "direction");
+	json_str(w, "output");
+	json_end(w);
+}
+
+static void error_doc(st_json_writer * w)
+{
+	json_begin_object(w);
+	json_key(w, "error");
+	json_begin_object(w);
+	json_key(w, "message");
+	json_str(w, "Bad Request");
+	json_key(w, "code");
+	json_int(w, 400);
+	json_key(w, "field");
+	json_str(w, "type");
+	json_key(w, "position");
+	json_int(w, 8);
+	json_end(w);
+	json_end(w);
+}
+
+static const struct
+{
+	const char * name;
+	void (*doc)(st_json_writer *);
+} docs[] =
+{
+	{ "index",       index_doc },
+	{ "uptime",      uptime_doc },
+	{ "netinfo",     netinfo_doc },
+	{ "userio",      userio_doc },
+	{ "userio/:id",  userio_id_doc },
+	{ "userio/info", userio_info_doc },
+	{ "error",       error_doc },
+	{ NULL, NULL }
+};
+
+/*****************************************************************************
+ * Client side decoding
+ ****************************************************************************/
+// Skips one CBOR data item (all the types the writer produces); returns the end, or NULL if malformed
+static const uint8_t * cbor_skip(const uint8_t * p, const uint8_t * end)
+{
+	uint8_t major, info;
+	uint32_t arg = 0;
+	int n;
+
+	if(p >= end) return NULL;
+	major = *p >> 5;
+	info = *p++ & 0x1F;
+
+	if(info == 31) // Indefinite length map / array: items up to the break
+	{
+		if((major != 4) && (major != 5)) return NULL;
+		while((p < end) && (*p != 0xFF))
+		{
+			if((p = cbor_skip(p, end)) == NULL) return NULL;
+		}
+		return (p < end) ? p + 1 : NULL;
+	}
+
+	if(info < 24) arg = info;
+	else if(info <= 26)
+	{
+		n = 1 << (info - 24);
+		if(end - p < n) return NULL;
+		while(n--) arg = (arg << 8) | *p++;
+	}
+	else return NULL;
+
+	switch(major)
+	{
+		case 2: case 3: // Byte / text string
+			return ((uint32_t)(end - p) < arg) ? NULL : p + arg;
+		case 4: // Array
+			while(arg-- && p) p = cbor_skip(p, end);
+			return p;
+		case 5: // Map
+			arg *= 2;
+			while(arg-- && p) p = cbor_skip(p, end);
+			return p;
+		case 6: // Tag
+			return cbor_skip(p, end);
+		default: // Integers, simple values
+			return p;
+	}
+}
+
+static int decode_json(const char * buf, int len)
+{
+	static struct json_token tokens[MAX_TOKENS];
+
+	return parse_json_arena(buf, len, tokens, MAX_TOKENS, NULL);
+}
+
+static int decode_cbor(const char * buf, int len)
+{
+	const uint8_t * end = (const uint8_t *)buf + len;
+
+	return (cbor_skip((const uint8_t *)buf, end) == end) ? len : -1;
+}
+
+/*****************************************************************************
+ * 'PUT /userio/:id/info' body
+ ****************************************************************************/
+struct st_userio_info
+{
+	uint8_t type;
+	uint8_t direction;
+};
+
+static const char * const type_names[] = { "digital", "analog", NULL };
+static const char * const dir_names[] = { "input", "output", NULL };
+
+static const struct st_json_field userio_info_schema[] =
+{
+	{ "type",      JSON_FIELD_ENUM, offsetof(struct st_userio_info, type),      0, 0, type_names },
+	{ "direction", JSON_FIELD_ENUM, offsetof(struct st_userio_info, direction), 0, 0, dir_names },
+	{ NULL, 0, 0, 0, 0, NULL }
+};
+
+static const char body_json[] = "{\"type\":\"digital\",\"direction\":\"output\"}";
+static const uint8_t body_cbor[] =
+{
+	0xA2,
+	0x64, 't', 'y', 'p', 'e', 0x67, 'd', 'i', 'g', 'i', 't', 'a', 'l',
+	0x69, 'd', 'i', 'r', 'e', 'c', 't', 'i', 'o', 'n', 0x66, 'o', 'u', 't', 'p', 'u', 't'
+};
+
+/*****************************************************************************
+ * Benchmark runner
+ ****************************************************************************/
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int render(void (*doc)(st_json_writer *), char * buf, uint8_t format)
+{
+	st_json_writer w;
+
+	json_writer_init(&w, buf, DATA_BUF_SIZE, NULL, NULL);
+	json_writer_set_format(&w, format);
+	doc(&w);
+
+	return json_writer_finish(&w);
+}
+
+static void run(const char * name, void (*doc)(st_json_writer *), uint8_t format, long iterations)
+{
+	static char buf[DATA_BUF_SIZE];
+	volatile int len = 0;
+	volatile int ret = 0;
+	double start, encode;
+	long i;
+
+	start = now_ns();
+	for(i = 0; i < iterations; i++) len = render(doc, buf, format);
+	encode = (now_ns() - start) / iterations;
+
+	start = now_ns();
+	for(i = 0; i < iterations; i++) ret = (format == JSON_WRITER_FORMAT_CBOR) ? decode_cbor(buf, len) : decode_json(buf, len);
+
+	printf("%-12s %-5s %6d bytes  encode %8.1f ns/op  decode %8.1f ns/op%s\n", name, (format == JSON_WRITER_FORMAT_CBOR) ? "cbor" : "json",
+		len, encode, (now_ns() - start) / iterations, (ret < 0) ? "  (decode error)" : "");
+}
+
+static void run_body(const char * name, long iterations)
+{
+	struct st_userio_info info;
+	st_json_decode_result res;
+	volatile int ret = 0;
+	double start;
+	long i;
+	int cbor = !strcmp(name, "cbor");
+
+	start = now_ns();
+	for(i = 0; i < iterations; i++)
+	{
+		if(cbor) ret |= cbor_decode(body_cbor, sizeof(body_cbor), userio_info_schema, &info, &res);
+		else ret |= json_decode(body_json, sizeof(body_json) - 1, userio_info_schema, &info, &res);
+	}
+
+	printf("%-12s %-5s %6d bytes  decode %8.1f ns/op  ret %d\n", "PUT info", name,
+		cbor ? (int)sizeof(body_cbor) : (int)sizeof(body_json) - 1, (now_ns() - start) / iterations, ret);
+}
+
+int main(int argc, char * argv[])
+{
+	long iterations = (argc > 1) ? atol(argv[1]) : 200000;
+	int i;
+
+	for(i = 0; docs[i].name != NULL; i++)
+	{
+		run(docs[i].name, docs[i].doc, JSON_WRITER_FORMAT_JSON, iterations);
+		run(docs[i].name, docs[i].doc, JSON_WRITER_FORMAT_CBOR, iterations);
+	}
+	run_body("json", iterations * 10);
+	run_body("cbor", iterations * 10);
+
+	return 0;
+}
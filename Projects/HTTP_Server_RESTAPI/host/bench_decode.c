@@ -0,0 +1,114 @@
+/**
+ * @file	bench_decode.c
+ * @brief	Host benchmark - JSON request body decoding: frozen tokens + find_json_token() vs. jsonDecoder schema
+ *
+ * Decodes the 'PUT /userio/:id/info' body into the same struct both ways and reports ns/op
+ * and the size of the token array (none for the schema decoder).
+ *
+ * Build and run on the host (from Projects/HTTP_Server_RESTAPI):
+ *
+ * gcc -O2 -Isrc/HTTPServer -Isrc/HTTPServer/frozen host/bench_decode.c src/HTTPServer/jsonDecoder.c src/HTTPServer/frozen/frozen.c -o bench_decode
+ * ./bench_decode [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "frozen.h"
+#include "jsonDecoder.h"
+
+#define USERIO_INFO_TOKENS		6
+
+struct st_userio_info
+{
+	uint8_t type;
+	uint8_t direction;
+};
+
+static const char * const type_names[] = { "digital", "analog", NULL };
+static const char * const dir_names[] = { "input", "output", NULL };
+
+static const struct st_json_field userio_info_schema[] =
+{
+	{ "type",      JSON_FIELD_ENUM, offsetof(struct st_userio_info, type),      0, 0, type_names },
+	{ "direction", JSON_FIELD_ENUM, offsetof(struct st_userio_info, direction), 0, 0, dir_names },
+	{ NULL, 0, 0, 0, 0, NULL }
+};
+
+static const char body[] = "{ \"type\": \"digital\", \"direction\": \"output\" }";
+
+/*****************************************************************************
+ * frozen: token array, find_json_token() per field and string compare
+ ****************************************************************************/
+static int match_name(const struct json_token * tok, const char * const * names, uint8_t * val)
+{
+	uint8_t i;
+
+	if((tok == NULL) || (tok->type != JSON_TYPE_STRING)) return -1;
+	for(i = 0; names[i] != NULL; i++)
+	{
+		if(((int)strlen(names[i]) == tok->len) && !strncmp(names[i], tok->ptr, tok->len))
+		{
+			*val = i;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static int decode_tokens(struct st_userio_info * info)
+{
+	struct json_token tokens[USERIO_INFO_TOKENS];
+
+	if(parse_json_arena(body, sizeof(body) - 1, tokens, USERIO_INFO_TOKENS, NULL) < 0) return -1;
+	if(match_name(find_json_token(tokens, "type"), type_names, &info->type) < 0) return -1;
+	if(match_name(find_json_token(tokens, "direction"), dir_names, &info->direction) < 0) return -1;
+
+	return 0;
+}
+
+/*****************************************************************************
+ * jsonDecoder: one pass, no token array
+ ****************************************************************************/
+static int decode_schema(struct st_userio_info * info)
+{
+	st_json_decode_result res;
+
+	return json_decode(body, sizeof(body) - 1, userio_info_schema, info, &res);
+}
+
+/*****************************************************************************
+ * Benchmark runner
+ ****************************************************************************/
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void run(const char * name, int (*decode)(struct st_userio_info *), long iterations, unsigned tokens)
+{
+	struct st_userio_info info;
+	volatile int ret = 0;
+	double start;
+	long i;
+
+	memset(&info, 0xFF, sizeof(info));
+	start = now_ns();
+	for(i = 0; i < iterations; i++) ret |= decode(&info);
+
+	printf("%-20s %8.1f ns/op  token array %3u bytes  ret %d  type %d direction %d\n", name, (now_ns() - start) / iterations, tokens, ret, info.type, info.direction);
+}
+
+int main(int argc, char * argv[])
+{
+	long iterations = (argc > 1) ? atol(argv[1]) : 2000000;
+
+	run("userio_info/tokens", decode_tokens, iterations, (unsigned)(USERIO_INFO_TOKENS * sizeof(struct json_token)));
+	run("userio_info/schema", decode_schema, iterations, 0);
+
+	return 0;
+}
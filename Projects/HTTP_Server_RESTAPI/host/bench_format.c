@@ -0,0 +1,111 @@
+/**
+ * @file	bench_format.c
+ * @brief	Host micro-benchmark - number formatting: snprintf() based vs. frozen json_emit_long / json_emit_fixed / json_emit_double
+ *
+ * The 'legacy' functions are the previous frozen implementations (snprintf into a temporary buffer and strncpy).
+ * The output buffer is DATA_BUF_SIZE bytes like the REST API handlers; strncpy() pads all the remaining bytes.
+ *
+ * Build and run on the host (from Projects/HTTP_Server_RESTAPI):
+ *
+ * gcc -O2 -Isrc/HTTPServer/frozen host/bench_format.c src/HTTPServer/frozen/frozen.c -o bench_format
+ * ./bench_format [iterations]
+ *
+ * Flash size of the formatters on the target: host/size_format.sh
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "frozen.h"
+
+#define DATA_BUF_SIZE		2048
+
+int legacy_emit_long(char *buf, int buf_len, long int value)
+{
+	char tmp[20];
+	int n = snprintf(tmp, sizeof(tmp), "%ld", value);
+	strncpy(buf, tmp, buf_len > 0 ? buf_len : 0);
+	return n;
+}
+
+int legacy_emit_double(char *buf, int buf_len, double value)
+{
+	char tmp[20];
+	int n = snprintf(tmp, sizeof(tmp), "%g", value);
+	strncpy(buf, tmp, buf_len > 0 ? buf_len : 0);
+	return n;
+}
+
+#ifndef SIZE_PROBE
+
+// Sample values: ADC counts (0 - 4095), uptime counters and signed values
+static long values[256];
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static char buf[DATA_BUF_SIZE];
+
+#define BENCH(name, expr)                                                          \
+	do {                                                                           \
+		volatile int len = 0;                                                      \
+		double start = now_ns();                                                   \
+		for(i = 0; i < iterations; i++) len += (expr);                             \
+		printf("%-22s %8.1f ns/op\n", name, (now_ns() - start) / iterations);      \
+	} while(0)
+
+int main(int argc, char * argv[])
+{
+	long iterations = (argc > 1) ? atol(argv[1]) : 2000000;
+	long i;
+	char a[32], b[32];
+
+	for(i = 0; i < 256; i++)
+	{
+		if(i < 128) values[i] = (i * 4099) % 4096;
+		else if(i < 192) values[i] = i * 86400L + i;
+		else values[i] = -(i * 7919L);
+	}
+
+	// Output check: same as printf
+	for(i = 0; i < 256; i++)
+	{
+		json_emit_long(a, sizeof(a), values[i]);
+		legacy_emit_long(b, sizeof(b), values[i]);
+		if(strcmp(a, b)) printf("mismatch: %s %s\n", a, b);
+	}
+
+	BENCH("long/legacy",          legacy_emit_long(buf, DATA_BUF_SIZE, values[i & 0xFF]));
+	BENCH("long/legacy (16B buf)",legacy_emit_long(buf, 16, values[i & 0xFF]));
+	BENCH("long/json_emit_long",  json_emit_long(buf, DATA_BUF_SIZE, values[i & 0xFF]));
+	BENCH("fixed/json_emit_fixed",json_emit_fixed(buf, DATA_BUF_SIZE, values[i & 0x7F] * 3300 / 4095, 3));
+	BENCH("double/legacy",        legacy_emit_double(buf, DATA_BUF_SIZE, values[i & 0xFF] / 1000.0));
+	BENCH("double/json_emit",     json_emit_double(buf, DATA_BUF_SIZE, values[i & 0xFF] / 1000.0));
+
+	return 0;
+}
+
+#else /* SIZE_PROBE: references only one set of formatters, see size_format.sh */
+
+volatile long probe_value = 1234;
+volatile double probe_double = 1.5;
+char probe_buf[32];
+
+int main(void)
+{
+#if SIZE_PROBE == 1
+	return legacy_emit_long(probe_buf, sizeof(probe_buf), probe_value) + legacy_emit_double(probe_buf, sizeof(probe_buf), probe_double);
+#elif SIZE_PROBE == 2
+	return json_emit_long(probe_buf, sizeof(probe_buf), probe_value) + json_emit_double(probe_buf, sizeof(probe_buf), probe_double);
+#else
+	return json_emit_long(probe_buf, sizeof(probe_buf), probe_value) + json_emit_fixed(probe_buf, sizeof(probe_buf), probe_value, 3);
+#endif
+}
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * @file	bench_http.c
+ * @brief	Host benchmark - Request path (parser, router, handler, response header) over a request corpus: ns/op and bytes copied
+ *
+ * Each request of the corpus is copied to a receive buffer (as recv() does) and run through http_dispatch().
+ * Bytes copied are counted by wrapping the copy functions at link time (memcpy, memmove, strcpy, strncpy, strcat,
+ * sprintf); the receive copy is not counted. See host/Makefile: make bench_http && ./bench_http [iterations]
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "http_dispatch.h"
+
+/*****************************************************************************
+ * Copy accounting: -Wl,--wrap=memcpy,... with -fno-builtin
+ ****************************************************************************/
+static unsigned long copied;
+
+void * __real_memcpy(void * dst, const void * src, size_t n);
+void * __real_memmove(void * dst, const void * src, size_t n);
+char * __real_strcpy(char * dst, const char * src);
+char * __real_strncpy(char * dst, const char * src, size_t n);
+char * __real_strcat(char * dst, const char * src);
+
+void * __wrap_memcpy(void * dst, const void * src, size_t n)
+{
+	copied += n;
+	return __real_memcpy(dst, src, n);
+}
+
+void * __wrap_memmove(void * dst, const void * src, size_t n)
+{
+	copied += n;
+	return __real_memmove(dst, src, n);
+}
+
+char * __wrap_strcpy(char * dst, const char * src)
+{
+	copied += strlen(src) + 1;
+	return __real_strcpy(dst, src);
+}
+
+char * __wrap_strncpy(char * dst, const char * src, size_t n)
+{
+	copied += n; // Padded to n
+	return __real_strncpy(dst, src, n);
+}
+
+char * __wrap_strcat(char * dst, const char * src)
+{
+	copied += strlen(src) + 1;
+	return __real_strcat(dst, src);
+}
+
+int __wrap_sprintf(char * dst, const char * fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsprintf(dst, fmt, ap);
+	va_end(ap);
+	if(n > 0) copied += n + 1;
+
+	return n;
+}
+
+/*****************************************************************************
+ * Request corpus: browser / curl / client library requests of the API
+ ****************************************************************************/
+static const struct
+{
+	const char * name;
+	const char * req;
+} corpus[] =
+{
+	{ "GET / (browser)",
+	  "GET / HTTP/1.1\r\nHost: 192.168.0.100\r\nUser-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:45.0) Gecko/20100101 Firefox/45.0\r\n"
+	  "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\nAccept-Language: en-US,en;q=0.5\r\n"
+	  "Accept-Encoding: gzip, deflate\r\nConnection: keep-alive\r\n\r\n" },
+	{ "GET /uptime",
+	  "GET /uptime HTTP/1.1\r\nHost: 192.168.0.100\r\nUser-Agent: curl/7.47.0\r\nAccept: */*\r\n\r\n" },
+	{ "GET /netinfo",
+	  "GET /netinfo HTTP/1.1\r\nHost: 192.168.0.100\r\nUser-Agent: curl/7.47.0\r\nAccept: */*\r\n\r\n" },
+	{ "GET /netinfo?fields",
+	  "GET /netinfo?fields=ip,dhcp HTTP/1.1\r\nHost: 192.168.0.100\r\nUser-Agent: python-requests/2.9.1\r\nAccept-Encoding: gzip, deflate\r\nAccept: */*\r\nConnection: keep-alive\r\n\r\n" },
+	{ "GET /userio",
+	  "GET /userio HTTP/1.1\r\nHost: 192.168.0.100\r\nUser-Agent: curl/7.47.0\r\nAccept: application/json\r\n\r\n" },
+	{ "GET /userio/a",
+	  "GET /userio/a HTTP/1.1\r\nHost: 192.168.0.100\r\nUser-Agent: curl/7.47.0\r\nAccept: application/json\r\n\r\n" },
+	{ "GET /userio/a/info cbor",
+	  "GET /userio/a/info HTTP/1.1\r\nHost: 192.168.0.100\r\nAccept: application/cbor\r\n\r\n" },
+	{ "PUT /userio/a/info json",
+	  "PUT /userio/a/info HTTP/1.1\r\nHost: 192.168.0.100\r\nUser-Agent: curl/7.47.0\r\nContent-Type: application/json\r\nContent-Length: 39\r\n\r\n"
+	  "{\"type\":\"digital\",\"direction\":\"output\"}" },
+	{ "PUT /userio/a/info cbor",
+	  "PUT /userio/a/info HTTP/1.1\r\nHost: 192.168.0.100\r\nContent-Type: application/cbor\r\nContent-Length: 31\r\n\r\n"
+	  "\xa2\x64type\x67" "digital\x69" "direction\x66output" },
+	{ "OPTIONS /userio/c",
+	  "OPTIONS /userio/c HTTP/1.1\r\nHost: 192.168.0.100\r\nOrigin: http://example.com\r\nAccess-Control-Request-Method: PUT\r\n\r\n" },
+	{ "DELETE /userio/c",
+	  "DELETE /userio/c HTTP/1.1\r\nHost: 192.168.0.100\r\n\r\n" },
+	{ "POST /userio/c",
+	  "POST /userio/c HTTP/1.1\r\nHost: 192.168.0.100\r\nContent-Length: 0\r\n\r\n" },
+	{ "GET /favicon.ico (404)",
+	  "GET /favicon.ico HTTP/1.1\r\nHost: 192.168.0.100\r\nAccept: image/webp,*/*\r\n\r\n" },
+	{ "PATCH /userio (501)",
+	  "PATCH /userio HTTP/1.1\r\nHost: 192.168.0.100\r\n\r\n" },
+	{ NULL, NULL }
+};
+
+/*****************************************************************************
+ * Benchmark runner
+ ****************************************************************************/
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char * argv[])
+{
+	static uint8_t rx[DATA_BUF_SIZE + 1];
+	static st_http_dispatch res;
+	static double ns[sizeof(corpus) / sizeof(corpus[0])];
+	static unsigned long req_copied[sizeof(corpus) / sizeof(corpus[0])];
+	static uint16_t status[sizeof(corpus) / sizeof(corpus[0])];
+	static unsigned long resp_len[sizeof(corpus) / sizeof(corpus[0])];
+	long iterations = (argc > 1) ? atol(argv[1]) : 100000;
+	double start, total_ns = 0;
+	unsigned long total_copied = 0;
+	unsigned len;
+	long i;
+	int c;
+
+	http_dispatch_init();
+
+	// The whole corpus per iteration: the requests leave the I/O state as they found it (PUT / DELETE / POST)
+	for(i = 0; i <= iterations; i++)
+	{
+		for(c = 0; corpus[c].name != NULL; c++)
+		{
+			len = (unsigned)strlen(corpus[c].req);
+			__real_memcpy(rx, corpus[c].req, len);
+
+			copied = 0;
+			start = now_ns();
+			http_dispatch(rx, (uint16_t)len, &res);
+			if(i == 0) // Warm-up: status, bytes copied and response size
+			{
+				status[c] = res.status;
+				req_copied[c] = copied;
+				resp_len[c] = (unsigned long)(strlen(res.header) + res.body_len + res.chunked);
+				continue;
+			}
+			ns[c] += now_ns() - start;
+		}
+	}
+
+	printf("%-26s %6s %10s %8s %8s %8s\n", "request", "status", "ns/op", "req", "copied", "resp");
+	for(c = 0; corpus[c].name != NULL; c++)
+	{
+		ns[c] /= iterations;
+		total_ns += ns[c];
+		total_copied += req_copied[c];
+		printf("%-26s %6u %10.1f %8u %8lu %8lu\n", corpus[c].name, status[c], ns[c], (unsigned)strlen(corpus[c].req), req_copied[c], resp_len[c]);
+	}
+	printf("%-26s %6s %10.1f %8s %8.1f\n", "mean", "", total_ns / c, "", (double)total_copied / c);
+
+	return 0;
+}
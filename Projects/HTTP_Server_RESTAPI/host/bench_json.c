@@ -0,0 +1,189 @@
+/**
+ * @file	bench_json.c
+ * @brief	Host benchmark - JSON response rendering: json_emit() chains vs. jsonWriter
+ *
+ * Renders the '/index' and '/userio' documents the way the REST API handlers did with json_emit()
+ * and the way they do with the jsonWriter, and reports ns/op and the document size.
+ *
+ * Build and run on the host (from Projects/HTTP_Server_RESTAPI):
+ *
+ * gcc -O2 -Isrc/HTTPServer -Isrc/HTTPServer/frozen host/bench_json.c src/HTTPServer/jsonWriter.c src/HTTPServer/frozen/frozen.c -o bench_json
+ * ./bench_json [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "frozen.h"
+#include "jsonWriter.h"
+
+#define DATA_BUF_SIZE		2048
+#define USER_IOn			4
+
+static const char * USER_IO_STR[USER_IOn] = { "a", "b", "c", "d" };
+static const char * USER_IO_PIN_STR[USER_IOn] = { "p30", "p29", "p28", "p27" };
+static const char * USER_IO_TYPE[USER_IOn] = { "digital", "analog", "digital", "digital" };
+static const char * USER_IO_DIR[USER_IOn] = { "output", "input", "input", "input" };
+
+// Built-in resources of RESTapiHandler.c: uri / method list / description
+static const char * resources[][3] =
+{
+	{ "http://192.168.0.100/index",           "GET, HEAD", "index page" },
+	{ "http://192.168.0.100/uptime",          "GET, HEAD", "uptime" },
+	{ "http://192.168.0.100/netinfo",         "GET, HEAD", "network configration" },
+	{ "http://192.168.0.100/userio",          "GET, HEAD", "enabled io list" },
+	{ "http://192.168.0.100/userio/:id",      "GET, HEAD", "get io status or value" },
+	{ "http://192.168.0.100/userio/:id",      "POST",      "enable new io pin" },
+	{ "http://192.168.0.100/userio/:id",      "PUT",       "set the io status (digital output only)" },
+	{ "http://192.168.0.100/userio/:id",      "DELETE",    "disable the io pin" },
+	{ "http://192.168.0.100/userio/:id/info", "GET, HEAD", "get the io configuration, type and direction" },
+	{ "http://192.168.0.100/userio/:id/info", "PUT",       "set the io configuration, type and direction" },
+	{ NULL, NULL, NULL }
+};
+
+/*****************************************************************************
+ * json_emit() chains (previous handlers)
+ ****************************************************************************/
+static int index_emit(char * buf)
+{
+	int i, len;
+
+	len = json_emit(buf, DATA_BUF_SIZE, "{ s: s,", "target", "wizwiki-7500eco");
+	len += json_emit(buf+len, DATA_BUF_SIZE, "s: [", "io");
+	for(i = 0; i < USER_IOn; i++)
+	{
+		len += json_emit(buf+len, DATA_BUF_SIZE, "{ s: s, s: s },", "id", USER_IO_STR[i], "pin", USER_IO_PIN_STR[i]);
+	}
+	len += json_emit(buf+len-1, DATA_BUF_SIZE, " ], ");
+	len--;
+	len += json_emit(buf+len, DATA_BUF_SIZE, "s: [", "resource");
+	for(i = 0; resources[i][0] != NULL; i++)
+	{
+		len += json_emit(buf+len, DATA_BUF_SIZE, "{ s: s, s: s, s: s },", "uri", resources[i][0], "method", resources[i][1], "description", resources[i][2]);
+	}
+	len += json_emit(buf+len-1, DATA_BUF_SIZE, " ] }");
+	len--;
+
+	return len;
+}
+
+static int userio_emit(char * buf)
+{
+	int i, len;
+
+	len = json_emit(buf, DATA_BUF_SIZE, "{ s: [", "userio");
+	for(i = 0; i < USER_IOn; i++)
+	{
+		len += json_emit(buf+len, DATA_BUF_SIZE, "{ s: s, s: s, s: s },", "id", USER_IO_STR[i], "type", USER_IO_TYPE[i], "direction", USER_IO_DIR[i]);
+	}
+	len += json_emit(buf+len-1, DATA_BUF_SIZE, " ] }");
+	len--;
+
+	return len;
+}
+
+/*****************************************************************************
+ * jsonWriter (current handlers)
+ ****************************************************************************/
+static int index_writer(char * buf)
+{
+	st_json_writer w;
+	int i;
+
+	json_writer_init(&w, buf, DATA_BUF_SIZE, NULL, NULL);
+	json_begin_object(&w);
+	json_key(&w, "target");
+	json_str(&w, "wizwiki-7500eco");
+	json_key(&w, "io");
+	json_begin_array(&w);
+	for(i = 0; i < USER_IOn; i++)
+	{
+		json_begin_object(&w);
+		json_key(&w, "id");
+		json_str(&w, USER_IO_STR[i]);
+		json_key(&w, "pin");
+		json_str(&w, USER_IO_PIN_STR[i]);
+		json_end(&w);
+	}
+	json_end(&w);
+	json_key(&w, "resource");
+	json_begin_array(&w);
+	for(i = 0; resources[i][0] != NULL; i++)
+	{
+		json_begin_object(&w);
+		json_key(&w, "uri");
+		json_str(&w, resources[i][0]);
+		json_key(&w, "method");
+		json_str(&w, resources[i][1]);
+		json_key(&w, "description");
+		json_str(&w, resources[i][2]);
+		json_end(&w);
+	}
+	json_end(&w);
+	json_end(&w);
+
+	return json_writer_finish(&w);
+}
+
+static int userio_writer(char * buf)
+{
+	st_json_writer w;
+	int i;
+
+	json_writer_init(&w, buf, DATA_BUF_SIZE, NULL, NULL);
+	json_begin_object(&w);
+	json_key(&w, "userio");
+	json_begin_array(&w);
+	for(i = 0; i < USER_IOn; i++)
+	{
+		json_begin_object(&w);
+		json_key(&w, "id");
+		json_str(&w, USER_IO_STR[i]);
+		json_key(&w, "type");
+		json_str(&w, USER_IO_TYPE[i]);
+		json_key(&w, "direction");
+		json_str(&w, USER_IO_DIR[i]);
+		json_end(&w);
+	}
+	json_end(&w);
+	json_end(&w);
+
+	return json_writer_finish(&w);
+}
+
+/*****************************************************************************
+ * Benchmark runner
+ ****************************************************************************/
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void run(const char * name, int (*render)(char *), long iterations)
+{
+	static char buf[DATA_BUF_SIZE];
+	volatile int len = 0;
+	double start;
+	long i;
+
+	start = now_ns();
+	for(i = 0; i < iterations; i++) len = render(buf);
+
+	printf("%-16s %10.1f ns/op %6d bytes\n", name, (now_ns() - start) / iterations, len);
+}
+
+int main(int argc, char * argv[])
+{
+	long iterations = (argc > 1) ? atol(argv[1]) : 200000;
+
+	run("index/json_emit", index_emit, iterations);
+	run("index/writer", index_writer, iterations);
+	run("userio/json_emit", userio_emit, iterations);
+	run("userio/writer", userio_writer, iterations);
+
+	return 0;
+}
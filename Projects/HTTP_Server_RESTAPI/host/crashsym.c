@@ -0,0 +1,226 @@
+/**
+ * @file	crashsym.c
+ * @brief	Host tool - Symboliser of the HardFault capture (src/PlatformHandler/crashHandler.h) against the firmware image
+ *
+ * Reads the JSON of GET /diag/crash and the ELF image of the build (the .axf of uVision, with its debug symbols);
+ * prints the registers, PC and LR as function+offset, the task and the HTTP socket at the fault, and the trace records
+ * of the capture as a 'TRACE:' hex line for tracedump.
+ *
+ *   curl -s http://192.168.0.100/diag/crash | ./crashsym ../obj/W7500x_App_HTTP_Server_RESTAPI.axf
+ *   ./crashsym ../obj/W7500x_App_HTTP_Server_RESTAPI.axf crash.json | ./tracedump
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ELF_SHT_SYMTAB	2
+#define ELF_STT_FUNC	2
+
+typedef struct
+{
+	uint64_t addr;
+	uint64_t size;
+	const char * name;
+} st_symbol;
+
+static st_symbol * symbols;
+static size_t symbol_cnt;
+
+static const char * const state_names[] = { "IDLE", "REQ_INPROC", "REQ_DONE", "RES_INPROC", "RES_DONE" };	// STATE_HTTP_xxx
+
+static uint8_t * read_file(const char * path, FILE * in, size_t * len)
+{
+	uint8_t * buf = NULL;
+	size_t cap = 0, n;
+
+	*len = 0;
+	if((path != NULL) && ((in = fopen(path, "rb")) == NULL))
+	{
+		perror(path);
+		return NULL;
+	}
+
+	do
+	{
+		if(*len == cap)
+		{
+			cap = cap ? cap * 2 : 65536;
+			if((buf = realloc(buf, cap + 1)) == NULL) return NULL;
+		}
+		n = fread(buf + *len, 1, cap - *len, in);
+		*len += n;
+	} while(n > 0);
+	buf[*len] = '\0';
+
+	if(path != NULL) fclose(in);
+
+	return buf;
+}
+
+// Little-endian fields of the ELF image; 0 beyond its end
+static uint64_t get(const uint8_t * elf, size_t len, uint64_t off, int size)
+{
+	uint64_t val = 0;
+	int i;
+
+	if(off + size > len) return 0;
+	for(i = size - 1; i >= 0; i--) val = (val << 8) | elf[off + i];
+
+	return val;
+}
+
+// FUNC symbols of the .symtab sections (ELF32: armlink, ELF64: host builds); returns -1 if not an ELF image
+static int load_symbols(const uint8_t * elf, size_t len)
+{
+	int is64, w;
+	uint64_t shoff, sh, symoff, symsize, entsize, stroff, sym, name, i, j;
+	uint16_t shentsize, shnum;
+
+	if((len < 52) || memcmp(elf, "\177ELF", 4) || (elf[5] != 1)) return -1; // Little-endian only
+	is64 = (elf[4] == 2);
+	w = is64 ? 8 : 4;
+
+	shoff = get(elf, len, is64 ? 0x28 : 0x20, w);
+	shentsize = (uint16_t)get(elf, len, is64 ? 0x3A : 0x2E, 2);
+	shnum = (uint16_t)get(elf, len, is64 ? 0x3C : 0x30, 2);
+
+	for(i = 0; i < shnum; i++)
+	{
+		sh = shoff + i * shentsize;
+		if(get(elf, len, sh + 4, 4) != ELF_SHT_SYMTAB) continue;
+
+		symoff = get(elf, len, sh + (is64 ? 0x18 : 0x10), w);
+		symsize = get(elf, len, sh + (is64 ? 0x20 : 0x14), w);
+		entsize = get(elf, len, sh + (is64 ? 0x38 : 0x24), w);
+		// String table: the section of sh_link
+		stroff = get(elf, len, shoff + get(elf, len, sh + (is64 ? 0x28 : 0x18), 4) * shentsize + (is64 ? 0x18 : 0x10), w);
+		if((entsize == 0) || (symoff + symsize > len)) continue;
+
+		if((symbols = realloc(symbols, (symbol_cnt + symsize / entsize) * sizeof(st_symbol))) == NULL) return -1;
+		for(j = 0; j < symsize / entsize; j++)
+		{
+			sym = symoff + j * entsize;
+			if((elf[sym + (is64 ? 4 : 12)] & 0x0F) != ELF_STT_FUNC) continue;
+
+			name = stroff + get(elf, len, sym, 4);
+			if(name >= len) continue;
+			symbols[symbol_cnt].name = (const char *)elf + name;
+			symbols[symbol_cnt].addr = get(elf, len, sym + (is64 ? 8 : 4), w) & ~(uint64_t)1; // Thumb bit
+			symbols[symbol_cnt].size = get(elf, len, sym + (is64 ? 16 : 8), w);
+			symbol_cnt++;
+		}
+	}
+
+	return 0;
+}
+
+// Function containing the address; the closest one below it if the sizes are missing
+static void print_symbol(uint32_t addr)
+{
+	const st_symbol * best = NULL;
+	size_t i;
+
+	addr &= ~1u;
+	for(i = 0; i < symbol_cnt; i++)
+	{
+		if(symbols[i].addr > addr) continue;
+		if(symbols[i].size && (addr >= symbols[i].addr + symbols[i].size)) continue;
+		if((best == NULL) || (symbols[i].addr > best->addr)) best = &symbols[i];
+	}
+
+	if(best != NULL) printf("%s+0x%x", best->name, (unsigned)(addr - best->addr));
+	else printf("?");
+}
+
+// "key": "0x...", or "key": 123; returns 0 if missing or null
+static int json_field(const char * json, const char * key, char * val, size_t size)
+{
+	char pattern[32];
+	const char * p;
+	size_t n = 0;
+
+	snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+	if((p = strstr(json, pattern)) == NULL) return 0;
+	p += strlen(pattern);
+	while((*p == ' ') || (*p == ':')) p++;
+	if(*p == '"') p++;
+	if(!strncmp(p, "null", 4)) return 0;
+
+	while(*p && (*p != '"') && (*p != ',') && (*p != '}') && (n < size - 1)) val[n++] = *p++;
+	val[n] = '\0';
+
+	return 1;
+}
+
+static uint32_t json_u32(const char * json, const char * key)
+{
+	char val[16];
+
+	return json_field(json, key, val, sizeof(val)) ? (uint32_t)strtoul(val, NULL, 0) : 0;
+}
+
+int main(int argc, char * argv[])
+{
+	static const char * const regs[] = { "r0", "r1", "r2", "r3", "r12", "sp", "xpsr", "exc_return" };
+	uint8_t * elf;
+	char * json;
+	char * trace;
+	char val[16];
+	size_t elf_len, json_len, i;
+	uint32_t pc, lr, state;
+
+	if((argc < 2) || (argc > 3))
+	{
+		fprintf(stderr, "usage: %s image.axf [crash.json]     (stdin by default)\n", argv[0]);
+		return 2;
+	}
+	if((elf = read_file(argv[1], NULL, &elf_len)) == NULL) return 1;
+	if(load_symbols(elf, elf_len) < 0)
+	{
+		fprintf(stderr, "crashsym: %s: not a little-endian ELF image\n", argv[1]);
+		return 1;
+	}
+	if((json = (char *)read_file((argc == 3) ? argv[2] : NULL, stdin, &json_len)) == NULL) return 1;
+
+	if((strstr(json, "\"crash\"") == NULL) || !json_field(json, "pc", val, sizeof(val)))
+	{
+		printf("no HardFault capture\n");
+		return 0;
+	}
+
+	pc = json_u32(json, "pc");
+	lr = json_u32(json, "lr");
+	printf("HardFault at uptime %u ms\n", json_u32(json, "uptime_ms"));
+	printf("  pc          0x%08X  ", pc);
+	print_symbol(pc);
+	printf("\n  lr          0x%08X  ", lr);
+	print_symbol(lr);
+	printf("\n");
+	for(i = 0; i < sizeof(regs) / sizeof(regs[0]); i++) printf("  %-10s  0x%08X\n", regs[i], json_u32(json, regs[i]));
+
+	printf("task          %s\n", json_field(json, "task", val, sizeof(val)) ? val : "-");
+	if(json_field(json, "socket", val, sizeof(val)))
+	{
+		state = json_u32(json, "http_state");
+		printf("HTTP socket   %s, %s\n", val, (state < sizeof(state_names) / sizeof(state_names[0])) ? state_names[state] : "?");
+	}
+	else printf("HTTP socket   -\n");
+	printf("stack free    main %u, isr %u bytes (never used since the boot)\n", json_u32(json, "stack_free"), json_u32(json, "isr_stack_free"));
+
+	// Trace records of the capture: for tracedump
+	if((trace = strstr(json, "\"trace\"")) != NULL)
+	{
+		trace = strchr(trace + 7, '"');
+		if(trace != NULL)
+		{
+			trace++;
+			printf("TRACE:");
+			while(*trace && (*trace != '"')) putchar(*trace++);
+			printf("\n");
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file	fuzz_driver.c
+ * @brief	Standalone driver of the fuzz targets (GCC, AFL, crash replay): runs LLVMFuzzerTestOneInput() on files or stdin
+ *
+ * fuzz_xxx [-n runs] [-s seed] [file ...]
+ *  - Each file (stdin if none) is run once; AFL: afl-fuzz -i fuzz/corpus/http -o out -- ./fuzz_parser
+ *  - -n: after the files, runs random mutations of them (byte flips, inserts, deletes, splices of HTTP / JSON tokens)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_MAX_INPUT		4096
+#define FUZZ_MAX_FILES		64
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size);
+
+static const char * const dict[] =
+{
+	"\r\n", "\r\n\r\n", " HTTP/1.1", "GET ", "PUT ", "POST ", "OPTIONS ", "/userio/a", "/info", "?fields=", "%2", "&", "=",
+	"Content-Length: ", "Content-Type: application/json", "Content-Type: application/cbor", "Accept: application/cbor",
+	"{", "}", "[", "]", "\"", ":", ",", "\\u00", "\"type\"", "\"digital\"", "true", "-", "1e9", "\xbf", "\xff", "\x7f", "\x1b",
+	NULL
+};
+
+static uint8_t inputs[FUZZ_MAX_FILES][FUZZ_MAX_INPUT];
+static size_t input_len[FUZZ_MAX_FILES];
+
+static size_t read_input(FILE * fp, uint8_t * buf)
+{
+	return fread(buf, 1, FUZZ_MAX_INPUT, fp);
+}
+
+static size_t mutate(uint8_t * buf, size_t len)
+{
+	size_t pos, n;
+	const char * tok;
+	int k, count = 1 + rand() % 4;
+
+	for(k = 0; k < count; k++)
+	{
+		pos = len ? (size_t)rand() % len : 0;
+		switch(rand() % 5)
+		{
+			case 0: // Flip a bit
+				if(len) buf[pos] ^= (uint8_t)(1 << (rand() % 8));
+				break;
+			case 1: // Random byte
+				if(len) buf[pos] = (uint8_t)rand();
+				break;
+			case 2: // Delete a run
+				n = 1 + rand() % 8;
+				if(pos + n > len) n = len - pos;
+				memmove(buf + pos, buf + pos + n, len - pos - n);
+				len -= n;
+				break;
+			case 3: // Insert a token
+				tok = dict[rand() % (sizeof(dict) / sizeof(dict[0]) - 1)];
+				n = strlen(tok);
+				if(len + n > FUZZ_MAX_INPUT) break;
+				memmove(buf + pos + n, buf + pos, len - pos);
+				memcpy(buf + pos, tok, n);
+				len += n;
+				break;
+			default: // Duplicate a run
+				n = 1 + rand() % 32;
+				if(pos + n > len) n = len - pos;
+				if(len + n > FUZZ_MAX_INPUT) break;
+				memmove(buf + pos + n, buf + pos, len - pos);
+				len += n;
+				break;
+		}
+	}
+	return len;
+}
+
+int main(int argc, char * argv[])
+{
+	static uint8_t buf[FUZZ_MAX_INPUT];
+	long runs = 0, i;
+	int files = 0;
+	FILE * fp;
+	size_t len;
+	int a;
+
+	srand(1);
+	for(a = 1; a < argc; a++)
+	{
+		if(!strcmp(argv[a], "-n") && (a + 1 < argc)) runs = atol(argv[++a]);
+		else if(!strcmp(argv[a], "-s") && (a + 1 < argc)) srand((unsigned)atol(argv[++a]));
+		else if(files < FUZZ_MAX_FILES)
+		{
+			if((fp = fopen(argv[a], "rb")) == NULL)
+			{
+				perror(argv[a]);
+				return 1;
+			}
+			input_len[files] = read_input(fp, inputs[files]);
+			fclose(fp);
+			LLVMFuzzerTestOneInput(inputs[files], input_len[files]);
+			files++;
+		}
+	}
+
+	if(files == 0)
+	{
+		input_len[0] = read_input(stdin, inputs[0]);
+		LLVMFuzzerTestOneInput(inputs[0], input_len[0]);
+		files = 1;
+	}
+
+	for(i = 0; i < runs; i++)
+	{
+		a = rand() % files;
+		memcpy(buf, inputs[a], input_len[a]);
+		len = mutate(buf, input_len[a]);
+		LLVMFuzzerTestOneInput(buf, len);
+	}
+
+	printf("%d inputs, %ld mutations: OK\n", files, runs);
+	return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file	fuzz_json.c
+ * @brief	Fuzz target - Request body decoders: frozen tokenizer (token pool), json_decode() and cbor_decode() with a schema of every field type
+ *
+ * libFuzzer / AFL entry point; see host/Makefile.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frozen.h"
+#include "jsonDecoder.h"
+
+#define FUZZ_JSON_TOKENS		16		// MAX_HTTP_JSON_TOKENS
+
+struct st_fuzz_obj
+{
+	int32_t i;
+	uint8_t u;
+	uint8_t b;
+	char    s[9];
+	uint8_t e;
+};
+
+static const char * const fuzz_names[] = { "digital", "analog", "input", "output", NULL };
+
+static const struct st_json_field fuzz_schema[] =
+{
+	{ "i",    JSON_FIELD_INT,   offsetof(struct st_fuzz_obj, i), -100000, 100000, NULL },
+	{ "u",    JSON_FIELD_UINT8, offsetof(struct st_fuzz_obj, u), 0, 200, NULL },
+	{ "b",    JSON_FIELD_BOOL,  offsetof(struct st_fuzz_obj, b), 0, 0, NULL },
+	{ "s",    JSON_FIELD_STR,   offsetof(struct st_fuzz_obj, s), 0, 8, NULL },
+	{ "type", JSON_FIELD_ENUM,  offsetof(struct st_fuzz_obj, e), 0, 0, fuzz_names },
+	{ NULL, 0, 0, 0, 0, NULL }
+};
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+	struct json_token tokens[FUZZ_JSON_TOKENS];
+	struct st_fuzz_obj obj;
+	st_json_decode_result res;
+	uint8_t * buf;
+	int num = 0;
+
+	// Exact-size copy, not terminated: the decoders have to stay within the length
+	if(size > 0xFFFF) size = 0xFFFF;
+	if((buf = malloc(size ? size : 1)) == NULL) return 0;
+	memcpy(buf, data, size);
+
+	if(parse_json_arena((const char *)buf, (int)size, tokens, FUZZ_JSON_TOKENS, &num) > 0)
+	{
+		find_json_token(tokens, "type");
+		find_json_token(tokens, "a.b[1]");
+	}
+
+	memset(&obj, 0, sizeof(obj));
+	json_decode((const char *)buf, (uint16_t)size, fuzz_schema, &obj, &res);
+
+	memset(&obj, 0, sizeof(obj));
+	cbor_decode(buf, (uint16_t)size, fuzz_schema, &obj, &res);
+
+	free(buf);
+	return 0;
+}
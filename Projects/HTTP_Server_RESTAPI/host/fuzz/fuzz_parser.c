@@ -0,0 +1,43 @@
+/**
+ * @file	fuzz_parser.c
+ * @brief	Fuzz target - HTTP request parser: parse_http_request(), URI name / type, query parameters, response header
+ *
+ * libFuzzer / AFL entry point; see host/Makefile.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "httpParser_rest.h"
+#include "httpArena.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+	static st_http_request req;
+	static char header[DATA_BUF_SIZE];
+	uint8_t uri_buf[MAX_URI_SIZE];
+	char value[32];
+	uint8_t * buf;
+
+	// The server receives up to DATA_BUF_SIZE bytes and terminates them; an exact-size copy lets ASan see over-reads
+	if(size > DATA_BUF_SIZE) size = DATA_BUF_SIZE;
+	if((buf = malloc(size + 1)) == NULL) return 0;
+	memcpy(buf, data, size);
+	buf[size] = '\0';
+
+	http_arena_reset();
+	parse_http_request(&req, buf, (uint16_t)size);
+	if((req.METHOD != HTTP_REQ_METHOD_ERR) && (req.URI != NULL))
+	{
+		memset(uri_buf, 0, sizeof(uri_buf));
+		get_http_uri_name(req.URI, uri_buf);
+		find_http_uri_type(&req.TYPE, uri_buf);
+		get_http_param_value("fields", value, sizeof(value));
+		make_http_response_header(header, req.TYPE, req.BODY_LEN, HTTP_RES_CODE_OK, NULL, HTTP_CACHE_DEFAULT);
+	}
+
+	free(buf);
+	return 0;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file	fuzz_router.c
+ * @brief	Fuzz target - Whole request path: parser, resource router, REST API handlers, error messages and response header
+ *
+ * libFuzzer / AFL entry point; see host/Makefile. The handlers change the stub I/O state, so the inputs are not independent.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_dispatch.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+	static st_http_dispatch res;
+	static uint8_t init;
+	uint8_t * buf;
+
+	if(!init)
+	{
+		http_dispatch_init();
+		init = 1;
+	}
+
+	if(size > DATA_BUF_SIZE) size = DATA_BUF_SIZE;
+	if((buf = malloc(size + 1)) == NULL) return 0;
+	memcpy(buf, data, size);
+
+	http_dispatch(buf, (uint16_t)size, &res);
+
+	free(buf);
+	return 0;
+}
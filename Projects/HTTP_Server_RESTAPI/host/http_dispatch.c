@@ -0,0 +1,137 @@
+/**
+ * @file	http_dispatch.c
+ * @brief	Host build - One HTTP request through the parser, the router and the REST API handlers, without sockets
+ *
+ * Follows http_process_handler() of httpServer_rest.c: URI name and type, resource search, OPTIONS / 404 / 405,
+ * the handler call (resumed until it returns) with the chunked flush, the status mapping, error messages and the response header.
+ */
+
+#include <string.h>
+
+#include "ConfigData.h"
+#include "httpParser_rest.h"
+#include "httpArena.h"
+#include "httpServer_rest.h"
+#include "RESTapiHandler.h"
+#include "http_dispatch.h"
+
+static st_http_pt http_pt;
+
+// Chunks flushed by the response writer are counted and dropped
+static int16_t http_dispatch_flush(void * ctx, const char * buf, uint16_t len)
+{
+	(void)buf;
+	((st_http_dispatch *)ctx)->chunked += len;
+
+	return len;
+}
+
+void http_dispatch_init(void)
+{
+	set_DevConfig_to_factory_value();
+	RESTapi_init();
+	build_http_resources();
+}
+
+uint16_t http_dispatch(uint8_t * req, uint16_t len, st_http_dispatch * res)
+{
+	st_http_request * http_req;
+	uint8_t * uri_buf = NULL;
+	uint16_t status = 0;
+	uint16_t content_type, rest_type;
+	int32_t content_len = 0;
+	int8_t table_num;
+	uint8_t allow_methods = 0;
+	const char * allow = NULL;
+	uint16_t cache = HTTP_CACHE_DEFAULT;
+	const struct st_http_resource * resource;
+
+	res->body_len = 0;
+	res->chunked = 0;
+
+	req[len] = '\0';
+	// Request arena: the parsed request, its URI and the temporaries of the router and the handler
+	http_arena_reset();
+	http_req = (st_http_request *)http_arena_alloc(sizeof(st_http_request));
+	parse_http_request(http_req, req, len);
+	if(http_req->URI != NULL) uri_buf = (uint8_t *)http_arena_alloc(strlen((char *)http_req->URI) + sizeof(INITIAL_RESOURCE));
+	if(uri_buf == NULL) http_req->METHOD = HTTP_REQ_METHOD_ERR;
+	rest_type = (http_req->ACCEPT == HTTP_RES_TYPE_CBOR) ? HTTP_RES_TYPE_CBOR : HTTP_RES_TYPE_JSON;
+	content_type = rest_type;
+
+	if(http_req->METHOD == HTTP_REQ_METHOD_ERR)
+	{
+		status = HTTP_RES_CODE_NOT_IMPLE;
+	}
+	else
+	{
+		get_http_uri_name(http_req->URI, uri_buf);
+		if((http_req->METHOD & (HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD | HTTP_REQ_METHOD_OPTIONS)) && !strcmp((char *)uri_buf, "/")) strcpy((char *)uri_buf, INITIAL_RESOURCE);
+		find_http_uri_type(&http_req->TYPE, uri_buf);
+
+		if(http_req->TYPE != 0)
+		{
+			status = HTTP_RES_CODE_NOT_FOUND;
+		}
+		else
+		{
+			table_num = search_http_resources(http_req->METHOD, uri_buf, &allow_methods, &allow);
+
+			if(http_req->METHOD == HTTP_REQ_METHOD_OPTIONS)
+			{
+				status = allow_methods ? HTTP_RES_CODE_NO_CONTENT : HTTP_RES_CODE_NOT_FOUND;
+			}
+			else if(table_num < 0)
+			{
+				status = (table_num == RESTAPI_ERROR_METHOD_NOT_ALLOWED) ? HTTP_RES_CODE_NOT_ALLOWED : HTTP_RES_CODE_NOT_FOUND;
+			}
+			else if((resource = get_http_resource(table_num))->generate != NULL)
+			{
+				uint32_t cursor = 0;
+				int16_t n;
+
+				content_type = resource->content_type ? resource->content_type : HTTP_RES_TYPE_JSON;
+				status = HTTP_RES_CODE_OK;
+				content_len = HTTP_RES_LEN_CHUNKED;
+				cache = resource->cache;
+				while((n = resource->generate(res->body, DATA_BUF_SIZE, &cursor)) > 0) res->chunked += n;
+			}
+			else
+			{
+				content_len = http_resources_handler(http_req, (uint8_t *)res->body, table_num, status, &http_pt, http_dispatch_flush, res);
+				while(content_len == RESTAPI_PENDING) // Resumable handler: resumed at once, no other requests to serve
+					content_len = http_resources_resume((uint8_t *)res->body, table_num, &http_pt, http_dispatch_flush, res);
+
+				if(res->chunked)
+				{
+					status = HTTP_RES_CODE_OK;
+					cache = resource->cache;
+					if(resource->content_type) content_type = resource->content_type;
+					res->body_len = (content_len > 0) ? content_len : 0;
+					content_len = HTTP_RES_LEN_CHUNKED;
+				}
+				else if(content_len == 1) { status = HTTP_RES_CODE_CREATED; content_len = 0; }
+				else if(content_len > 0) { status = HTTP_RES_CODE_OK; cache = resource->cache; if(resource->content_type) content_type = resource->content_type; }
+				else if(content_len == 0) status = HTTP_RES_CODE_NO_CONTENT;
+				else if(content_len == RESTAPI_ERROR_CONFLICT) status = HTTP_RES_CODE_CONFLICT;
+				else if(content_len == RESTAPI_ERROR_BAD_REQUEST) status = HTTP_RES_CODE_BAD_REQUEST;
+				else if(content_len == RESTAPI_ERROR_OVERFLOW) status = HTTP_RES_CODE_INT_SERVER;
+				else if(content_len == RESTAPI_ERROR_TOO_LARGE) status = HTTP_RES_CODE_TOO_LARGE;
+				else status = HTTP_RES_CODE_NOT_FOUND;
+			}
+		}
+	}
+
+	if(status >= HTTP_RES_CODE_BAD_REQUEST)
+	{
+		content_len = make_http_response_error_message((uint8_t *)res->body, status, rest_type);
+	}
+
+	if((status != HTTP_RES_CODE_NOT_ALLOWED) && (http_req->METHOD != HTTP_REQ_METHOD_OPTIONS)) allow = NULL;
+	make_http_response_header(res->header, content_type, content_len, status, allow, cache);
+
+	if(content_len != HTTP_RES_LEN_CHUNKED) res->body_len = content_len;
+	res->status = status;
+
+	return status;
+}
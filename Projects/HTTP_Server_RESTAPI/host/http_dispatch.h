@@ -0,0 +1,29 @@
+/**
+ * @file	http_dispatch.h
+ * @brief	Host build - One HTTP request through the parser, the router and the REST API handlers, without sockets
+ */
+
+#ifndef	__HTTP_DISPATCH_H__
+#define	__HTTP_DISPATCH_H__
+
+#include <stdint.h>
+
+#include "common.h"	// DATA_BUF_SIZE
+
+typedef struct _st_http_dispatch
+{
+	char     header[DATA_BUF_SIZE];		// Response header (0-terminated)
+	char     body[DATA_BUF_SIZE];		// Response body in the buffer (the last part if chunked)
+	int32_t  body_len;
+	uint32_t chunked;					// Body bytes flushed in chunks before the handler returned
+	uint16_t status;
+} st_http_dispatch;
+
+// Factory configuration, RESTapi_init() and build_http_resources(), once
+void http_dispatch_init(void);
+
+// Processes the request as http_process_handler() does; 'req' is modified by the parser (DATA_BUF_SIZE + 1 bytes at least).
+// Returns the HTTP status code.
+uint16_t http_dispatch(uint8_t * req, uint16_t len, st_http_dispatch * res);
+
+#endif
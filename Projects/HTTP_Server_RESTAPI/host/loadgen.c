@@ -0,0 +1,649 @@
+/**
+ * @file	loadgen.c
+ * @brief	Host benchmark - HTTP load generator: route mix, concurrency and connection reuse; throughput, latency
+ *			percentiles, errors and bytes per request as JSON
+ *
+ * Each worker thread sends the requests of the route mix (picked by weight, seeded: the same sequence for the same
+ * seed) over its own connection, one request at a time. A new connection is opened for each request, or with -k
+ * the connection is kept until the server closes it (the firmware closes it after each response: -k then shows
+ * the cost of the 'Connection: close' model). The latency of a request runs from the connect (or the send on a
+ * reused connection) to the last byte of the response.
+ *
+ *   ./loadgen [options] [host[:port]]        default 127.0.0.1:8080 (host/http_server)
+ *     -c N       concurrent connections (default 4)
+ *     -n N       requests in total (default 10000), or
+ *     -d SEC     duration in seconds
+ *     -k         keep the connection for the next request while the server keeps it open
+ *     -m FILE    route mix: one route per line, 'weight METHOD path [body]' ('#' comment); the default is the API mix
+ *     -s SEED    seed of the route selection (default 1)
+ *     -t MSEC    connect / receive timeout (default 5000)
+ *
+ * Output (stdout, one JSON object): totals, status codes, errors by kind, latency in microseconds
+ * (mean, p50, p99, p999, max), bytes per request and the same per route.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#define MAX_ROUTES			32
+#define MAX_REQUEST			2048
+#define MAX_RESPONSE		16384
+#define MAX_STATUS			600
+
+enum { ERR_CONNECT, ERR_SEND, ERR_RECV, ERR_TIMEOUT, ERR_PARSE, ERR_KINDS };
+static const char * err_names[ERR_KINDS] = { "connect", "send", "recv", "timeout", "parse" };
+
+typedef struct
+{
+	char     name[160];				// 'METHOD path'
+	char     req[2][MAX_REQUEST];	// Request: [0] Connection: close, [1] Connection: keep-alive
+	int      req_len[2];
+	uint32_t weight;
+	int      head;					// No response body
+} st_route;
+
+typedef struct
+{
+	uint32_t * us;					// Latency of each completed request
+	uint8_t  * route;
+	size_t   count, size;
+	uint64_t status[MAX_STATUS];
+	uint64_t errors[ERR_KINDS];
+	uint64_t route_errors[MAX_ROUTES];
+	uint64_t tx, rx;
+	uint64_t connects;
+	uint32_t seed;
+	pthread_t thread;
+} st_worker;
+
+// Default mix: the uri_table routes of RESTapiHandler.c, their error paths and the PUT / POST / DELETE of user I/O
+static const char * default_mix[] =
+{
+	"30 GET /uptime",
+	"10 GET /netinfo",
+	"10 GET /userio",
+	"15 GET /userio/a",
+	"5 GET /userio/b/info",
+	"3 GET /",
+	"5 PUT /userio/d/info {\"type\":\"digital\",\"direction\":\"output\"}",
+	"5 PUT /userio/d {\"d\":1}",
+	"3 DELETE /userio/c",
+	"3 POST /userio/c",
+	"5 GET /favicon.ico",
+	"3 PUT /uptime",
+	"3 PATCH /userio",
+	NULL
+};
+
+static st_route routes[MAX_ROUTES];
+static int route_cnt;
+static uint32_t weight_sum;
+
+static struct sockaddr_storage target;
+static socklen_t target_len;
+static char target_host[128] = "127.0.0.1";
+static char target_port[16] = "8080";
+
+static int keepalive;
+static int timeout_msec = 5000;
+static long total_requests = 10000;
+static double duration;
+static volatile long issued;
+static volatile int stop;
+
+/*****************************************************************************
+ * Route mix
+ ****************************************************************************/
+static int add_route(const char * line)
+{
+	st_route * r;
+	char method[16], path[128];
+	const char * body = NULL;
+	unsigned weight;
+	int pos = 0, body_len, k;
+
+	while((*line == ' ') || (*line == '\t')) line++;
+	if((*line == '#') || (*line == '\0') || (*line == '\n') || (*line == '\r')) return 0;
+	if(sscanf(line, "%u %15s %127s %n", &weight, method, path, &pos) < 3) return -1;
+	if(route_cnt >= MAX_ROUTES) return -1;
+
+	if(line[pos] != '\0') body = line + pos;
+	body_len = body ? (int)strcspn(body, "\r\n") : 0;
+
+	r = &routes[route_cnt++];
+	snprintf(r->name, sizeof(r->name), "%s %s", method, path);
+	r->weight = weight;
+	r->head = !strcmp(method, "HEAD");
+	weight_sum += weight;
+
+	for(k = 0; k < 2; k++)
+	{
+		r->req_len[k] = snprintf(r->req[k], MAX_REQUEST, "%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: loadgen\r\nAccept: application/json\r\nConnection: %s\r\n",
+			method, path, target_host, k ? "keep-alive" : "close");
+		if(body_len)
+		{
+			r->req_len[k] += snprintf(r->req[k] + r->req_len[k], MAX_REQUEST - r->req_len[k], "Content-Type: application/json\r\nContent-Length: %d\r\n\r\n%.*s", body_len, body_len, body);
+		}
+		else
+		{
+			r->req_len[k] += snprintf(r->req[k] + r->req_len[k], MAX_REQUEST - r->req_len[k], "%s\r\n", strcmp(method, "POST") ? "" : "Content-Length: 0\r\n");
+		}
+		if(r->req_len[k] >= MAX_REQUEST) return -1;
+	}
+
+	return 1;
+}
+
+static int load_mix(const char * file)
+{
+	char line[1024];
+	FILE * fp;
+	int i, n = 0;
+
+	if(file == NULL)
+	{
+		for(i = 0; default_mix[i] != NULL; i++) add_route(default_mix[i]);
+		return route_cnt;
+	}
+
+	if((fp = fopen(file, "r")) == NULL)
+	{
+		perror(file);
+		return -1;
+	}
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		n++;
+		if(add_route(line) < 0)
+		{
+			fprintf(stderr, "%s:%d: 'weight METHOD path [body]' expected (max. %d routes)\n", file, n, MAX_ROUTES);
+			fclose(fp);
+			return -1;
+		}
+	}
+	fclose(fp);
+
+	return route_cnt;
+}
+
+// xorshift32: the same route sequence for the same seed
+static int pick_route(uint32_t * state)
+{
+	uint32_t x = *state, w;
+	int i;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	w = x % weight_sum;
+	for(i = 0; i < route_cnt - 1; i++)
+	{
+		if(w < routes[i].weight) break;
+		w -= routes[i].weight;
+	}
+
+	return i;
+}
+
+/*****************************************************************************
+ * HTTP client
+ ****************************************************************************/
+static double now_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int open_connection(void)
+{
+	struct timeval tv;
+	int fd, on = 1;
+
+	if((fd = socket(target.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) return -1;
+
+	tv.tv_sec = timeout_msec / 1000;
+	tv.tv_usec = (timeout_msec % 1000) * 1000;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+	if(connect(fd, (struct sockaddr *)&target, target_len) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static int send_all(int fd, const char * buf, int len)
+{
+	ssize_t n;
+	int sent = 0;
+
+	while(sent < len)
+	{
+		n = send(fd, buf + sent, len - sent, MSG_NOSIGNAL);
+		if(n <= 0)
+		{
+			if((n < 0) && (errno == EINTR)) continue;
+			return -1;
+		}
+		sent += (int)n;
+	}
+
+	return sent;
+}
+
+// Header field value (case-insensitive name), NULL if none
+static const char * find_header(const char * hdr, const char * hdr_end, const char * name)
+{
+	size_t len = strlen(name);
+	const char * p = hdr;
+
+	while((p = memchr(p, '\n', hdr_end - p)) != NULL)
+	{
+		p++;
+		if((hdr_end - p > (long)len) && !strncasecmp(p, name, len))
+		{
+			p += len;
+			while((*p == ' ') || (*p == '\t')) p++;
+			return p;
+		}
+	}
+
+	return NULL;
+}
+
+// End of a chunked body from 'body', -1 if not complete, -2 if malformed
+static long chunked_end(const char * body, const char * end)
+{
+	const char * p = body;
+	char * next;
+	long size;
+
+	for(;;)
+	{
+		if(memchr(p, '\n', end - p) == NULL) return -1;
+		size = strtol(p, &next, 16);
+		if((next == p) || (size < 0)) return -2;
+		p = (const char *)memchr(p, '\n', end - p) + 1;
+		if(size == 0)
+		{
+			// Trailer: up to the empty line
+			while((p < end) && (*p != '\r') && (*p != '\n'))
+			{
+				if((p = memchr(p, '\n', end - p)) == NULL) return -1;
+				p++;
+			}
+			if((p < end) && (*p == '\r')) p++;
+			if(p >= end) return -1;
+			return (p + 1) - body;
+		}
+		if(end - p < size + 2) return -1;
+		p += size + 2;
+	}
+}
+
+// Reads one response: returns its status code, or -ERR_xxx - 1; '*conn_close' if the server closes the connection
+static int read_response(int fd, int head, uint64_t * rx, int * conn_close)
+{
+	static __thread char buf[MAX_RESPONSE];
+	const char * hdr_end = NULL;
+	const char * v;
+	long need = -1, body_len = 0, done;
+	int len = 0, status, chunked = 0;
+	ssize_t n;
+
+	*conn_close = 1;
+	for(;;)
+	{
+		if(len == MAX_RESPONSE)
+		{
+			// Large body: only the length matters from here on
+			if((hdr_end == NULL) || chunked) return -ERR_PARSE - 1;
+			len = (int)(hdr_end - buf);
+			body_len += MAX_RESPONSE - len;
+		}
+		n = recv(fd, buf + len, MAX_RESPONSE - len, 0);
+		if(n < 0)
+		{
+			if(errno == EINTR) continue;
+			return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? -ERR_TIMEOUT - 1 : -ERR_RECV - 1;
+		}
+		if(n == 0)
+		{
+			// Closed: complete if the length is not given
+			if((hdr_end != NULL) && (need < 0) && !chunked) break;
+			return -ERR_RECV - 1;
+		}
+		len += (int)n;
+		*rx += n;
+
+		if(hdr_end == NULL)
+		{
+			char * p = memmem(buf, len, "\r\n\r\n", 4);
+			if(p == NULL) continue;
+			hdr_end = p + 4;
+
+			if((sscanf(buf, "HTTP/1.%*d %d", &status) != 1) || (status < 100) || (status >= MAX_STATUS)) return -ERR_PARSE - 1;
+			if(head || (status == 204) || (status == 304)) need = 0;
+			else if(((v = find_header(buf, hdr_end, "Transfer-Encoding:")) != NULL) && !strncasecmp(v, "chunked", 7)) chunked = 1;
+			else if((v = find_header(buf, hdr_end, "Content-Length:")) != NULL) need = atol(v);
+			*conn_close = ((v = find_header(buf, hdr_end, "Connection:")) == NULL) || !strncasecmp(v, "close", 5);
+		}
+
+		if(chunked)
+		{
+			done = chunked_end(hdr_end, buf + len);
+			if(done == -2) return -ERR_PARSE - 1;
+			if(done >= 0) break;
+		}
+		else if((need >= 0) && (body_len + (buf + len - hdr_end) >= need)) break;
+	}
+
+	return status;
+}
+
+/*****************************************************************************
+ * Workers
+ ****************************************************************************/
+static void record(st_worker * w, int route, double us)
+{
+	if(w->count == w->size)
+	{
+		w->size = w->size ? w->size * 2 : 4096;
+		w->us = realloc(w->us, w->size * sizeof(w->us[0]));
+		w->route = realloc(w->route, w->size * sizeof(w->route[0]));
+		if((w->us == NULL) || (w->route == NULL))
+		{
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	w->us[w->count] = (us > 4e9) ? 4000000000u : (uint32_t)us;
+	w->route[w->count++] = (uint8_t)route;
+}
+
+static void * worker(void * arg)
+{
+	st_worker * w = arg;
+	st_route * r;
+	double start;
+	int fd = -1, reused, conn_close, ret, i;
+
+	while(!stop)
+	{
+		if((duration == 0) && (__sync_fetch_and_add(&issued, 1) >= total_requests)) break;
+
+		i = pick_route(&w->seed);
+		r = &routes[i];
+		start = now_sec();
+
+		for(;;)
+		{
+			reused = (fd >= 0);
+			if(fd < 0)
+			{
+				if((fd = open_connection()) < 0)
+				{
+					ret = (errno == EINPROGRESS || errno == EAGAIN || errno == ETIMEDOUT) ? -ERR_TIMEOUT - 1 : -ERR_CONNECT - 1;
+					break;
+				}
+				w->connects++;
+			}
+			if(send_all(fd, r->req[keepalive], r->req_len[keepalive]) < 0)
+			{
+				ret = -ERR_SEND - 1;
+			}
+			else
+			{
+				w->tx += r->req_len[keepalive];
+				ret = read_response(fd, r->head, &w->rx, &conn_close);
+			}
+			if(ret < 0)
+			{
+				close(fd);
+				fd = -1;
+				// The server closed the kept connection meanwhile: again on a new one
+				if(reused && ((ret == -ERR_SEND - 1) || (ret == -ERR_RECV - 1))) continue;
+			}
+			else if(!keepalive || conn_close)
+			{
+				close(fd);
+				fd = -1;
+			}
+			break;
+		}
+
+		if(ret < 0)
+		{
+			w->errors[-ret - 1]++;
+			w->route_errors[i]++;
+		}
+		else
+		{
+			w->status[ret]++;
+			record(w, i, (now_sec() - start) * 1e6);
+		}
+	}
+	if(fd >= 0) close(fd);
+
+	return NULL;
+}
+
+/*****************************************************************************
+ * Report
+ ****************************************************************************/
+static int cmp_u32(const void * a, const void * b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const uint32_t * v, size_t n, double p)
+{
+	size_t i;
+
+	if(n == 0) return 0;
+	i = (size_t)(p * n);
+	if(i >= n) i = n - 1;
+
+	return v[i];
+}
+
+static void print_latency(const uint32_t * v, size_t n)
+{
+	double sum = 0;
+	size_t i;
+
+	for(i = 0; i < n; i++) sum += v[i];
+	printf("{\"mean\": %.1f, \"p50\": %u, \"p99\": %u, \"p999\": %u, \"max\": %u}",
+		n ? sum / n : 0.0, percentile(v, n, 0.50), percentile(v, n, 0.99), percentile(v, n, 0.999), n ? v[n - 1] : 0);
+}
+
+static void print_json_str(const char * s)
+{
+	putchar('"');
+	for(; *s; s++)
+	{
+		if((*s == '"') || (*s == '\\')) putchar('\\');
+		putchar(*s);
+	}
+	putchar('"');
+}
+
+static void report(st_worker * workers, int conc, double elapsed)
+{
+	uint64_t status[MAX_STATUS] = {0}, errors[ERR_KINDS] = {0}, route_errors[MAX_ROUTES] = {0};
+	uint64_t tx = 0, rx = 0, connects = 0, err_total = 0;
+	uint32_t * all, * per_route;
+	size_t count = 0, n, k;
+	int c, i, first;
+
+	for(c = 0; c < conc; c++)
+	{
+		count += workers[c].count;
+		tx += workers[c].tx;
+		rx += workers[c].rx;
+		connects += workers[c].connects;
+		for(i = 0; i < MAX_STATUS; i++) status[i] += workers[c].status[i];
+		for(i = 0; i < ERR_KINDS; i++) { errors[i] += workers[c].errors[i]; err_total += workers[c].errors[i]; }
+		for(i = 0; i < route_cnt; i++) route_errors[i] += workers[c].route_errors[i];
+	}
+
+	all = malloc((count + 1) * sizeof(uint32_t));
+	per_route = malloc((count + 1) * sizeof(uint32_t));
+	if((all == NULL) || (per_route == NULL)) exit(1);
+	for(c = 0, n = 0; c < conc; c++)
+	{
+		memcpy(all + n, workers[c].us, workers[c].count * sizeof(uint32_t));
+		n += workers[c].count;
+	}
+	qsort(all, count, sizeof(uint32_t), cmp_u32);
+
+	printf("{\n  \"target\": \"%s:%s\", \"concurrency\": %d, \"keepalive\": %s, \"elapsed_s\": %.3f,\n",
+		target_host, target_port, conc, keepalive ? "true" : "false", elapsed);
+	printf("  \"requests\": %zu, \"errors\": %llu, \"connections\": %llu, \"throughput_rps\": %.1f,\n",
+		count, (unsigned long long)err_total, (unsigned long long)connects, elapsed > 0 ? count / elapsed : 0.0);
+
+	printf("  \"status\": {");
+	for(i = 0, first = 1; i < MAX_STATUS; i++)
+	{
+		if(status[i] == 0) continue;
+		printf("%s\"%d\": %llu", first ? "" : ", ", i, (unsigned long long)status[i]);
+		first = 0;
+	}
+	printf("},\n  \"error_kinds\": {");
+	for(i = 0; i < ERR_KINDS; i++) printf("%s\"%s\": %llu", i ? ", " : "", err_names[i], (unsigned long long)errors[i]);
+	printf("},\n  \"latency_us\": ");
+	print_latency(all, count);
+	printf(",\n  \"bytes_per_request\": {\"tx\": %.1f, \"rx\": %.1f},\n  \"routes\": [\n",
+		count ? (double)tx / count : 0.0, count ? (double)rx / count : 0.0);
+
+	for(i = 0; i < route_cnt; i++)
+	{
+		for(c = 0, n = 0; c < conc; c++)
+		{
+			for(k = 0; k < workers[c].count; k++) if(workers[c].route[k] == i) per_route[n++] = workers[c].us[k];
+		}
+		qsort(per_route, n, sizeof(uint32_t), cmp_u32);
+		printf("    {\"route\": ");
+		print_json_str(routes[i].name);
+		printf(", \"requests\": %zu, \"errors\": %llu, \"latency_us\": ", n, (unsigned long long)route_errors[i]);
+		print_latency(per_route, n);
+		printf("}%s\n", (i < route_cnt - 1) ? "," : "");
+	}
+	printf("  ]\n}\n");
+
+	free(all);
+	free(per_route);
+}
+
+/*****************************************************************************
+ * Main
+ ****************************************************************************/
+static int resolve_target(const char * arg)
+{
+	struct addrinfo hints, * res;
+	const char * colon = strrchr(arg, ':');
+	size_t len = colon ? (size_t)(colon - arg) : strlen(arg);
+
+	if(len >= sizeof(target_host)) return -1;
+	memcpy(target_host, arg, len);
+	target_host[len] = '\0';
+	if(colon) snprintf(target_port, sizeof(target_port), "%s", colon + 1);
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if(getaddrinfo(target_host, target_port, &hints, &res) != 0) return -1;
+	memcpy(&target, res->ai_addr, res->ai_addrlen);
+	target_len = res->ai_addrlen;
+	freeaddrinfo(res);
+
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	st_worker * workers;
+	const char * mix = NULL;
+	uint32_t seed = 1;
+	double start, elapsed;
+	int conc = 4, opt, c;
+
+	while((opt = getopt(argc, argv, "c:n:d:km:s:t:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'c': conc = atoi(optarg); break;
+			case 'n': total_requests = atol(optarg); break;
+			case 'd': duration = atof(optarg); break;
+			case 'k': keepalive = 1; break;
+			case 'm': mix = optarg; break;
+			case 's': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 't': timeout_msec = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-c conns] [-n requests | -d sec] [-k] [-m mixfile] [-s seed] [-t msec] [host[:port]]\n", argv[0]);
+				return 2;
+		}
+	}
+	if((conc < 1) || (timeout_msec < 1))
+	{
+		fprintf(stderr, "-c and -t must be positive\n");
+		return 2;
+	}
+	if(resolve_target((optind < argc) ? argv[optind] : "127.0.0.1:8080") < 0)
+	{
+		fprintf(stderr, "%s: cannot resolve\n", (optind < argc) ? argv[optind] : "");
+		return 2;
+	}
+	if((load_mix(mix) <= 0) || (weight_sum == 0))
+	{
+		fprintf(stderr, "empty route mix\n");
+		return 2;
+	}
+
+	if((workers = calloc(conc, sizeof(st_worker))) == NULL) return 1;
+
+	start = now_sec();
+	for(c = 0; c < conc; c++)
+	{
+		workers[c].seed = (seed + c) * 2654435761u;
+		if(workers[c].seed == 0) workers[c].seed = 1;
+		if(pthread_create(&workers[c].thread, NULL, worker, &workers[c]) != 0)
+		{
+			perror("pthread_create");
+			return 1;
+		}
+	}
+	if(duration > 0)
+	{
+		usleep((useconds_t)(duration * 1e6));
+		stop = 1;
+	}
+	for(c = 0; c < conc; c++) pthread_join(workers[c].thread, NULL);
+	elapsed = now_sec() - start;
+
+	report(workers, conc, elapsed);
+
+	return 0;
+}
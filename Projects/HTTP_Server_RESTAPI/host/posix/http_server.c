@@ -0,0 +1,103 @@
+/**
+ * @file	http_server.c
+ * @brief	Host build - The REST web server as a Linux process: httpServer_rest.c on the POSIX socket shim
+ *
+ * Follows main() of the firmware: factory configuration, RESTapi_init(), httpServer_init() with the HTTP sockets
+ * {3, 4, 5} and the shared 2KB buffers, then httpServer_run() for each socket in the main loop. The loop sleeps
+ * in poll() while no socket has anything to do. See host/Makefile: make http_server && ./http_server [-p port]
+ *
+ *   -p port      TCP port (default 8080)
+ *   -n count     HTTP sockets, 1 to 8 (default 3, as MAX_HTTPSOCK of main.c)
+ *   -v           printf() debug messages of the server modules to stdout; discarded otherwise
+ *                (log levels: make http_server DEFS+=-DLOG_LEVEL_RESTAPI=4 ..., logHandler.h)
+ *
+ * The trace ring is drained by GET /diag/trace: curl -s http://127.0.0.1:8080/diag/trace | ./tracedump
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "ConfigData.h"
+#include "httpServer_rest.h"
+#include "RESTapiHandler.h"
+#include "httpMetrics.h"
+#include "httpDiag.h"
+#include "traceHandler.h"
+#include "logHandler.h"
+#include "timerHandler.h"
+
+#define MAX_HTTPSOCK		3
+#define HOST_SERVER_PORT	8080		// Default of -p: no root privileges for the port
+
+// Shared buffer declaration: the receive buffer holds the request and its end of string marker
+static uint8_t g_send_buf[DATA_BUF_SIZE];
+static uint8_t g_recv_buf[DATA_BUF_SIZE + 1];
+
+// H/W sockets for the HTTP server: main.c ones first, then the sockets of DHCP / DNS
+static uint8_t sock_list[_WIZCHIP_SOCK_NUM_] = {3, 4, 5, 6, 7, 0, 1, 2};
+
+int main(int argc, char * argv[])
+{
+	uint16_t port = HOST_SERVER_PORT;
+	int sock_cnt = MAX_HTTPSOCK;
+	int verbose = 0;
+	int opt, i;
+	uint8_t sec, sec_last = 0;
+
+	while((opt = getopt(argc, argv, "p:n:v")) != -1)
+	{
+		switch(opt)
+		{
+			case 'p': port = (uint16_t)atoi(optarg); break;
+			case 'n': sock_cnt = atoi(optarg); break;
+			case 'v': verbose = 1; break;
+			default:
+				fprintf(stderr, "usage: %s [-p port] [-n sockets] [-v]\n", argv[0]);
+				return 2;
+		}
+	}
+	if((port == 0) || (sock_cnt < 1) || (sock_cnt > _WIZCHIP_SOCK_NUM_))
+	{
+		fprintf(stderr, "port: 1 to 65535, sockets: 1 to %d\n", _WIZCHIP_SOCK_NUM_);
+		return 2;
+	}
+	if(!verbose && (freopen("/dev/null", "w", stdout) == NULL)) return 1;
+	setvbuf(stdout, NULL, _IOLBF, 0); // As the debug UART: each line when it is printed
+
+	/* Default Configuration settings */
+	set_DevConfig_to_factory_value();
+
+	/* REST API resources: built-in resources */
+	RESTapi_init();
+	http_metrics_init();
+	http_diag_init();
+
+	TRACE_EVENT(TRACE_SOCK_NONE, TRACE_EV_BOOT, 0, 0);
+
+	httpServer_init(g_send_buf, g_recv_buf, (uint8_t)sock_cnt, sock_list);
+
+	fprintf(stderr, "HTTP server: port %u, %d sockets\n", port, sock_cnt);
+
+	while(1) // main loop
+	{
+		for(i = 0; i < sock_cnt; i++) httpServer_run(port);
+
+		http_metrics_loop();
+
+		log_flush(); // Deferred log messages: all of them, the loop may sleep in poll()
+
+		// 1s tick of the firmware's timer interrupt
+		if((sec = getDeviceUptime_sec()) != sec_last)
+		{
+			sec_last = sec;
+			http_metrics_time_handler();
+			httpServer_reap(); // Reaper task of the firmware
+		}
+
+		wiz_posix_idle(100);
+	}
+
+	return 0;
+}
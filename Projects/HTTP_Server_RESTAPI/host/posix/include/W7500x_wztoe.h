@@ -0,0 +1,57 @@
+/**
+ * @file	W7500x_wztoe.h
+ * @brief	Host build - WZTOE register accessors of the HTTP server on the POSIX socket shim (wiz_posix.c)
+ *
+ * Found before the driver header on the include path of the host server build: includes it for the constants
+ * (Sn_MR_xxx, Sn_CR_xxx, Sn_IR_xxx, SOCK_xxx states), then replaces the socket register accessors used by
+ * httpServer_rest.c with the shim functions.
+ */
+
+#ifndef	__WZTOE_POSIX_H
+#define	__WZTOE_POSIX_H
+
+#include_next "W7500x_wztoe.h"
+
+#undef	getSn_SR
+#undef	getSn_IR
+#undef	setSn_IR
+#undef	getSn_CR
+#undef	setSn_CR
+#undef	getSn_RX_RSR
+#undef	getSn_TX_FSR
+#undef	getSn_TxMAX
+#undef	getSn_RxMAX
+#undef	getSn_DIPR
+#undef	getSn_DPORT
+
+#define	getSn_SR(sn)			wiz_getSn_SR(sn)
+#define	getSn_IR(sn)			wiz_getSn_IR(sn)
+#define	setSn_IR(sn, ir)		wiz_setSn_IR(sn, ir)
+#define	getSn_CR(sn)			wiz_getSn_CR(sn)
+#define	setSn_CR(sn, cr)		wiz_setSn_CR(sn, cr)
+#define	getSn_RX_RSR(sn)		wiz_getSn_RX_RSR(sn)
+#define	getSn_TX_FSR(sn)		wiz_getSn_TX_FSR(sn)
+#define	getSn_TxMAX(sn)			WIZ_POSIX_TXBUF_SIZE
+#define	getSn_RxMAX(sn)			WIZ_POSIX_RXBUF_SIZE
+#define	getSn_DIPR(sn, dipr)	wiz_getSn_DIPR(sn, dipr)
+#define	getSn_DPORT(sn)			wiz_getSn_DPORT(sn)
+
+// Socket buffer sizes of the firmware: wizchip_init() with 2KB for each of the 8 sockets (main.c)
+#define	WIZ_POSIX_TXBUF_SIZE	2048
+#define	WIZ_POSIX_RXBUF_SIZE	2048
+
+uint8_t  wiz_getSn_SR(uint8_t sn);
+uint8_t  wiz_getSn_IR(uint8_t sn);
+void     wiz_setSn_IR(uint8_t sn, uint8_t ir);
+uint8_t  wiz_getSn_CR(uint8_t sn);
+void     wiz_setSn_CR(uint8_t sn, uint8_t cr);
+uint16_t wiz_getSn_RX_RSR(uint8_t sn);
+uint16_t wiz_getSn_TX_FSR(uint8_t sn);
+void     wiz_getSn_DIPR(uint8_t sn, uint8_t * dipr);
+uint16_t wiz_getSn_DPORT(uint8_t sn);
+
+// Host main loop: waits up to 'timeout_msec' for a connection, received data or a closed peer when the last
+// pass of httpServer_run() did nothing (no socket call changed a state or moved data). Returns 1 if it waited.
+int wiz_posix_idle(int timeout_msec);
+
+#endif
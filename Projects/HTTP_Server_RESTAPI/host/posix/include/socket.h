@@ -0,0 +1,28 @@
+/**
+ * @file	socket.h
+ * @brief	Host build - ioLibrary socket API of the HTTP server on the POSIX socket shim (wiz_posix.c)
+ *
+ * The ioLibrary names (socket, listen, send, recv, close, ...) are the names of the C library socket calls:
+ * they are renamed to wiz_xxx before the ioLibrary header is included, so its declarations and the calls of
+ * httpServer_rest.c both refer to the shim.
+ */
+
+#ifndef	__SOCKET_POSIX_H
+#define	__SOCKET_POSIX_H
+
+#define	socket			wiz_socket
+#define	close			wiz_close
+#define	listen			wiz_listen
+#define	connect			wiz_connect
+#define	disconnect		wiz_disconnect
+#define	send			wiz_send
+#define	recv			wiz_recv
+#define	sendto			wiz_sendto
+#define	recvfrom		wiz_recvfrom
+#define	ctlsocket		wiz_ctlsocket
+#define	setsockopt		wiz_setsockopt
+#define	getsockopt		wiz_getsockopt
+
+#include_next "socket.h"
+
+#endif
@@ -0,0 +1,427 @@
+/**
+ * @file	wiz_posix.c
+ * @brief	Host build - WIZnet TCP socket semantics (ioLibrary socket API and socket registers) on Linux sockets
+ *
+ * Each of the 8 hardware sockets follows the Sn_SR states of the W7500 TCP/IP core as httpServer_run() sees them:
+ * socket() opens it (SOCK_INIT), listen() puts it in SOCK_LISTEN, a connection accepted on the port makes it
+ * SOCK_ESTABLISHED with Sn_IR_CON, a FIN of the peer makes it SOCK_CLOSE_WAIT and Sn_CR_DISCON / close() make it
+ * SOCK_CLOSED. Several sockets listening on the same port share one listening socket; every hardware socket holds
+ * one connection at a time.
+ *
+ * Buffer sizes are the firmware ones (2KB per socket): Sn_RX_RSR reports at most 2KB of the received data,
+ * send() sends at most 2KB and Sn_TX_FSR is 2KB minus the data not acknowledged by the peer yet.
+ *
+ * Differences: connections beyond the listening sockets wait in the kernel backlog, where the TCP/IP core
+ * resets them; Sn_CR_DISCON closes the socket at once, the kernel completes the FIN handshake.
+ */
+
+#define _GNU_SOURCE // accept4()
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <linux/sockios.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include "socket.h"
+#include "W7500x_wztoe.h"
+
+// Shim implementation: the C library socket calls from here on
+#undef	socket
+#undef	close
+#undef	listen
+#undef	connect
+#undef	send
+#undef	recv
+#undef	sendto
+#undef	recvfrom
+#undef	setsockopt
+#undef	getsockopt
+
+#define WIZ_POSIX_BACKLOG		16
+
+typedef struct
+{
+	int      fd;			// Connection (SOCK_ESTABLISHED / SOCK_CLOSE_WAIT), -1 otherwise
+	uint8_t  sr;			// Sn_SR
+	uint8_t  ir;			// Sn_IR
+	uint16_t port;			// Sn_PORT
+	struct sockaddr_in peer;
+} st_wiz_socket;
+
+typedef struct
+{
+	int      fd;
+	uint16_t port;
+} st_wiz_listener;
+
+static st_wiz_socket wiz_sock[_WIZCHIP_SOCK_NUM_];
+static st_wiz_listener wiz_listener[_WIZCHIP_SOCK_NUM_];
+static uint8_t wiz_initialized = 0;
+static uint32_t wiz_activity = 0;		// Socket calls that changed a state or moved data
+
+/**** Private functions ****/
+static void wiz_posix_init(void)
+{
+	int i;
+
+	if(wiz_initialized) return;
+	for(i = 0; i < _WIZCHIP_SOCK_NUM_; i++)
+	{
+		wiz_sock[i].fd = -1;
+		wiz_sock[i].sr = SOCK_CLOSED;
+		wiz_listener[i].fd = -1;
+	}
+	wiz_initialized = 1;
+}
+
+// Listening socket of the port, shared by the hardware sockets; created once, exits if the port is not available
+static int wiz_listener_fd(uint16_t port)
+{
+	struct sockaddr_in addr;
+	int i, fd, on = 1;
+
+	for(i = 0; i < _WIZCHIP_SOCK_NUM_; i++)
+	{
+		if((wiz_listener[i].fd >= 0) && (wiz_listener[i].port == port)) return wiz_listener[i].fd;
+	}
+	for(i = 0; (i < _WIZCHIP_SOCK_NUM_) && (wiz_listener[i].fd >= 0); i++);
+
+	fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(fd < 0)
+	{
+		perror("socket");
+		exit(1);
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) || (listen(fd, WIZ_POSIX_BACKLOG) < 0))
+	{
+		fprintf(stderr, "port %u: %s\n", port, strerror(errno));
+		exit(1);
+	}
+
+	wiz_listener[i].fd = fd;
+	wiz_listener[i].port = port;
+
+	return fd;
+}
+
+static void wiz_sock_close(uint8_t sn)
+{
+	if(wiz_sock[sn].fd >= 0) close(wiz_sock[sn].fd);
+	wiz_sock[sn].fd = -1;
+	wiz_sock[sn].sr = SOCK_CLOSED;
+	wiz_sock[sn].ir = 0;
+	wiz_activity++;
+}
+
+// Sn_CR_DISCON: FIN after the data sent; received data left is dropped first, so that close() does not reset
+static void wiz_sock_discon(uint8_t sn)
+{
+	uint8_t buf[256];
+
+	if(wiz_sock[sn].fd >= 0)
+	{
+		shutdown(wiz_sock[sn].fd, SHUT_WR);
+		while(read(wiz_sock[sn].fd, buf, sizeof(buf)) > 0);
+	}
+	wiz_sock_close(sn);
+}
+
+// SOCK_LISTEN: takes a pending connection of the port
+static void wiz_sock_accept(uint8_t sn)
+{
+	socklen_t addr_len = sizeof(wiz_sock[sn].peer);
+	int fd, on = 1;
+
+	fd = accept4(wiz_listener_fd(wiz_sock[sn].port), (struct sockaddr *)&wiz_sock[sn].peer, &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if(fd < 0) return;
+
+	// The TCP/IP core sends the data of a SEND command at once
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+	wiz_sock[sn].fd = fd;
+	wiz_sock[sn].sr = SOCK_ESTABLISHED;
+	wiz_sock[sn].ir |= Sn_IR_CON;
+	wiz_activity++;
+}
+
+// SOCK_ESTABLISHED: SOCK_CLOSE_WAIT when the peer closed and the received data are read, SOCK_CLOSED if reset
+static void wiz_sock_check(uint8_t sn)
+{
+	uint8_t c;
+	ssize_t ret;
+
+	ret = recv(wiz_sock[sn].fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+	if(ret == 0)
+	{
+		wiz_sock[sn].sr = SOCK_CLOSE_WAIT;
+		wiz_activity++;
+	}
+	else if((ret < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+	{
+		wiz_sock_close(sn);
+	}
+}
+
+static int wiz_sock_connected(uint8_t sn)
+{
+	return (wiz_sock[sn].sr == SOCK_ESTABLISHED) || (wiz_sock[sn].sr == SOCK_CLOSE_WAIT);
+}
+
+/*****************************************************************************
+ * ioLibrary socket API (TCP)
+ ****************************************************************************/
+int8_t wiz_socket(uint8_t sn, uint8_t protocol, uint16_t port, uint8_t flag)
+{
+	(void)flag;
+
+	wiz_posix_init();
+	if(sn >= _WIZCHIP_SOCK_NUM_) return SOCKERR_SOCKNUM;
+	if(protocol != Sn_MR_TCP) return SOCKERR_SOCKMODE;
+	if(port == 0) return SOCKERR_PORTZERO;
+
+	if(wiz_sock[sn].fd >= 0) wiz_sock_close(sn);
+	wiz_listener_fd(port);
+	wiz_sock[sn].port = port;
+	wiz_sock[sn].sr = SOCK_INIT;
+	wiz_sock[sn].ir = 0;
+	wiz_activity++;
+
+	return (int8_t)sn;
+}
+
+int8_t wiz_close(uint8_t sn)
+{
+	wiz_posix_init();
+	if(sn >= _WIZCHIP_SOCK_NUM_) return SOCKERR_SOCKNUM;
+	wiz_sock_close(sn);
+
+	return SOCK_OK;
+}
+
+int8_t wiz_listen(uint8_t sn)
+{
+	wiz_posix_init();
+	if(sn >= _WIZCHIP_SOCK_NUM_) return SOCKERR_SOCKNUM;
+	if(wiz_sock[sn].sr != SOCK_INIT) return SOCKERR_SOCKINIT;
+
+	wiz_sock[sn].sr = SOCK_LISTEN;
+	wiz_activity++;
+
+	return SOCK_OK;
+}
+
+int8_t wiz_disconnect(uint8_t sn)
+{
+	wiz_posix_init();
+	if(sn >= _WIZCHIP_SOCK_NUM_) return SOCKERR_SOCKNUM;
+	wiz_sock_discon(sn);
+
+	return SOCK_OK;
+}
+
+// Blocking mode: waits until the data (up to the TX buffer size) are taken
+int32_t wiz_send(uint8_t sn, uint8_t * buf, uint16_t len)
+{
+	struct pollfd pfd;
+	uint16_t sent = 0;
+	ssize_t ret;
+
+	wiz_posix_init();
+	if(sn >= _WIZCHIP_SOCK_NUM_) return SOCKERR_SOCKNUM;
+	if(len == 0) return SOCKERR_DATALEN;
+	if(!wiz_sock_connected(sn)) return SOCKERR_SOCKSTATUS;
+	if(len > WIZ_POSIX_TXBUF_SIZE) len = WIZ_POSIX_TXBUF_SIZE;
+
+	while(sent < len)
+	{
+		ret = send(wiz_sock[sn].fd, buf + sent, len - sent, MSG_NOSIGNAL);
+		if(ret > 0)
+		{
+			sent += (uint16_t)ret;
+		}
+		else if((ret < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)))
+		{
+			pfd.fd = wiz_sock[sn].fd;
+			pfd.events = POLLOUT;
+			poll(&pfd, 1, -1);
+		}
+		else
+		{
+			wiz_sock_close(sn);
+			return SOCKERR_SOCKSTATUS;
+		}
+	}
+	wiz_activity++;
+
+	return len;
+}
+
+// Blocking mode: waits for data, returns at most 'len' bytes of the received data
+int32_t wiz_recv(uint8_t sn, uint8_t * buf, uint16_t len)
+{
+	struct pollfd pfd;
+	ssize_t ret;
+
+	wiz_posix_init();
+	if(sn >= _WIZCHIP_SOCK_NUM_) return SOCKERR_SOCKNUM;
+	if(len == 0) return SOCKERR_DATALEN;
+	if(len > WIZ_POSIX_RXBUF_SIZE) len = WIZ_POSIX_RXBUF_SIZE;
+
+	for(;;)
+	{
+		if(!wiz_sock_connected(sn)) return SOCKERR_SOCKSTATUS;
+
+		ret = recv(wiz_sock[sn].fd, buf, len, 0);
+		if(ret > 0) break;
+		if(ret == 0)
+		{
+			wiz_sock[sn].sr = SOCK_CLOSE_WAIT;
+			return SOCKERR_SOCKSTATUS;
+		}
+		if((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+		{
+			pfd.fd = wiz_sock[sn].fd;
+			pfd.events = POLLIN;
+			poll(&pfd, 1, -1);
+		}
+		else
+		{
+			wiz_sock_close(sn);
+			return SOCKERR_SOCKSTATUS;
+		}
+	}
+	wiz_activity++;
+
+	return (int32_t)ret;
+}
+
+/*****************************************************************************
+ * Socket registers
+ ****************************************************************************/
+uint8_t wiz_getSn_SR(uint8_t sn)
+{
+	wiz_posix_init();
+	if(sn >= _WIZCHIP_SOCK_NUM_) return SOCK_CLOSED;
+
+	if(wiz_sock[sn].sr == SOCK_LISTEN) wiz_sock_accept(sn);
+	else if(wiz_sock[sn].sr == SOCK_ESTABLISHED) wiz_sock_check(sn);
+
+	return wiz_sock[sn].sr;
+}
+
+uint8_t wiz_getSn_IR(uint8_t sn)
+{
+	wiz_posix_init();
+	return (sn < _WIZCHIP_SOCK_NUM_) ? wiz_sock[sn].ir : 0;
+}
+
+// Write 1 to clear
+void wiz_setSn_IR(uint8_t sn, uint8_t ir)
+{
+	wiz_posix_init();
+	if(sn < _WIZCHIP_SOCK_NUM_) wiz_sock[sn].ir &= ~ir;
+}
+
+// Commands complete at once
+uint8_t wiz_getSn_CR(uint8_t sn)
+{
+	(void)sn;
+	return 0;
+}
+
+void wiz_setSn_CR(uint8_t sn, uint8_t cr)
+{
+	wiz_posix_init();
+	if(sn >= _WIZCHIP_SOCK_NUM_) return;
+
+	if(cr == Sn_CR_DISCON) wiz_sock_discon(sn);
+	else if(cr == Sn_CR_CLOSE) wiz_sock_close(sn);
+	else if((cr == Sn_CR_LISTEN) && (wiz_sock[sn].sr == SOCK_INIT)) wiz_sock[sn].sr = SOCK_LISTEN;
+}
+
+uint16_t wiz_getSn_RX_RSR(uint8_t sn)
+{
+	int len = 0;
+
+	wiz_posix_init();
+	if((sn >= _WIZCHIP_SOCK_NUM_) || !wiz_sock_connected(sn)) return 0;
+	if(ioctl(wiz_sock[sn].fd, FIONREAD, &len) < 0) return 0;
+
+	return (uint16_t)((len > WIZ_POSIX_RXBUF_SIZE) ? WIZ_POSIX_RXBUF_SIZE : len);
+}
+
+uint16_t wiz_getSn_TX_FSR(uint8_t sn)
+{
+	int len = 0;
+
+	wiz_posix_init();
+	if((sn >= _WIZCHIP_SOCK_NUM_) || !wiz_sock_connected(sn)) return WIZ_POSIX_TXBUF_SIZE;
+	if(ioctl(wiz_sock[sn].fd, SIOCOUTQ, &len) < 0) return 0;
+
+	return (uint16_t)((len > WIZ_POSIX_TXBUF_SIZE) ? 0 : WIZ_POSIX_TXBUF_SIZE - len);
+}
+
+void wiz_getSn_DIPR(uint8_t sn, uint8_t * dipr)
+{
+	wiz_posix_init();
+	if(sn < _WIZCHIP_SOCK_NUM_) memcpy(dipr, &wiz_sock[sn].peer.sin_addr.s_addr, 4);
+}
+
+uint16_t wiz_getSn_DPORT(uint8_t sn)
+{
+	wiz_posix_init();
+	return (sn < _WIZCHIP_SOCK_NUM_) ? ntohs(wiz_sock[sn].peer.sin_port) : 0;
+}
+
+/*****************************************************************************
+ * Host main loop
+ ****************************************************************************/
+int wiz_posix_idle(int timeout_msec)
+{
+	static uint32_t last_activity;
+	struct pollfd pfd[_WIZCHIP_SOCK_NUM_ * 2];
+	int i, n = 0, tx_pending = 0, len;
+
+	wiz_posix_init();
+	if(wiz_activity != last_activity)
+	{
+		last_activity = wiz_activity;
+		return 0;
+	}
+
+	for(i = 0; i < _WIZCHIP_SOCK_NUM_; i++)
+	{
+		if(wiz_sock[i].sr == SOCK_LISTEN)
+		{
+			pfd[n].fd = wiz_listener_fd(wiz_sock[i].port);
+			pfd[n++].events = POLLIN;
+		}
+		else if(wiz_sock[i].sr == SOCK_ESTABLISHED)
+		{
+			pfd[n].fd = wiz_sock[i].fd;
+			pfd[n++].events = POLLIN;
+			// Sn_TX_FSR grows with the acknowledgements, which poll() does not report
+			if((ioctl(wiz_sock[i].fd, SIOCOUTQ, &len) == 0) && (len > 0)) tx_pending = 1;
+		}
+	}
+	if(tx_pending && (timeout_msec > 1)) timeout_msec = 1;
+
+	poll(pfd, n, timeout_msec);
+
+	return 1;
+}
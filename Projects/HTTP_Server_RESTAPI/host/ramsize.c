@@ -0,0 +1,104 @@
+/**
+ * @file	ramsize.c
+ * @brief	Host tool - Static RAM per module from the link map of armlink (the .map of uVision)
+ *
+ * Reads the 'Image component sizes' tables of the map (Listing: Memory Map, Size Info) and prints the objects and the
+ * libraries by RAM (RW Data + ZI Data), the largest first. startup_w7500x.o holds the stack and the heap areas; the
+ * headroom left at run time and the stack high-water marks are in GET /diag/memory.
+ *
+ *   ./ramsize ../lst/W7500x_App_HTTP_Server_RESTAPI.map
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_MODULES		256
+#define NAME_SIZE		64
+
+typedef struct
+{
+	char name[NAME_SIZE];
+	unsigned long rw;
+	unsigned long zi;
+} st_module;
+
+static st_module modules[MAX_MODULES];
+static int module_cnt;
+
+static int compare_ram(const void * a, const void * b)
+{
+	unsigned long ra = ((const st_module *)a)->rw + ((const st_module *)a)->zi;
+	unsigned long rb = ((const st_module *)b)->rw + ((const st_module *)b)->zi;
+
+	return (ra < rb) ? 1 : (ra > rb) ? -1 : 0;
+}
+
+int main(int argc, char * argv[])
+{
+	FILE * in = stdin;
+	char line[512];
+	char name[NAME_SIZE];
+	unsigned long code, inc, ro, rw, zi, debug;
+	unsigned long total_rw = 0, total_zi = 0;
+	int table = 0; // 1: objects, 2: library members (counted by their libraries), 3: libraries
+	int i;
+
+	if(argc > 2)
+	{
+		fprintf(stderr, "usage: %s [file.map]     (stdin by default)\n", argv[0]);
+		return 2;
+	}
+	if((argc == 2) && ((in = fopen(argv[1], "r")) == NULL))
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	while(fgets(line, sizeof(line), in) != NULL)
+	{
+		if(strstr(line, "Code (inc. data)") != NULL)
+		{
+			if(strstr(line, "Object Name") != NULL) table = 1;
+			else if(strstr(line, "Library Member Name") != NULL) table = 2;
+			else if(strstr(line, "Library Name") != NULL) table = 3;
+			else table = 0;
+			continue;
+		}
+		if((table != 1) && (table != 3)) continue;
+		if(sscanf(line, "%lu %lu %lu %lu %lu %lu %63s", &code, &inc, &ro, &rw, &zi, &debug, name) != 7) continue;
+		if((name[0] == '(') || (strstr(line, "Totals") != NULL)) continue; // (incl. Padding), Object Totals, ...
+
+		if(module_cnt == MAX_MODULES)
+		{
+			fprintf(stderr, "ramsize: more than %d modules\n", MAX_MODULES);
+			break;
+		}
+		strcpy(modules[module_cnt].name, name);
+		modules[module_cnt].rw = rw;
+		modules[module_cnt].zi = zi;
+		module_cnt++;
+		total_rw += rw;
+		total_zi += zi;
+	}
+
+	if(module_cnt == 0)
+	{
+		fprintf(stderr, "ramsize: no 'Image component sizes' table (armlink --info sizes)\n");
+		return 1;
+	}
+
+	qsort(modules, module_cnt, sizeof(st_module), compare_ram);
+
+	printf("%-32s %8s %8s %8s %6s\n", "module", "RW", "ZI", "RAM", "%");
+	for(i = 0; i < module_cnt; i++)
+	{
+		if((modules[i].rw + modules[i].zi) == 0) continue;
+		printf("%-32s %8lu %8lu %8lu %5.1f%%\n", modules[i].name, modules[i].rw, modules[i].zi, modules[i].rw + modules[i].zi,
+			100.0 * (modules[i].rw + modules[i].zi) / (total_rw + total_zi));
+	}
+	printf("%-32s %8lu %8lu %8lu\n", "total", total_rw, total_zi, total_rw + total_zi);
+
+	return 0;
+}
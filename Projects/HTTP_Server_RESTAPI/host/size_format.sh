@@ -0,0 +1,31 @@
+#!/bin/sh
+# Flash size comparison of the number formatters: snprintf() based (legacy) vs. frozen
+#
+# Links a probe program that references only one set of formatters (host/bench_format.c, SIZE_PROBE)
+# and prints the section sizes. Default toolchain: GNU Arm Embedded (newlib-nano, Cortex-M0)
+#
+# Usage (from Projects/HTTP_Server_RESTAPI):
+#   sh host/size_format.sh
+#   CC=gcc SIZE=size LEGACY_FLAGS= CFLAGS="-Os -static -ffunction-sections -fdata-sections -Wl,--gc-sections" sh host/size_format.sh
+#   (host toolchain, for reference only)
+
+CC=${CC:-arm-none-eabi-gcc}
+SIZE=${SIZE:-arm-none-eabi-size}
+CFLAGS=${CFLAGS:--mcpu=cortex-m0 -mthumb -Os -ffunction-sections -fdata-sections -Wl,--gc-sections --specs=nano.specs --specs=nosys.specs}
+# newlib-nano links the floating point printf only on request; needed by the legacy %g
+LEGACY_FLAGS=${LEGACY_FLAGS--u _printf_float}
+OUT=${TMPDIR:-/tmp}/size_format
+
+set -e
+mkdir -p $OUT
+
+for probe in 1 2 3; do
+	FLAGS="$CFLAGS"
+	if [ $probe -eq 1 ]; then FLAGS="$CFLAGS $LEGACY_FLAGS"; fi
+	$CC $FLAGS -DSIZE_PROBE=$probe -Isrc/HTTPServer/frozen host/bench_format.c src/HTTPServer/frozen/frozen.c -o $OUT/probe$probe.elf
+done
+
+echo "1: legacy  json_emit_long + json_emit_double (snprintf %ld / %g)"
+echo "2: frozen  json_emit_long + json_emit_double"
+echo "3: frozen  json_emit_long + json_emit_fixed (no floating point)"
+$SIZE $OUT/probe1.elf $OUT/probe2.elf $OUT/probe3.elf
@@ -0,0 +1,289 @@
+/**
+ * @file	platform_stub.c
+ * @brief	Host build - Platform stubs of the REST API handlers: user I/O (GPIO / ADC), uptime, device configuration, network info
+ *
+ * The I/O pins keep their state in memory, from the factory configuration (set_DevConfig_to_factory_value()); analog
+ * inputs return a ramp instead of an ADC conversion. The uptime and the microsecond time follow the host monotonic clock.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "wizchip_conf.h"
+#include "W7500x_board.h"
+#include "ConfigData.h"
+#include "gpioHandler.h"
+#include "timerHandler.h"
+#include "uartHandler.h"
+#include "schedHandler.h"
+#include "wdtHandler.h"
+#include "crashHandler.h"
+#include "memHandler.h"
+
+uint8_t        USER_IO_SEL[USER_IOn] =     {USER_IO_A, USER_IO_B, USER_IO_C, USER_IO_D};
+const char*    USER_IO_STR[USER_IOn] =     {"a", "b", "c", "d"};
+const char*    USER_IO_PIN_STR[USER_IOn] = {"p30", "p29", "p28", "p27"};
+
+static uint8_t user_io_out;			// Output latch (GPIO data bits)
+static uint16_t adc_val;
+static uint32_t adc_conversions;
+static uint8_t adc_converting;		// Inputs of the conversions in progress (user_io_val_ready)
+
+static DevConfig dev_config;
+
+static const wiz_NetInfo net_info =
+{
+	{0x00, 0x08, 0xdc, 0x12, 0x34, 0x56},	// mac
+	{192, 168, 0, 100},						// ip
+	{255, 255, 255, 0},						// sn
+	{192, 168, 0, 1},						// gw
+	{8, 8, 8, 8},							// dns
+	NETINFO_STATIC							// dhcp
+};
+
+/*****************************************************************************
+ * User I/O: enable / type / direction in the device configuration, as gpioHandler.c
+ ****************************************************************************/
+void init_user_io(uint8_t io_sel)
+{
+	user_io_out &= ~io_sel;
+}
+
+uint8_t get_user_io_enabled(uint8_t io_sel)
+{
+	return ((dev_config.user_io_info.user_io_enable & io_sel) == io_sel) ? IO_ENABLE : IO_DISABLE;
+}
+
+uint8_t get_user_io_type(uint8_t io_sel)
+{
+	return ((dev_config.user_io_info.user_io_type & io_sel) == io_sel) ? IO_ANALOG_IN : IO_DIGITAL;
+}
+
+uint8_t get_user_io_direction(uint8_t io_sel)
+{
+	return ((dev_config.user_io_info.user_io_direction & io_sel) == io_sel) ? IO_OUTPUT : IO_INPUT;
+}
+
+uint8_t set_user_io_enable(uint8_t io_sel, uint8_t enable)
+{
+	if(enable == IO_ENABLE) dev_config.user_io_info.user_io_enable |= io_sel;
+	else dev_config.user_io_info.user_io_enable &= ~io_sel;
+
+	return 1;
+}
+
+uint8_t set_user_io_type(uint8_t io_sel, uint8_t type)
+{
+	if(type == IO_ANALOG_IN)
+	{
+		dev_config.user_io_info.user_io_type |= io_sel;
+		dev_config.user_io_info.user_io_direction &= ~io_sel; // Analog: input only
+	}
+	else
+	{
+		dev_config.user_io_info.user_io_type &= ~io_sel;
+	}
+
+	return 1;
+}
+
+uint8_t set_user_io_direction(uint8_t io_sel, uint8_t dir)
+{
+	if(dir == IO_OUTPUT) dev_config.user_io_info.user_io_direction |= io_sel;
+	else dev_config.user_io_info.user_io_direction &= ~io_sel;
+
+	return 1;
+}
+
+// Digital inputs read low
+uint8_t get_user_io_val(uint16_t io_sel, uint16_t * val)
+{
+	*val = 0;
+	if(get_user_io_enabled(io_sel) != IO_ENABLE) return 0;
+
+	if(get_user_io_type(io_sel) == IO_ANALOG_IN) *val = read_ADC(ADC_CH0);
+	else if(get_user_io_direction(io_sel) == IO_OUTPUT) *val = (user_io_out & io_sel) ? IO_HIGH : IO_LOW;
+
+	return 1;
+}
+
+uint8_t set_user_io_val(uint16_t io_sel, uint16_t * val)
+{
+	if((get_user_io_enabled(io_sel) != IO_ENABLE) || (get_user_io_type(io_sel) != IO_DIGITAL) || (get_user_io_direction(io_sel) != IO_OUTPUT)) return 0;
+
+	if(*val == 0) user_io_out &= ~io_sel;
+	else if(*val == 1) user_io_out |= io_sel;
+
+	return 1;
+}
+
+// 12-bit ramp
+uint16_t read_ADC(ADC_CH ch)
+{
+	(void)ch;
+	adc_val = (adc_val + 37) & 0x0FFF;
+	adc_conversions++;
+
+	return adc_val;
+}
+
+uint32_t get_ADC_conversions(void)
+{
+	return adc_conversions;
+}
+
+// An analog conversion ends at the next call: the resumable handlers wait for one server pass
+uint8_t user_io_val_ready(uint16_t io_sel)
+{
+	if((get_user_io_enabled(io_sel) != IO_ENABLE) || (get_user_io_type(io_sel) != IO_ANALOG_IN)) return 1;
+
+	adc_converting ^= io_sel;
+
+	return (adc_converting & io_sel) ? 0 : 1;
+}
+
+// Debug UART: printf() goes to stdout
+uint32_t get_UART2_tx_dropped(void)
+{
+	return 0;
+}
+
+// Scheduler: the host server has its own poll() loop, no tasks; the idle pseudo-task only
+static const st_sched_stats sched_idle = { "idle", 0, 0, 0, 0 };
+
+uint8_t get_sched_task_count(void)
+{
+	return 0;
+}
+
+const st_sched_stats* get_sched_stats(uint8_t id)
+{
+	return (id == 0) ? &sched_idle : NULL;
+}
+
+// Watchdog supervisor: no watchdog timer on the host, no subsystems and no reset
+const st_wdt_record* get_wdt_last_reset(void)
+{
+	return NULL;
+}
+
+uint32_t get_wdt_resets(void)
+{
+	return 0;
+}
+
+uint8_t get_wdt_subsys_count(void)
+{
+	return 0;
+}
+
+const st_wdt_subsys* get_wdt_subsys(uint8_t id)
+{
+	(void)id;
+	return NULL;
+}
+
+uint32_t get_wdt_tick(void)
+{
+	return (uint32_t)(getDeviceTime_usec64() / 1000);
+}
+
+// Crash capture: no HardFault handler on the host
+const st_crash_record* get_crash_last(void)
+{
+	return NULL;
+}
+
+// Memory: the host process has no painted stacks and no link map of the firmware
+uint32_t get_stack_size(uint8_t stack)
+{
+	(void)stack;
+	return 0;
+}
+
+uint32_t get_stack_free(uint8_t stack)
+{
+	(void)stack;
+	return 0;
+}
+
+void get_mem_ram(st_mem_ram * ram)
+{
+	memset(ram, 0, sizeof(*ram));
+}
+
+/*****************************************************************************
+ * Timebase: host monotonic clock, microseconds since the first call
+ ****************************************************************************/
+uint64_t getDeviceTime_usec64(void)
+{
+	static uint64_t start;
+	struct timespec ts;
+	uint64_t now;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	if(start == 0) start = now;
+
+	return now - start;
+}
+
+uint32_t getDeviceTime_usec(void)
+{
+	return (uint32_t)getDeviceTime_usec64();
+}
+
+void getDeviceUptime(st_uptime* uptime)
+{
+	uint64_t msec = getDeviceTime_usec64() / 1000;
+
+	uptime->hour = (uint32_t)(msec / 3600000);
+	uptime->min = (uint8_t)((msec / 60000) % 60);
+	uptime->sec = (uint8_t)((msec / 1000) % 60);
+	uptime->msec = (uint16_t)(msec % 1000);
+}
+
+uint32_t getDeviceUptime_hour(void)
+{
+	return (uint32_t)(getDeviceTime_usec64() / 3600000000ULL);
+}
+
+uint8_t getDeviceUptime_min(void)
+{
+	return (uint8_t)((getDeviceTime_usec64() / 60000000) % 60);
+}
+
+uint8_t getDeviceUptime_sec(void)
+{
+	return (uint8_t)((getDeviceTime_usec64() / 1000000) % 60);
+}
+
+uint16_t getDeviceUptime_msec(void)
+{
+	return (uint16_t)((getDeviceTime_usec64() / 1000) % 1000);
+}
+
+/*****************************************************************************
+ * Device configuration / network
+ ****************************************************************************/
+DevConfig* get_DevConfig_pointer(void)
+{
+	return &dev_config;
+}
+
+// User I/O part of the factory configuration of ConfigData.c
+void set_DevConfig_to_factory_value(void)
+{
+	memset(&dev_config, 0, sizeof(dev_config));
+	dev_config.user_io_info.user_io_enable = USER_IO_A | USER_IO_B | USER_IO_C | USER_IO_D;
+	dev_config.user_io_info.user_io_type = USER_IO_A | USER_IO_B; // A, B = Analog / C, D = Digital
+	dev_config.user_io_info.user_io_direction = ~(USER_IO_A | USER_IO_B | USER_IO_C | USER_IO_D); // Input
+	user_io_out = 0;
+}
+
+int8_t ctlnetwork(ctlnetwork_type cntype, void* arg)
+{
+	if(cntype == CN_GET_NETINFO) memcpy(arg, &net_info, sizeof(net_info));
+
+	return 0;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file	tracedump.c
+ * @brief	Host tool - Decoder of the trace ring (src/PlatformHandler/traceHandler.h): one line per event
+ *
+ * Reads the binary stream of GET /diag/trace, or a debug UART log with the 'TRACE:' hex lines of trace_dump()
+ * (other lines are skipped; each dump in the log is decoded).
+ *
+ *   curl -s http://192.168.0.100/diag/trace | ./tracedump
+ *   ./tracedump uart.log
+ *
+ * Columns: sequence number, time since boot (s, from getDeviceTime_usec(): wraps after 71 minutes), time since the
+ * previous event (us), H/W socket, event and its arguments.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "traceHandler.h"
+
+#define RECORD_SIZE		12
+
+static const char * const method_names[] = { "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS" };	// HTTP_REQ_METHOD_xxx bits
+static const char * const state_names[] = { "IDLE", "REQ_INPROC", "REQ_DONE", "RES_INPROC", "RES_DONE" };	// STATE_HTTP_xxx
+
+static uint16_t get16(const uint8_t * p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t * p)
+{
+	return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static const char * method_name(uint16_t method)
+{
+	int i;
+
+	for(i = 0; i < (int)(sizeof(method_names) / sizeof(method_names[0])); i++)
+	{
+		if(method == (1 << i)) return method_names[i];
+	}
+
+	return "ERR";
+}
+
+static void print_event(uint8_t id, uint16_t arg0, uint32_t arg1)
+{
+	switch(id)
+	{
+		case TRACE_EV_LOST:             printf("LOST         %u records overwritten while draining", arg1); break;
+		case TRACE_EV_BOOT:             printf("BOOT"); break;
+		case TRACE_EV_HTTP_OPEN:        printf("OPEN         port %u", arg0); break;
+		case TRACE_EV_HTTP_CONNECT:
+			printf("CONNECT      from %u.%u.%u.%u:%u", arg1 >> 24, (arg1 >> 16) & 0xFF, (arg1 >> 8) & 0xFF, arg1 & 0xFF, arg0);
+			break;
+		case TRACE_EV_HTTP_REQUEST:     printf("REQUEST      %s, %u bytes", method_name(arg0), arg1); break;
+		case TRACE_EV_HTTP_ROUTE:
+			if(arg0 == 0xFFFF) printf("ROUTE        no resource, uri type %u", arg1);
+			else printf("ROUTE        resource %u, uri type %u", arg0, arg1);
+			break;
+		case TRACE_EV_HTTP_RESPONSE:
+			if(arg1 == 0xFFFFFFFF) printf("RESPONSE     %u, chunked", arg0);
+			else printf("RESPONSE     %u, %u bytes", arg0, arg1);
+			break;
+		case TRACE_EV_HTTP_CHUNK:       printf("CHUNK        %u bytes, cursor %u", arg0, arg1); break;
+		case TRACE_EV_HTTP_STREAM_END:  printf("STREAM_END   cursor %u", arg1); break;
+		case TRACE_EV_HTTP_STATE:
+			printf("STATE        %s", (arg0 < 5) ? state_names[arg0] : "?");
+			break;
+		case TRACE_EV_HTTP_CLOSE_WAIT:
+			printf("CLOSE_WAIT   in %s", (arg0 < 5) ? state_names[arg0] : "?");
+			break;
+		case TRACE_EV_HTTP_DONE:
+			if(arg0) printf("DONE         %u, %u us", arg0, arg1);
+			else printf("DONE         no complete response, %u us", arg1);
+			break;
+		case TRACE_EV_HTTP_SEND_ERR:    printf("SEND_ERR     %u bytes, result %d", arg0, (int32_t)arg1); break;
+		case TRACE_EV_HTTP_REAP:        printf("REAP         no request in %u s", arg0); break;
+		default:                        printf("0x%02X         0x%04X 0x%08X", id, arg0, arg1); break;
+	}
+}
+
+// One drained stream: header and records; returns -1 if the header is not valid
+static int decode(const uint8_t * buf, size_t len)
+{
+	uint32_t seq, head, prev = 0;
+	const uint8_t * p;
+	int first = 1;
+
+	if((len < TRACE_HEADER_SIZE) || memcmp(buf, TRACE_MAGIC, 4) || (buf[4] != TRACE_VERSION) || (buf[5] != RECORD_SIZE))
+	{
+		fprintf(stderr, "tracedump: not a trace stream (version %d expected)\n", TRACE_VERSION);
+		return -1;
+	}
+
+	seq = get32(buf + 8);
+	head = get32(buf + 12);
+	printf("# ring of %u records, %u records written, from #%u\n", get16(buf + 6), head, seq);
+	printf("#      seq        time (s)    delta (us)  sock  event\n");
+
+	for(p = buf + TRACE_HEADER_SIZE; p + RECORD_SIZE <= buf + len; p += RECORD_SIZE)
+	{
+		uint32_t time = get32(p);
+		uint8_t sock = p[4];
+		uint8_t id = p[5];
+
+		if(id == TRACE_EV_LOST)
+		{
+			printf("  %8s  %7u.%06u  %12s  %4s  ", "-", time / 1000000, time % 1000000, "", "");
+			print_event(id, get16(p + 6), get32(p + 8));
+			printf("\n");
+			seq += get32(p + 8);
+			continue;
+		}
+
+		printf("  %8u  %7u.%06u  ", seq, time / 1000000, time % 1000000);
+		if(first) printf("%12s  ", "");
+		else printf("%12u  ", time - prev);
+		if(sock == TRACE_SOCK_NONE) printf("%4s  ", "-");
+		else printf("%4u  ", sock);
+		print_event(id, get16(p + 6), get32(p + 8));
+		printf("\n");
+
+		prev = time;
+		first = 0;
+		seq++;
+	}
+
+	return 0;
+}
+
+static int hexval(int c)
+{
+	if((c >= '0') && (c <= '9')) return c - '0';
+	if((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+	if((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+
+	return -1;
+}
+
+int main(int argc, char * argv[])
+{
+	FILE * in = stdin;
+	uint8_t * buf = NULL;
+	uint8_t * out;
+	size_t len = 0, cap = 0, n, i, start, olen;
+	int ret = 0;
+	int hi, lo;
+	char * line;
+
+	if(argc > 2)
+	{
+		fprintf(stderr, "usage: %s [file]     (stdin by default)\n", argv[0]);
+		return 2;
+	}
+	if((argc == 2) && ((in = fopen(argv[1], "rb")) == NULL))
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	do
+	{
+		if(len == cap)
+		{
+			cap = cap ? cap * 2 : 65536;
+			if((buf = realloc(buf, cap + 1)) == NULL) return 1;
+		}
+		n = fread(buf + len, 1, cap - len, in);
+		len += n;
+	} while(n > 0);
+
+	if((len >= 4) && !memcmp(buf, TRACE_MAGIC, 4)) return decode(buf, len) ? 1 : 0;
+
+	// UART log: the hex of the 'TRACE:' lines, a new stream at each header
+	buf[len] = '\0';
+	if((out = malloc(len / 2 + 1)) == NULL) return 1;
+	olen = 0;
+	start = 0;
+	for(line = strstr((char *)buf, "TRACE:"); line != NULL; line = strstr(line, "TRACE:"))
+	{
+		line += 6;
+		if((strncmp(line, "575a5452", 8) == 0) || (strncmp(line, "575A5452", 8) == 0)) // "WZTR"
+		{
+			if(olen > start)
+			{
+				ret |= decode(out + start, olen - start);
+				printf("\n");
+			}
+			start = olen;
+		}
+		for(i = 0; ((hi = hexval(line[i])) >= 0) && ((lo = hexval(line[i + 1])) >= 0); i += 2) out[olen++] = (uint8_t)((hi << 4) | lo);
+	}
+	if(olen > start) ret |= decode(out + start, olen - start);
+	else if(olen == 0)
+	{
+		fprintf(stderr, "tracedump: no trace stream or 'TRACE:' lines\n");
+		ret = -1;
+	}
+
+	return ret ? 1 : 0;
+}
@@ -22,6 +22,14 @@
 
 #include "RESTapiHandler.h"
 #include "frozen.h" // Frozen: JSON parser and generator for C/C++
+#include "jsonWriter.h"
+#include "jsonDecoder.h"
+#include "httpArena.h"
+#include "httpServer_rest.h" // HTTP_RES_BODY_SIZE
+
+#define LOG_MODULE			LOG_MODULE_RESTAPI
+#define LOG_MODULE_LEVEL	LOG_LEVEL_RESTAPI
+#include "logHandler.h"
 
 /*****************************************************************************
  * Private types/enumerations/variables
@@ -33,6 +41,22 @@
 #define RESTAPI_STR_DIGITAL     "digital"
 #define RESTAPI_STR_INPUT       "input"
 #define RESTAPI_STR_OUTPUT      "output"
+
+// Resource node: URI of the registered resource(s) split into the segments
+#define RESOURCE_NODE_WILDCARD  0xFF         // seg_len of the ':id' segment
+
+struct st_http_resource_node
+{
+	const char* uri;
+	uint8_t depth;
+	uint8_t seg_offset[MAX_URI_DEPTH];
+	uint8_t seg_len[MAX_URI_DEPTH];
+	uint8_t methods;                         // Bitmask of the registered methods
+	uint8_t table_num[HTTP_REQ_METHOD_NUM];  // Resource table number for each method bit
+	uint8_t allow;                           // Index of the 'Allow' header value, ALLOW_STR_NONE: rendered on request
+};
+
+#define ALLOW_STR_NONE          0xFF
  
 // HTTP CRUD functions
 // Create / Read / Update / Delete
@@ -47,25 +71,129 @@ static int16_t restapi_update_userio_id(char* buf);
 static int16_t restapi_update_userio_info(char* buf);
 static int16_t restapi_delete_userio_id(char* buf);
 static int8_t find_matched_userio_id(uint8_t * req_id);
+static void set_http_error_detail(const char * field, int16_t pos);
+
+// Representation fields: selectable by '?fields='
+static void emit_index_target(st_json_writer * w, const void* obj);
+static void emit_index_io(st_json_writer * w, const void* obj);
+static void emit_index_resource(st_json_writer * w, const void* obj);
+static void emit_netinfo_mac(st_json_writer * w, const void* obj);
+static void emit_netinfo_addr(st_json_writer * w, const uint8_t * addr);
+static void emit_netinfo_ip(st_json_writer * w, const void* obj);
+static void emit_netinfo_gw(st_json_writer * w, const void* obj);
+static void emit_netinfo_sn(st_json_writer * w, const void* obj);
+static void emit_netinfo_dns(st_json_writer * w, const void* obj);
+static void emit_netinfo_dhcp(st_json_writer * w, const void* obj);
+static void emit_userio_id(st_json_writer * w, const void* obj);
+static void emit_userio_type(st_json_writer * w, const void* obj);
+static void emit_userio_dir(st_json_writer * w, const void* obj);
+
+static const struct st_http_field index_fields[] = 
+{
+	{ "target",         emit_index_target },
+	{ "io",             emit_index_io },
+	{ "resource",       emit_index_resource },
+	
+	{ NULL, NULL } // Last item should be set to NULL
+};
+
+// Members of the 'netinfo' object; obj: wiz_NetInfo
+static const struct st_http_field netinfo_fields[] = 
+{
+	{ "mac",            emit_netinfo_mac },
+	{ "ip",             emit_netinfo_ip },
+	{ "gw",             emit_netinfo_gw },
+	{ "sn",             emit_netinfo_sn },
+	{ "dns",            emit_netinfo_dns },
+	{ "dhcp",           emit_netinfo_dhcp },
+	
+	{ NULL, NULL } // Last item should be set to NULL
+};
+
+// Members of each io object in the 'userio' array; obj: USER_IO number (uint8_t)
+static const struct st_http_field userio_fields[] = 
+{
+	{ RESTAPI_STR_ID,   emit_userio_id },
+	{ RESTAPI_STR_TYPE, emit_userio_type },
+	{ RESTAPI_STR_DIR,  emit_userio_dir },
+	
+	{ NULL, NULL } // Last item should be set to NULL
+};
+
+// PUT 'userio/:id/info' body: { "type": "digital" | "analog", "direction": "input" | "output" }
+struct st_userio_info
+{
+	uint8_t type;       // USER_IO_Type
+	uint8_t direction;  // USER_IO_Direction
+};
+
+#define USERIO_DIR_NONE         0xFF         // 'direction' not in the body
+
+static const char * const userio_type_names[] = { RESTAPI_STR_DIGITAL, RESTAPI_STR_ANALOG, NULL }; // Index: USER_IO_Type
+static const char * const userio_dir_names[] = { RESTAPI_STR_INPUT, RESTAPI_STR_OUTPUT, NULL };    // Index: USER_IO_Direction
+
+static const struct st_json_field userio_info_schema[] = 
+{
+	{ RESTAPI_STR_TYPE, JSON_FIELD_ENUM, offsetof(struct st_userio_info, type),      0, 0, userio_type_names },
+	{ RESTAPI_STR_DIR,  JSON_FIELD_ENUM, offsetof(struct st_userio_info, direction), 0, 0, userio_dir_names },
 	
-const struct st_http_resource uri_table[] = 
+	{ NULL, 0, 0, 0, 0, NULL } // Last item: key set to NULL
+};
+
+// Resource table: compiled resource nodes
+static uint8_t split_http_uri(const char * uri, const char ** seg, uint8_t * seg_len);
+static uint8_t match_http_resource_node(const struct st_http_resource_node * node, const char ** seg, const uint8_t * seg_len, uint8_t depth);
+static uint8_t get_http_method_index(uint8_t method);
+static uint8_t make_http_allow_str(uint8_t methods);
+
+// Built-in resources; user modules can add more resources by reg_http_resources()
+static const struct st_http_resource uri_table[] = 
 {
-	{ HTTP_REQ_METHOD_GET,    "index",           restapi_read_index,          "index page"  },
-	{ HTTP_REQ_METHOD_GET,    "uptime",          restapi_read_uptime,         "uptime" },
-	{ HTTP_REQ_METHOD_GET,    "netinfo",         restapi_read_netinfo,        "network configration" },
-	{ HTTP_REQ_METHOD_GET,    "userio",          restapi_read_userio,         "enabled io list"},
-	{ HTTP_REQ_METHOD_GET,    "userio/:id",      restapi_read_userio_id,      "get io status or value"},
-	{ HTTP_REQ_METHOD_POST,   "userio/:id",      restapi_create_userio_id,    "enable new io pin" },
-	{ HTTP_REQ_METHOD_PUT,    "userio/:id",      restapi_update_userio_id,    "set the io status (digital output only)" },
-	{ HTTP_REQ_METHOD_DELETE, "userio/:id",      restapi_delete_userio_id,    "disable the io pin" },
-	{ HTTP_REQ_METHOD_GET,    "userio/:id/info", restapi_read_userio_info,    "get the io configuration, type and direction"},
-	{ HTTP_REQ_METHOD_PUT,    "userio/:id/info", restapi_update_userio_info,  "set the io configuration, type and direction"},
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "index",           restapi_read_index,          NULL, 60,                  "index page",                                   0, 0 },
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "uptime",          restapi_read_uptime,         NULL, HTTP_CACHE_NO_STORE, "uptime",                                       0, 0 },
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "netinfo",         restapi_read_netinfo,        NULL, HTTP_CACHE_DEFAULT,  "network configration",                         0, 0 },
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "userio",          restapi_read_userio,         NULL, HTTP_CACHE_NO_STORE, "enabled io list",                              0, 0 },
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "userio/:id",      restapi_read_userio_id,      NULL, HTTP_CACHE_NO_STORE, "get io status or value",                       0, 0 },
+	{ HTTP_REQ_METHOD_POST,                       "userio/:id",      restapi_create_userio_id,    NULL, HTTP_CACHE_DEFAULT,  "enable new io pin",                            0, 0 },
+	{ HTTP_REQ_METHOD_PUT,                        "userio/:id",      restapi_update_userio_id,    NULL, HTTP_CACHE_DEFAULT,  "set the io status (digital output only)",      4, 0 },
+	{ HTTP_REQ_METHOD_DELETE,                     "userio/:id",      restapi_delete_userio_id,    NULL, HTTP_CACHE_DEFAULT,  "disable the io pin",                           0, 0 },
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "userio/:id/info", restapi_read_userio_info,    NULL, HTTP_CACHE_NO_STORE, "get the io configuration, type and direction", 0, 0 },
+	{ HTTP_REQ_METHOD_PUT,                        "userio/:id/info", restapi_update_userio_info,  NULL, HTTP_CACHE_DEFAULT,  "set the io configuration, type and direction", 0, 0 },
 	
-	{ NULL, NULL, NULL, NULL } // Last item should be set to NULL
+	{ 0, NULL, NULL, NULL, 0, NULL, 0, 0 } // Last item: uri set to NULL
 };
 
+// Registered resources (static capacity)
+static const struct st_http_resource * http_resources[MAX_HTTP_RESOURCES];
+static uint8_t http_resources_cnt = 0;
+
+// Resource nodes: one node per URI, built once by build_http_resources() after the registration
+static struct st_http_resource_node http_resource_nodes[MAX_HTTP_RESOURCES];
+static uint8_t http_resource_nodes_cnt = 0;
+
+// 'Allow' header values of the resource nodes, made once by build_http_resources()
+static char http_allow_str[MAX_HTTP_ALLOW_STR][HTTP_ALLOW_STR_SIZE];
+static uint8_t http_allow_methods[MAX_HTTP_ALLOW_STR];
+static uint8_t http_allow_str_cnt = 0;
+
 uint8_t req_resource_ID[MAX_RESOURCE_ID_SIZE];
 
+// Overflow policy of the response writers, given by the server for the current request
+static json_flush_func response_flush = NULL;
+static void * response_flush_ctx = NULL;
+
+// JSON request body: tokens of the current request, in the request arena (max_tokens of the resource)
+static struct json_token * http_json_tokens = NULL;
+static uint8_t http_json_tokens_cnt = 0;
+
+// Current request of the handler, and the details of the '400 Bad Request' error message
+static st_http_request * http_request = NULL;
+static const char * http_error_field = NULL;
+static int16_t http_error_pos = -1;
+
+// Resumable handler context of the current request, given by the server (one per socket)
+static st_http_pt * http_pt = NULL;
+
 /*****************************************************************************
  * Public types/enumerations/variables
  ****************************************************************************/
@@ -73,362 +201,696 @@ uint8_t req_resource_ID[MAX_RESOURCE_ID_SIZE];
 /*****************************************************************************
  * Public functions
  ****************************************************************************/
-//uri_table: method / uri / process
-int8_t search_http_resources(uint8_t method, uint8_t * uri)
+void RESTapi_init(void)
+{
+	// Register the built-in resources
+	http_resources_cnt = 0;
+	http_resource_nodes_cnt = 0;
+	reg_http_resources(uri_table);
+}
+
+// Returns the number of registered resources in the table, or RESTAPI_ERROR_TABLE_FULL
+int8_t reg_http_resources(const struct st_http_resource * table)
+{
+	int8_t cnt = 0;
+	const char * seg[MAX_URI_DEPTH];
+	uint8_t seg_len[MAX_URI_DEPTH];
+	
+	for( ; table->uri != NULL; table++)
+	{
+		if(http_resources_cnt >= MAX_HTTP_RESOURCES)
+		{
+			LOG_ERROR1("Resource table full [max: %d]", MAX_HTTP_RESOURCES);
+			return RESTAPI_ERROR_TABLE_FULL;
+		}
+		
+		if(split_http_uri(table->uri, seg, seg_len) == 0)
+		{
+			LOG_ERROR1("Invalid resource URI: %s", table->uri);
+			continue;
+		}
+		
+		if(table->max_tokens > MAX_HTTP_JSON_TOKENS)
+		{
+			LOG_ERROR3("Resource %s: max_tokens %d over the token pool [max: %d]", table->uri, table->max_tokens, MAX_HTTP_JSON_TOKENS);
+			continue;
+		}
+		
+		http_resources[http_resources_cnt++] = table;
+		cnt++;
+	}
+	
+	return cnt;
+}
+
+// Compile the registered resources to the resource nodes; call once after the registration.
+void build_http_resources(void)
 {
-	int8_t ret = RESTAPI_ERROR_RESOURCE_NOT_FOUND;
-	uint8_t i, j;
+	uint8_t i, j, depth;
+	const char * seg[MAX_URI_DEPTH];
+	uint8_t seg_len[MAX_URI_DEPTH];
+	struct st_http_resource_node * node;
+	
+	http_resource_nodes_cnt = 0;
+	http_allow_str_cnt = 0;
+	
+	for(i = 0; i < http_resources_cnt; i++)
+	{
+		depth = split_http_uri(http_resources[i]->uri, seg, seg_len);
+		
+		// ':id' segment: wildcard
+		for(j = 0; j < depth; j++)
+		{
+			if((seg_len[j] == strlen(RESOURCE_ID_MARK)) && (strncmp(seg[j], RESOURCE_ID_MARK, seg_len[j]) == 0)) seg_len[j] = RESOURCE_NODE_WILDCARD;
+		}
+		
+		// Find the node of the same URI; ':id' segments have to be at the same positions (no wildcard matched)
+		node = NULL;
+		for(j = 0; j < http_resource_nodes_cnt; j++)
+		{
+			if(match_http_resource_node(&http_resource_nodes[j], seg, seg_len, depth) == 1)
+			{
+				node = &http_resource_nodes[j];
+				break;
+			}
+		}
+		
+		// New node
+		if(node == NULL)
+		{
+			node = &http_resource_nodes[http_resource_nodes_cnt++];
+			memset(node, 0x00, sizeof(struct st_http_resource_node));
+			
+			node->uri = http_resources[i]->uri;
+			node->depth = depth;
+			for(j = 0; j < depth; j++)
+			{
+				node->seg_offset[j] = seg[j] - node->uri;
+				node->seg_len[j] = seg_len[j];
+			}
+		}
+		
+		// Methods of the node; the first registered resource takes the method
+		for(j = 0; j < HTTP_REQ_METHOD_NUM; j++)
+		{
+			if((http_resources[i]->method & (1 << j)) && !(node->methods & (1 << j)))
+			{
+				node->methods |= (1 << j);
+				node->table_num[j] = i;
+			}
+		}
+	}
 	
-	char * tok_ptr;
-	uint8_t uri_matched = 0;
-	uint8_t uri_matched_count = 0;
-	uint8_t req_uri_depth = 0;
+	// 'Allow' header value of the nodes; OPTIONS is supported by all resources
+	for(i = 0; i < http_resource_nodes_cnt; i++)
+	{
+		http_resource_nodes[i].allow = make_http_allow_str(http_resource_nodes[i].methods | HTTP_REQ_METHOD_OPTIONS);
+	}
 	
-	// Requested URI buf and token ptr
-	char uri_buf[MAX_URI_SIZE/2];
-	char * uri_tok[MAX_URI_DEPTH];
+	LOG_DEBUG2("Resources: %d registered, %d nodes", http_resources_cnt, http_resource_nodes_cnt);
+}
+
+const struct st_http_resource * get_http_resource(uint8_t table_num)
+{
+	if(table_num >= http_resources_cnt) return NULL;
+	return http_resources[table_num];
+}
+
+uint8_t get_http_resources_count(void)
+{
+	return http_resources_cnt;
+}
+
+// Search the resource node of the requested URI
+// methods: bitmask of the methods registered for the requested URI
+// allow: 'Allow' header value of the requested URI (used by OPTIONS / 405 Method Not Allowed)
+int8_t search_http_resources(uint8_t method, uint8_t * uri, uint8_t * methods, const char ** allow)
+{
+	static char allow_buf[HTTP_ALLOW_STR_SIZE];
 	
-	// server resource string buf
-	char resource_buf[MAX_URI_SIZE/2];
+	const struct st_http_resource_node * node = NULL;
+	uint8_t i, depth, match;
+	uint8_t best = 0;
 	
-	// Parse the requested URI
-	strcpy(uri_buf, (char *)uri);
-	tok_ptr = strtok(uri_buf, "/");
-	uri_tok[0] = tok_ptr;
+	// Requested URI token ptr / length
+	const char * uri_tok[MAX_URI_DEPTH];
+	uint8_t uri_tok_len[MAX_URI_DEPTH];
 	
-	if(uri_tok[0] == NULL)
+	*methods = 0;
+	*allow = NULL;
+	
+	depth = split_http_uri((const char *)uri, uri_tok, uri_tok_len);
+	if(depth == 0)
 	{
-#ifdef _RESTAPI_DEBUG_
-		printf("  [Error] URI path NULL\r\n");
-#endif
+		LOG_INFO1("URI path NULL or depth exceeded [max: %d]", MAX_URI_DEPTH);
 		return RESTAPI_ERROR_RESOURCE_NOT_FOUND; // Parse failed
 	}
 	
-	req_uri_depth++;
-	
-	for(i = 1; (tok_ptr = strtok(NULL, "/")) != NULL; i++)
+	// Find the requested resource node; fixed segments take precedence over the ':id'
+	for(i = 0; i < http_resource_nodes_cnt; i++)
 	{
-		if(i >= MAX_URI_DEPTH)
+		match = match_http_resource_node(&http_resource_nodes[i], uri_tok, uri_tok_len, depth);
+		if(match && ((best == 0) || (match < best)))
 		{
-#ifdef _RESTAPI_DEBUG_
-			printf("  [Error] URI path depth exceeded [max: %d]\r\n", MAX_URI_DEPTH);
-#endif
-			req_uri_depth = 0;
-			return RESTAPI_ERROR_RESOURCE_NOT_FOUND; // Parse failed
+			best = match;
+			node = &http_resource_nodes[i];
+			if(best == 1) break; // no wildcard segment
 		}
-		uri_tok[i] = tok_ptr;
-		req_uri_depth++;
 	}
 	
+	if(node == NULL) return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
 	
-#ifdef _RESTAPI_DEBUG_
-	printf("  [Debug] req_uri_depth: %d\r\n", req_uri_depth);
-	for(i = 0; i < MAX_URI_DEPTH; i++)
+	// Token replacement: When the resource token is the ":ID"
+	for(i = 0; i < depth; i++)
 	{
-		if(uri_tok[i] != NULL) printf("  [Debug] uri_tok[%d]: %s\r\n", i, uri_tok[i]);
-		else printf("  [Debug] uri_tok[%d]: %s\r\n", i, "NULL");
+		if(node->seg_len[i] == RESOURCE_NODE_WILDCARD)
+		{
+			memcpy(req_resource_ID, uri_tok[i], uri_tok_len[i]);
+			req_resource_ID[uri_tok_len[i]] = '\0';
+		}
 	}
-#endif
 	
-	// Find the requested resource
-	for(i = 0; uri_table[i].method != NULL; i++)
+	*methods = node->methods;
+	if(node->allow != ALLOW_STR_NONE)
 	{
-		// Parse the registered resource string
-		strcpy(resource_buf, (char *)uri_table[i].uri);
-		tok_ptr = strtok(resource_buf, "/");
-		
-		if(strcmp(uri_tok[0], tok_ptr) == 0) // token matched
-		{
-			uri_matched_count++;
-			for(j = 1; ((tok_ptr = strtok(NULL, "/")) != NULL); j++)
-			{
-				if((uri_tok[j] != NULL) && (strcmp(RESOURCE_ID_MARK, tok_ptr) == 0))
-				{
-					// Token replacement: When the resource token is the ":ID"
-					if(strlen(uri_tok[j]) <= MAX_RESOURCE_ID_SIZE)
-					{
-						strcpy((char *)req_resource_ID, uri_tok[j]);
-						tok_ptr = uri_tok[j];
-					}
-				}
-				
-				if((j >= req_uri_depth) || (strcmp(uri_tok[j], tok_ptr) != 0))
-				{
-					// failed: URI depth or URI token unmatched
-					uri_matched_count = 0;
-					break;
-				}
-				else // URI matches succeeded in depth
-				{
-					uri_matched_count++;
-				}
-			}
-		}
+		*allow = http_allow_str[node->allow];
+	}
+	else
+	{
+		make_http_method_list(allow_buf, node->methods | HTTP_REQ_METHOD_OPTIONS);
+		*allow = allow_buf;
+	}
+	
+	if(!(node->methods & method)) return RESTAPI_ERROR_METHOD_NOT_ALLOWED;
+	
+	LOG_DEBUG1("Requested URI - resource table num %d matched", node->table_num[get_http_method_index(method)]);
+	return node->table_num[get_http_method_index(method)];
+}
+
+int16_t http_resources_handler(st_http_request * p_http_request, uint8_t * buf, uint8_t table_num, uint16_t http_status, st_http_pt * pt, json_flush_func flush, void * ctx)
+{
+	int16_t len = 0;
+	int tokens = 0;
+	
+	set_http_error_detail(NULL, -1);
+	
+	// First call of the handler: a resumable handler starts from its beginning
+	pt->lc = 0;
+	pt->accept = p_http_request->ACCEPT;
+	
+	if((table_num >= http_resources_cnt) || (http_resources[table_num]->process == NULL)) return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
+	if(p_http_request->BODY_TYPE == HTTP_REQ_BODY_TOO_LARGE) return RESTAPI_ERROR_TOO_LARGE;
+	
+	// JSON request body: parsed into the tokens declared by the resource, released with the request
+	http_json_tokens_cnt = 0;
+	if(http_resources[table_num]->max_tokens && (p_http_request->BODY_TYPE == HTTP_REQ_BODY_JSON))
+	{
+		http_json_tokens = (struct json_token *)http_arena_alloc(http_resources[table_num]->max_tokens * sizeof(struct json_token));
+		if(http_json_tokens == NULL) return RESTAPI_ERROR_TOO_LARGE;
 		
-		// string compare
-		if(req_uri_depth == uri_matched_count)
+		len = parse_json_arena((const char *)p_http_request->BODY, p_http_request->BODY_LEN, http_json_tokens, http_resources[table_num]->max_tokens, &tokens);
+		if(len == JSON_TOKEN_ARRAY_TOO_SMALL)
 		{
-			uri_matched = 1;
-			if(uri_table[i].method == method)
-			{
-#ifdef _RESTAPI_DEBUG_
-				printf("  [Debug] Requested URI - resource table num %d matched\r\n", i);
-#endif
-				ret = i;
-				break;
-			}
+			LOG_INFO2("JSON body: %d tokens [max: %d]", tokens, http_resources[table_num]->max_tokens);
+			return RESTAPI_ERROR_TOO_LARGE;
 		}
+		if(len < 0) return RESTAPI_ERROR_BAD_REQUEST;
 		
-		uri_matched_count = 0;
+		http_json_tokens_cnt = tokens;
 	}
 	
-	if((uri_matched == 1) && (ret < 0)) ret = RESTAPI_ERROR_METHOD_NOT_ALLOWED;
+	// Overflow policy of the response writers in this request
+	response_flush = flush;
+	response_flush_ctx = ctx;
+	http_request = p_http_request;
+	http_pt = pt;
 	
-	return ret;
+	len = http_resources[table_num]->process((char* )buf);
+	
+	response_flush = NULL;
+	response_flush_ctx = NULL;
+	http_request = NULL;
+	http_pt = NULL;
+	http_json_tokens = NULL;
+	http_json_tokens_cnt = 0;
+	
+	return len;
 }
 
-int16_t http_resources_handler(st_http_request * p_http_request, uint8_t * buf, uint8_t table_num, uint16_t http_status)
+int16_t http_resources_resume(uint8_t * buf, uint8_t table_num, st_http_pt * pt, json_flush_func flush, void * ctx)
 {
-	uint16_t len = 0;
+	int16_t len;
 	
-	// Todo: PUT update
-	/*
-	uint8_t* ptr = NULL;
+	set_http_error_detail(NULL, -1);
 	
-	if(p_http_request->METHOD == HTTP_REQ_METHOD_PUT)
-	{
-		printf("  [Debug] HTTP PUT Request: body len = %d\r\n", p_http_request->BODY_LEN);
-		printf("  [Debug] HTTP PUT Request: body\r\n");
-		printf("%s\r\n", p_http_request->BODY);
+	if((table_num >= http_resources_cnt) || (http_resources[table_num]->process == NULL)) return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
 	
-		len = uri_table[table_num].process((char* )buf);
-	}
-	*/
+	response_flush = flush;
+	response_flush_ctx = ctx;
+	http_pt = pt;
 	
-	len = uri_table[table_num].process((char* )buf);
+	len = http_resources[table_num]->process((char* )buf);
+	
+	response_flush = NULL;
+	response_flush_ctx = NULL;
+	http_pt = NULL;
 	
 	return len;
 }
 
-int16_t make_http_response_error_message(uint8_t* buf, uint16_t http_status)
+int16_t make_http_response_error_message(uint8_t* buf, uint16_t http_status, uint16_t content_type)
 {
+	st_json_writer w;
 	uint8_t i;
 	int16_t len = 0;
-	char * buf_ptr = (char *)buf;
 	const char * str_ptr = NULL;
 	
 	// Find the HTTP status code
-	for(i = 0; code_table[i].code != NULL; i++)
+	for(i = 0; code_table[i].code != 0; i++)
 	{
 		if(http_status == code_table[i].code)
 		{
 			str_ptr = code_table[i].code_str;
 			str_ptr += 4;
 			
-			len = json_emit(buf_ptr, DATA_BUF_SIZE, "{ s: ", "error");
-			len += json_emit(buf_ptr+len, DATA_BUF_SIZE, "{ s: s, s: i }", "message", str_ptr, "code", http_status);
-			len += json_emit(buf_ptr+len, DATA_BUF_SIZE, " }");
+			json_writer_init(&w, (char *)buf, HTTP_RES_BODY_SIZE, NULL, NULL);
+			if(content_type == HTTP_RES_TYPE_CBOR) json_writer_set_format(&w, JSON_WRITER_FORMAT_CBOR);
+			json_begin_object(&w);
+			json_key(&w, "error");
+			json_begin_object(&w);
+			json_key(&w, "message");
+			json_str(&w, str_ptr);
+			json_key(&w, "code");
+			json_int(&w, http_status);
+			if(http_error_field != NULL)
+			{
+				json_key(&w, "field");
+				json_str(&w, http_error_field);
+			}
+			if(http_error_pos >= 0)
+			{
+				json_key(&w, "position");
+				json_int(&w, http_error_pos);
+			}
+			json_end(&w);
+			json_end(&w);
+			len = json_writer_finish(&w);
 			
 			break;
 		}
 	}
 	
-	return len;
+	set_http_error_detail(NULL, -1);
+	
+	return (len > 0) ? len : 0;
 }	
 
+// JSON request body of the current request: tokens for find_json_token(), NULL if the request has no JSON body
+struct json_token * get_http_json_body(void)
+{
+	if(!http_json_tokens_cnt) return NULL;
+	
+	return http_json_tokens;
+}
+
+int16_t decode_http_body(const struct st_json_field * fields, void * obj)
+{
+	st_json_decode_result res;
+	int8_t ret;
+	
+	if(http_request == NULL) return RESTAPI_ERROR_BAD_REQUEST;
+	
+	if(http_request->BODY_TYPE == HTTP_REQ_BODY_JSON)
+		ret = json_decode((const char *)http_request->BODY, http_request->BODY_LEN, fields, obj, &res);
+	else if(http_request->BODY_TYPE == HTTP_REQ_BODY_CBOR)
+		ret = cbor_decode(http_request->BODY, http_request->BODY_LEN, fields, obj, &res);
+	else
+		return RESTAPI_ERROR_BAD_REQUEST;
+	
+	if(ret < 0)
+	{
+		LOG_INFO2("Request body: error %d at %d", res.error, res.pos);
+		set_http_error_detail((res.field != JSON_DECODE_NO_FIELD) ? fields[res.field].key : NULL, res.pos);
+		return RESTAPI_ERROR_BAD_REQUEST;
+	}
+	
+	return 0;
+}
+
+st_http_pt * get_http_pt(void)
+{
+	return http_pt;
+}
+
+// Response writer of the handler: the buffer (HTTP_RES_BODY_SIZE) is flushed to the socket when full (chunked response)
+void restapi_writer_init(st_json_writer * w, char * buf)
+{
+	json_writer_init(w, buf, HTTP_RES_BODY_SIZE, response_flush, response_flush_ctx);
+	if(http_pt && (http_pt->accept == HTTP_RES_TYPE_CBOR)) json_writer_set_format(w, JSON_WRITER_FORMAT_CBOR);
+}
+
+// Returns the length of the response body remaining in the buffer, or RESTAPI_ERROR_OVERFLOW
+int16_t restapi_writer_end(st_json_writer * w)
+{
+	int16_t len = json_writer_finish(w);
+	
+	if(len < 0) return RESTAPI_ERROR_OVERFLOW;
+	return len;
+}
+
+// Returns the bitmask of the fields requested by '?fields=a,b', HTTP_FIELDS_ALL if not present, or RESTAPI_ERROR_BAD_REQUEST for an unknown field name
+// (RESTAPI_ERROR_TOO_LARGE: request arena full)
+int32_t get_http_fields(const struct st_http_field * fields)
+{
+	uint16_t mark = http_arena_mark();
+	char * str_buf;
+	char * name;
+	uint8_t i;
+	int32_t mask = 0;
+	
+	// Temporary of the request arena: released before the return
+	if((str_buf = (char *)http_arena_alloc(MAX_HTTP_FIELDS_STR)) == NULL) return RESTAPI_ERROR_TOO_LARGE;
+	
+	if(get_http_param_value(HTTP_FIELDS_PARAM, str_buf, MAX_HTTP_FIELDS_STR) <= 0)
+	{
+		http_arena_release(mark);
+		return HTTP_FIELDS_ALL;
+	}
+	
+	for(name = strtok(str_buf, ","); name != NULL; name = strtok(NULL, ","))
+	{
+		while(*name == ' ') name++;
+		
+		for(i = 0; fields[i].name != NULL; i++)
+		{
+			if(!strcmp(name, fields[i].name)) break;
+		}
+		if(fields[i].name == NULL)
+		{
+			mask = RESTAPI_ERROR_BAD_REQUEST;
+			break;
+		}
+		
+		mask |= (1 << i);
+	}
+	
+	http_arena_release(mark);
+	
+	return mask;
+}
+
+// Writes the selected fields as the members of the current object; unrequested fields are skipped
+void emit_http_fields(st_json_writer * w, const struct st_http_field * fields, uint16_t mask, const void* obj)
+{
+	uint8_t i;
+	
+	for(i = 0; fields[i].name != NULL; i++)
+	{
+		if(!(mask & (1 << i))) continue;
+		
+		json_key(w, fields[i].name);
+		fields[i].emit(w, obj);
+	}
+}
+
 /*****************************************************************************
  * Private functions
  ****************************************************************************/
 static int16_t restapi_read_index(char* buf)
 {
-	wiz_NetInfo gWIZNETINFO;
+	st_json_writer w;
+	int32_t fields;
 	
-	uint8_t i, j;
-	uint16_t len;
-	char str_buf[50];
+	if((fields = get_http_fields(index_fields)) < 0) return fields;
 	
-	ctlnetwork(CN_GET_NETINFO, (void*) &gWIZNETINFO);
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	emit_http_fields(&w, index_fields, fields, NULL);
+	json_end(&w);
 	
-	// Target board
-	len = json_emit(buf, DATA_BUF_SIZE, "{ s: s,", "target", "wizwiki-7500eco");
+	return restapi_writer_end(&w);
+}
+
+static void emit_index_target(st_json_writer * w, const void* obj)
+{
+	json_str(w, "wizwiki-7500eco");
+}
+
+// Supported (defined) I/O list
+static void emit_index_io(st_json_writer * w, const void* obj)
+{
+	uint8_t i;
 	
-	// Supported (defined) I/O list
-	len += json_emit(buf+len, DATA_BUF_SIZE, "s: [", "io");
+	json_begin_array(w);
 	for(i = 0; i < USER_IOn; i++)
 	{
-		len += json_emit(buf+len, DATA_BUF_SIZE, "{ s: s, s: s },", RESTAPI_STR_ID, USER_IO_STR[i], "pin", USER_IO_PIN_STR[i]);
+		json_begin_object(w);
+		json_key(w, RESTAPI_STR_ID);
+		json_str(w, USER_IO_STR[i]);
+		json_key(w, "pin");
+		json_str(w, USER_IO_PIN_STR[i]);
+		json_end(w);
 	}
-	len += json_emit(buf+len-1, DATA_BUF_SIZE, " ], ");
-	len--;
+	json_end(w);
+}
+
+// Supported URI (resource) list
+static void emit_index_resource(st_json_writer * w, const void* obj)
+{
+	wiz_NetInfo gWIZNETINFO;
+	
+	const struct st_http_resource * resource;
+	uint8_t i;
+	uint16_t mark;
+	char * str_buf;
+	char * method_buf;
+	
+	ctlnetwork(CN_GET_NETINFO, (void*) &gWIZNETINFO);
 	
-	// Supported URI (resource) list
-	len += json_emit(buf+len, DATA_BUF_SIZE, "s: [", "resource");
+	json_begin_array(w);
 	
-	for(i = 0; uri_table[i].method != NULL; i++)
+	// Registered resources: built-in and user modules
+	for(i = 0; (resource = get_http_resource(i)) != NULL; i++)
 	{
-		for(j = 0; method_table[j].method != NULL; j++)
+		// Temporaries of the request arena, sized by the resource URI: released for each resource
+		mark = http_arena_mark();
+		str_buf = (char *)http_arena_alloc(sizeof("http://255.255.255.255/") + strlen(resource->uri));
+		method_buf = (char *)http_arena_alloc(HTTP_ALLOW_STR_SIZE);
+		if((str_buf == NULL) || (method_buf == NULL))
 		{
-			if(method_table[j].method == uri_table[i].method) break;
+			http_arena_release(mark);
+			break;
 		}
 		
-		sprintf(str_buf, "http://%d.%d.%d.%d/%s", gWIZNETINFO.ip[0], gWIZNETINFO.ip[1], gWIZNETINFO.ip[2], gWIZNETINFO.ip[3], uri_table[i].uri);
-		len += json_emit(buf+len, DATA_BUF_SIZE, "{ s: s, s: s, s: s },", "uri", str_buf, "method", method_table[j].method_str, "description", uri_table[i].description);
+		make_http_method_list(method_buf, resource->method);
+		sprintf(str_buf, "http://%d.%d.%d.%d/%s", gWIZNETINFO.ip[0], gWIZNETINFO.ip[1], gWIZNETINFO.ip[2], gWIZNETINFO.ip[3], resource->uri);
+		
+		json_begin_object(w);
+		json_key(w, "uri");
+		json_str(w, str_buf);
+		json_key(w, "method");
+		json_str(w, method_buf);
+		json_key(w, "description");
+		json_str(w, (resource->description)?resource->description:"");
+		json_end(w);
+		
+		http_arena_release(mark);
 	}
 	
-	len += json_emit(buf+len-1, DATA_BUF_SIZE, " ] }");
-	len--;
-	
-	return len;
+	json_end(w);
 }
 
 static int16_t restapi_read_uptime(char* buf)
 {
-	uint16_t len;
+	st_json_writer w;
+	st_uptime uptime;
 	
-	len = json_emit(buf, DATA_BUF_SIZE, "{ s: ", "uptime");
-	len += json_emit(buf+len, DATA_BUF_SIZE, "{ s: i, s: i, s: i, s: i }", "hour", getDeviceUptime_hour(), "min", getDeviceUptime_min(), "sec", getDeviceUptime_sec(), "msec", getDeviceUptime_msec());
-	len += json_emit(buf+len, DATA_BUF_SIZE, " }");
+	getDeviceUptime(&uptime);
 	
-	return len;
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	json_key(&w, "uptime");
+	json_begin_object(&w);
+		json_key(&w, "hour");
+		json_int(&w, uptime.hour);
+		json_key(&w, "min");
+		json_int(&w, uptime.min);
+		json_key(&w, "sec");
+		json_int(&w, uptime.sec);
+		json_key(&w, "msec");
+		json_int(&w, uptime.msec);
+	json_end(&w);
+	json_end(&w);
+	
+	return restapi_writer_end(&w);
 }
 
 static int16_t restapi_read_netinfo(char* buf)
 {
 	wiz_NetInfo gWIZNETINFO;
 	
-	uint16_t len = 0;
-	char str_buf[18] = {0, };
+	st_json_writer w;
+	int32_t fields;
+	
+	if((fields = get_http_fields(netinfo_fields)) < 0) return fields;
 	
 	ctlnetwork(CN_GET_NETINFO, (void*) &gWIZNETINFO);
 
-	len = json_emit(buf, DATA_BUF_SIZE, "{ s: { ", "netinfo");
-		sprintf(str_buf, "%.2x:%.2x:%.2x:%.2x:%.2x:%.2x", gWIZNETINFO.mac[0], gWIZNETINFO.mac[1], gWIZNETINFO.mac[2], gWIZNETINFO.mac[3], gWIZNETINFO.mac[4], gWIZNETINFO.mac[5]);
-	len += json_emit(buf+len, DATA_BUF_SIZE, "s: s,", "mac", str_buf);
-		sprintf(str_buf, "%d.%d.%d.%d", gWIZNETINFO.ip[0], gWIZNETINFO.ip[1], gWIZNETINFO.ip[2], gWIZNETINFO.ip[3]);
-	len += json_emit(buf+len, DATA_BUF_SIZE, "s: s,", "ip", str_buf);
-		sprintf(str_buf, "%d.%d.%d.%d", gWIZNETINFO.gw[0], gWIZNETINFO.gw[1], gWIZNETINFO.gw[2], gWIZNETINFO.gw[3]);
-	len += json_emit(buf+len, DATA_BUF_SIZE, "s: s,", "gw", str_buf);
-		sprintf(str_buf, "%d.%d.%d.%d", gWIZNETINFO.sn[0], gWIZNETINFO.sn[1], gWIZNETINFO.sn[2], gWIZNETINFO.sn[3]);
-	len += json_emit(buf+len, DATA_BUF_SIZE, "s: s,", "sn", str_buf);
-		sprintf(str_buf, "%d.%d.%d.%d", gWIZNETINFO.dns[0], gWIZNETINFO.dns[1], gWIZNETINFO.dns[2], gWIZNETINFO.dns[3]);
-	len += json_emit(buf+len, DATA_BUF_SIZE, "s: s,", "dns", str_buf);
-	len += json_emit(buf+len, DATA_BUF_SIZE, "s: s", "dhcp", (gWIZNETINFO.dhcp == NETINFO_DHCP)?"enabled":"disabled");
-	len += json_emit(buf+len, DATA_BUF_SIZE, " } }");
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	json_key(&w, "netinfo");
+	json_begin_object(&w);
+	emit_http_fields(&w, netinfo_fields, fields, &gWIZNETINFO);
+	json_end(&w);
+	json_end(&w);
 	
-	return len;
+	return restapi_writer_end(&w);
+}
+
+static void emit_netinfo_mac(st_json_writer * w, const void* obj)
+{
+	const wiz_NetInfo * netinfo = (const wiz_NetInfo *)obj;
+	char str_buf[18] = {0, };
+	
+	sprintf(str_buf, "%.2x:%.2x:%.2x:%.2x:%.2x:%.2x", netinfo->mac[0], netinfo->mac[1], netinfo->mac[2], netinfo->mac[3], netinfo->mac[4], netinfo->mac[5]);
+	json_str(w, str_buf);
+}
+
+static void emit_netinfo_addr(st_json_writer * w, const uint8_t * addr)
+{
+	char str_buf[16] = {0, };
+	
+	sprintf(str_buf, "%d.%d.%d.%d", addr[0], addr[1], addr[2], addr[3]);
+	json_str(w, str_buf);
+}
+
+static void emit_netinfo_ip(st_json_writer * w, const void* obj)  { emit_netinfo_addr(w, ((const wiz_NetInfo *)obj)->ip); }
+static void emit_netinfo_gw(st_json_writer * w, const void* obj)  { emit_netinfo_addr(w, ((const wiz_NetInfo *)obj)->gw); }
+static void emit_netinfo_sn(st_json_writer * w, const void* obj)  { emit_netinfo_addr(w, ((const wiz_NetInfo *)obj)->sn); }
+static void emit_netinfo_dns(st_json_writer * w, const void* obj) { emit_netinfo_addr(w, ((const wiz_NetInfo *)obj)->dns); }
+
+static void emit_netinfo_dhcp(st_json_writer * w, const void* obj)
+{
+	json_str(w, (((const wiz_NetInfo *)obj)->dhcp == NETINFO_DHCP)?"enabled":"disabled");
 }
 
 static int16_t restapi_read_userio(char* buf)
 {
 	struct __user_io_info *user_io_info = (struct __user_io_info *)&(get_DevConfig_pointer()->user_io_info);
 	
+	st_json_writer w;
+	int32_t fields;
 	uint8_t i;
-	uint16_t len = 0;
-	char* type; 
-	char* dir;
+	
+	// '?fields=' selects the members of each io object
+	if((fields = get_http_fields(userio_fields)) < 0) return fields;
+	
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	json_key(&w, "userio");
 	
 	if(user_io_info->user_io_enable == 0)
 	{
-		len = json_emit(buf, DATA_BUF_SIZE, "{ s: s }", "userio", "NULL");
+		json_str(&w, "NULL");
 	}
 	else
 	{
-		len = json_emit(buf, DATA_BUF_SIZE, "{ s: [", "userio");
-		
+		json_begin_array(&w);
 		for(i = 0; i < USER_IOn; i++)
 		{
 			if(get_user_io_enabled(USER_IO_SEL[i]) == IO_ENABLE)
 			{
-				if(get_user_io_type(USER_IO_SEL[i]) == IO_ANALOG_IN) 
-					type = RESTAPI_STR_ANALOG;
-				else
-					type = RESTAPI_STR_DIGITAL;
-				
-				if(get_user_io_direction(USER_IO_SEL[i]) == IO_OUTPUT)
-					dir = RESTAPI_STR_OUTPUT;
-				else
-					dir = RESTAPI_STR_INPUT;
-				
-				len += json_emit(buf+len, DATA_BUF_SIZE, "{ s: s, s: s, s: s },", RESTAPI_STR_ID, USER_IO_STR[i], RESTAPI_STR_TYPE, type, RESTAPI_STR_DIR, dir);
+				json_begin_object(&w);
+				emit_http_fields(&w, userio_fields, fields, &i);
+				json_end(&w);
 			}
 		}
-		len += json_emit(buf+len-1, DATA_BUF_SIZE, " ] }");
-		len--; // Remove the last comma.
+		json_end(&w);
 	}
-	return len;
+	json_end(&w);
+	
+	return restapi_writer_end(&w);
+}
+
+static void emit_userio_id(st_json_writer * w, const void* obj)
+{
+	json_str(w, USER_IO_STR[*(const uint8_t *)obj]);
 }
 
+static void emit_userio_type(st_json_writer * w, const void* obj)
+{
+	if(get_user_io_type(USER_IO_SEL[*(const uint8_t *)obj]) == IO_ANALOG_IN)
+		json_str(w, RESTAPI_STR_ANALOG);
+	else
+		json_str(w, RESTAPI_STR_DIGITAL);
+}
+
+static void emit_userio_dir(st_json_writer * w, const void* obj)
+{
+	if(get_user_io_direction(USER_IO_SEL[*(const uint8_t *)obj]) == IO_OUTPUT)
+		json_str(w, RESTAPI_STR_OUTPUT);
+	else
+		json_str(w, RESTAPI_STR_INPUT);
+}
+
+// Resumable: an analog input not sampled yet (e.g. just configured) is read when its conversion ends, the other sockets
+// are served meanwhile
 static int16_t restapi_read_userio_id(char* buf)
 {
+	st_http_pt * pt = get_http_pt();
+	st_json_writer w;
 	int8_t id_num;
-	uint16_t len = 0;
 	uint16_t val = 0;
 	
+	HTTP_PT_BEGIN(pt);
+	
 	id_num = find_matched_userio_id(req_resource_ID);
 	
-	if(get_user_io_enabled(USER_IO_SEL[id_num]) == IO_DISABLE)
+	if((id_num < 0) || (get_user_io_enabled(USER_IO_SEL[id_num]) == IO_DISABLE))
 	{
 		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
 	}
+	pt->data.u8[0] = (uint8_t)id_num;
 	
-	if(id_num >= 0)
-	{
-		// IO control: Read the io status (digital) or value (analog)
-		get_user_io_val(USER_IO_SEL[id_num], &val);
-		
-		// Generating JSON string
-		len = json_emit(buf, DATA_BUF_SIZE, "{ s: i }", req_resource_ID, val);
-	}
-	else
-	{
-		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
-	}
+	HTTP_PT_WAIT_UNTIL(pt, user_io_val_ready(USER_IO_SEL[pt->data.u8[0]]));
 	
-	return len;
+	HTTP_PT_END(pt);
+	
+	// IO control: Read the io status (digital) or value (analog)
+	get_user_io_val(USER_IO_SEL[pt->data.u8[0]], &val);
+	
+	// Generating JSON string
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	json_key(&w, USER_IO_STR[pt->data.u8[0]]);
+	json_int(&w, val);
+	json_end(&w);
+	
+	return restapi_writer_end(&w);
 }
 
 static int16_t restapi_read_userio_info(char* buf)
 {
+	st_json_writer w;
 	int8_t id_num;
-	uint16_t len = 0;
-	char* type; 
-	char* dir;
+	uint8_t i;
 	
 	id_num = find_matched_userio_id(req_resource_ID);
 	
-	if(get_user_io_enabled(USER_IO_SEL[id_num]) == IO_DISABLE)
+	if((id_num < 0) || (get_user_io_enabled(USER_IO_SEL[id_num]) == IO_DISABLE))
 	{
 		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
 	}
 	
-	if(id_num >= 0)
-	{
-		if(get_user_io_type(USER_IO_SEL[id_num]) == IO_ANALOG_IN) 
-		{
-			type = RESTAPI_STR_ANALOG;
-		}
-		else
-		{
-			type = RESTAPI_STR_DIGITAL;
-		}
-		
-		if(get_user_io_direction(USER_IO_SEL[id_num]) == IO_OUTPUT)
-		{
-			dir = RESTAPI_STR_OUTPUT;
-		}
-		else
-		{
-			dir = RESTAPI_STR_INPUT;
-		}
-		
-		len = json_emit(buf, DATA_BUF_SIZE, "{ s: s, s: s, s: s },", RESTAPI_STR_ID, USER_IO_STR[id_num], RESTAPI_STR_TYPE, type, RESTAPI_STR_DIR, dir);
-	}
-	else
-	{
-		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
-	}
+	// Same members as the io objects of 'userio'
+	i = id_num;
 	
-	return len;
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	emit_http_fields(&w, userio_fields, HTTP_FIELDS_ALL, &i);
+	json_end(&w);
+	
+	return restapi_writer_end(&w);
 }
 
 static int16_t restapi_create_userio_id(char* buf)
@@ -437,41 +899,89 @@ static int16_t restapi_create_userio_id(char* buf)
 	
 	id_num = find_matched_userio_id(req_resource_ID);
 	
-	if(get_user_io_enabled(USER_IO_SEL[id_num]) == IO_ENABLE)
+	if(id_num < 0)
 	{
-		return RESTAPI_ERROR_CONFLICT;
+		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
 	}
 	
-	if(id_num >= 0)
+	if(get_user_io_enabled(USER_IO_SEL[id_num]) == IO_ENABLE)
 	{
-		set_user_io_enable(USER_IO_SEL[id_num], ENABLE);
-		return RESTAPI_RET_CREATED;
+		return RESTAPI_ERROR_CONFLICT;
 	}
-	return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
+	
+	set_user_io_enable(USER_IO_SEL[id_num], ENABLE);
+	return RESTAPI_RET_CREATED;
 }
 
-// IO on/off settings
+// IO on/off settings, digital output only; body: same object as the GET response, e.g., { "a": 1 } (0 / 1 or false / true)
 static int16_t restapi_update_userio_id(char* buf)
 {
-	uint16_t len = 0;
+	struct json_token * body = get_http_json_body();
+	struct json_token * tok;
+	int8_t id_num;
+	uint16_t val;
 	
-	// Todo: PUT update - IO status changes (Digital output only)
-	// buf: HTTP request structure
-	// return: len = 0 (204 No Content)
+	id_num = find_matched_userio_id(req_resource_ID);
 	
-	return len;
+	if((id_num < 0) || (get_user_io_enabled(USER_IO_SEL[id_num]) == IO_DISABLE))
+	{
+		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
+	}
+	
+	if((body == NULL) || ((tok = find_json_token(body, USER_IO_STR[id_num])) == NULL))
+	{
+		set_http_error_detail(USER_IO_STR[id_num], -1);
+		return RESTAPI_ERROR_BAD_REQUEST;
+	}
+	
+	if(tok->type == JSON_TYPE_TRUE) val = IO_HIGH;
+	else if(tok->type == JSON_TYPE_FALSE) val = IO_LOW;
+	else if((tok->type == JSON_TYPE_NUMBER) && (tok->len == 1) && ((tok->ptr[0] == '0') || (tok->ptr[0] == '1'))) val = tok->ptr[0] - '0';
+	else
+	{
+		set_http_error_detail(USER_IO_STR[id_num], (int16_t)(tok->ptr - (const char *)http_request->BODY));
+		return RESTAPI_ERROR_BAD_REQUEST;
+	}
+	
+	// Inputs and analog io: the value is not set
+	if(!set_user_io_val(USER_IO_SEL[id_num], &val)) return RESTAPI_ERROR_CONFLICT;
+	
+	// return: len = 0 (204 No Content)
+	return 0;
 }
 
-// IO type/direction settings
+// IO type/direction settings; members not in the body are not changed
 static int16_t restapi_update_userio_info(char* buf)
 {
-	uint16_t len = 0;
+	struct st_userio_info info;
+	int8_t id_num;
+	int16_t ret;
 	
-	// Todo: PUT update - IO type and direction changes
-	// buf: HTTP request structure
-	// return: len = 0 (204 No Content)
+	id_num = find_matched_userio_id(req_resource_ID);
 	
-	return len;
+	if((id_num < 0) || (get_user_io_enabled(USER_IO_SEL[id_num]) == IO_DISABLE))
+	{
+		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
+	}
+	
+	info.type = get_user_io_type(USER_IO_SEL[id_num]);
+	info.direction = USERIO_DIR_NONE;
+	
+	if((ret = decode_http_body(userio_info_schema, &info)) < 0) return ret;
+	
+	// Analog: input only; the direction follows the type when it is not in the body
+	if(info.direction == USERIO_DIR_NONE) info.direction = (info.type == IO_ANALOG_IN) ? IO_INPUT : get_user_io_direction(USER_IO_SEL[id_num]);
+	if((info.type == IO_ANALOG_IN) && (info.direction == IO_OUTPUT))
+	{
+		set_http_error_detail(RESTAPI_STR_DIR, -1);
+		return RESTAPI_ERROR_BAD_REQUEST;
+	}
+	
+	if(info.type != get_user_io_type(USER_IO_SEL[id_num])) set_user_io_type(USER_IO_SEL[id_num], info.type);
+	if(info.direction != get_user_io_direction(USER_IO_SEL[id_num])) set_user_io_direction(USER_IO_SEL[id_num], info.direction);
+	
+	// return: len = 0 (204 No Content)
+	return 0;
 }
 
 
@@ -482,20 +992,12 @@ static int16_t restapi_delete_userio_id(char* buf)
 	
 	id_num = find_matched_userio_id(req_resource_ID);
 	
-	if(get_user_io_enabled(USER_IO_SEL[id_num]) == IO_DISABLE)
+	if((id_num < 0) || (get_user_io_enabled(USER_IO_SEL[id_num]) == IO_DISABLE))
 	{
 		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
 	}
 	
-	if(id_num >= 0)
-	{
-		set_user_io_enable(USER_IO_SEL[id_num], DISABLE);
-		len = 0;
-	}
-	else
-	{
-		return RESTAPI_ERROR_RESOURCE_NOT_FOUND;
-	}
+	set_user_io_enable(USER_IO_SEL[id_num], DISABLE);
 	
 	return len;
 }
@@ -510,9 +1012,7 @@ static int8_t find_matched_userio_id(uint8_t * req_id)
 		// Search the requested I/O pin
 		if(strcmp((const char *)req_id, USER_IO_STR[i]) == 0)
 		{
-#ifdef _RESTAPI_DEBUG_
-			printf("  [Debug] Request USER_IO : %s (num: %d, code: %.4x)\r\n", USER_IO_STR[i], i, USER_IO_SEL[i]);
-#endif
+			LOG_DEBUG3("Request USER_IO : %s (num: %d, code: %.4x)", USER_IO_STR[i], i, USER_IO_SEL[i]);
 			ret = i;
 			break;
 		}
@@ -520,4 +1020,92 @@ static int8_t find_matched_userio_id(uint8_t * req_id)
 	return ret;
 }
 
+static void set_http_error_detail(const char * field, int16_t pos)
+{
+	http_error_field = field;
+	http_error_pos = pos;
+}
+
+// Split the URI into the segments (no copy); returns the depth, 0: empty URI, depth exceeded or segment too long
+static uint8_t split_http_uri(const char * uri, const char ** seg, uint8_t * seg_len)
+{
+	uint8_t depth = 0;
+	uint16_t len;
+	
+	if(uri == NULL) return 0;
+	
+	while((*uri != '\0') && (*uri != ' ') && (*uri != '?'))
+	{
+		if(*uri == '/')
+		{
+			uri++;
+			continue;
+		}
+		
+		if(depth >= MAX_URI_DEPTH) return 0;
+		
+		for(len = 0; (uri[len] != '\0') && (uri[len] != ' ') && (uri[len] != '?') && (uri[len] != '/'); len++);
+		if(len >= RESOURCE_NODE_WILDCARD) return 0;
+		
+		seg[depth] = uri;
+		seg_len[depth] = len;
+		depth++;
+		
+		uri += len;
+	}
+	
+	return depth;
+}
+
+// Returns 0: unmatched, 1 + the number of the ':id' segments matched
+static uint8_t match_http_resource_node(const struct st_http_resource_node * node, const char ** seg, const uint8_t * seg_len, uint8_t depth)
+{
+	uint8_t i;
+	uint8_t ret = 1;
+	
+	if(node->depth != depth) return 0;
+	
+	for(i = 0; i < depth; i++)
+	{
+		if(node->seg_len[i] == RESOURCE_NODE_WILDCARD)
+		{
+			if(seg_len[i] == RESOURCE_NODE_WILDCARD) continue; // Node build: same ':id' segment
+			if(seg_len[i] >= MAX_RESOURCE_ID_SIZE) return 0;
+			ret++;
+		}
+		else if((node->seg_len[i] != seg_len[i]) || (strncmp(node->uri + node->seg_offset[i], seg[i], seg_len[i]) != 0))
+		{
+			return 0;
+		}
+	}
+	
+	return ret;
+}
+
+// Returns the index of the 'Allow' header value of the methods; the nodes with the same methods share the string
+static uint8_t make_http_allow_str(uint8_t methods)
+{
+	uint8_t i;
+	
+	for(i = 0; i < http_allow_str_cnt; i++)
+	{
+		if(http_allow_methods[i] == methods) return i;
+	}
+	
+	if(http_allow_str_cnt >= MAX_HTTP_ALLOW_STR) return ALLOW_STR_NONE;
+	
+	http_allow_methods[i] = methods;
+	make_http_method_list(http_allow_str[i], methods);
+	http_allow_str_cnt++;
+	
+	return i;
+}
 
+static uint8_t get_http_method_index(uint8_t method)
+{
+	uint8_t i = 0;
+	
+	while((method >>= 1) != 0) i++;
+	
+	return i;
+}
@@ -10,35 +10,105 @@
  */
 
 #ifndef	__RESTAPIHANDLER_H__
-#define	__RESTAPIHANDLER__
+#define	__RESTAPIHANDLER_H__
 
 #include <stdint.h>
 #include "httpParser_rest.h"
+#include "jsonWriter.h"
+#include "jsonDecoder.h"
+#include "httpPt.h"
+#include "frozen.h"
 
-//#define _RESTAPI_DEBUG_
+// Debug messages: LOG_LEVEL_RESTAPI (logHandler.h)
 
 #define MAX_URI_DEPTH           4
 #define MAX_RESOURCE_ID_SIZE    20
 #define RESOURCE_ID_MARK        ":id"
 
+// Resource table capacity: built-in resources + resources registered by the user modules
+#define MAX_HTTP_RESOURCES      24
+
+// 'Allow' header values: one string per method combination, shared by the resource nodes
+#define MAX_HTTP_ALLOW_STR      8
+#define HTTP_ALLOW_STR_SIZE     40      // "GET, HEAD, POST, PUT, DELETE, OPTIONS"
+
+// JSON request body: tokens of the request in the request arena (httpArena.h); resources declare up to this number of tokens (max_tokens)
+#define MAX_HTTP_JSON_TOKENS    16
+
 #define RESTAPI_RET_CREATED                     1
 #define RESTAPI_ERROR                           0
 #define RESTAPI_ERROR_RESOURCE_NOT_FOUND        (RESTAPI_ERROR - 1)
 #define RESTAPI_ERROR_METHOD_NOT_ALLOWED        (RESTAPI_ERROR - 2)
 #define RESTAPI_ERROR_CONFLICT                  (RESTAPI_ERROR - 3)
+#define RESTAPI_ERROR_TABLE_FULL                (RESTAPI_ERROR - 4)
+#define RESTAPI_ERROR_BAD_REQUEST               (RESTAPI_ERROR - 5)
+#define RESTAPI_ERROR_OVERFLOW                  (RESTAPI_ERROR - 6)
+#define RESTAPI_ERROR_TOO_LARGE                 (RESTAPI_ERROR - 7)
+#define RESTAPI_PENDING                         (RESTAPI_ERROR - 8)   // Resumable handler waiting (httpPt.h): no response yet
+
+// Sparse fieldsets: '?fields=name,name' selects the members of the resource representation
+#define HTTP_FIELDS_PARAM       "fields"
+#define HTTP_FIELDS_ALL         0xFFFF  // Up to 16 fields per table
+#define MAX_HTTP_FIELDS_STR     64
 
 
-//{ method, uri, function }
+//{ methods, uri, function, generator, cache, description, max_tokens }
 struct st_http_resource
 {
-	uint8_t method;
+	uint8_t method;            // Bitmask of the HTTP_REQ_METHOD_xxx served by this entry
 	const char* uri;
 	int16_t (*process)(char*);
+	// Optional: streaming response body generator, NULL if not used.
+	// Called repeatedly until it returns 0; writes up to 'size' bytes to 'buf' and keeps its position in '*cursor' (starts from 0)
+	int16_t (*generate)(char* buf, uint16_t size, uint32_t* cursor);
+	uint16_t cache;            // HTTP_CACHE_xxx or max-age (sec.)
 	const char* description;
+	// JSON request body: tokens of the body schema including the end token, e.g., {"value":1} is 4 tokens (object, key, value, end).
+	// 0: the body is not parsed; a body over this number returns '413 Payload Too Large'
+	uint8_t max_tokens;
+	// Content type of the response body (HTTP_RES_TYPE_xxx), e.g., text formats of the body generators.
+	// 0: the REST API representation, JSON or CBOR by the 'Accept' header of the request
+	uint8_t content_type;
+};
+
+//{ name, emit }
+struct st_http_field
+{
+	const char* name;
+	// Writes the JSON value of the field; obj: object of the representation given by the handler
+	void (*emit)(st_json_writer * w, const void* obj);
 };
 
-int8_t search_http_resources(uint8_t method, uint8_t * uri);
-int16_t http_resources_handler(st_http_request * p_http_request, uint8_t * buf, uint8_t table_num, uint16_t http_status);
-int16_t make_http_response_error_message(uint8_t* buf, uint16_t http_status);
+void RESTapi_init(void);
+
+// Resource registration: tables are NULL-terminated and have to be static (not copied)
+int8_t reg_http_resources(const struct st_http_resource * table);
+void build_http_resources(void);
+const struct st_http_resource * get_http_resource(uint8_t table_num);
+uint8_t get_http_resources_count(void);
+
+int8_t search_http_resources(uint8_t method, uint8_t * uri, uint8_t * methods, const char ** allow);
+int16_t http_resources_handler(st_http_request * p_http_request, uint8_t * buf, uint8_t table_num, uint16_t http_status, st_http_pt * pt, json_flush_func flush, void * ctx);
+// Calls the handler returned RESTAPI_PENDING again, from its wait: no request (the handler keeps its state in 'pt')
+int16_t http_resources_resume(uint8_t * buf, uint8_t table_num, st_http_pt * pt, json_flush_func flush, void * ctx);
+int16_t make_http_response_error_message(uint8_t* buf, uint16_t http_status, uint16_t content_type); // HTTP_RES_TYPE_JSON or HTTP_RES_TYPE_CBOR
+
+// JSON request body parsed into the token pool, NULL if the request has no JSON body (valid during the handler call)
+struct json_token * get_http_json_body(void);
+
+// JSON or CBOR request body (Content-Type) decoded into the struct by the schema (jsonDecoder.h); returns 0 or RESTAPI_ERROR_BAD_REQUEST.
+// The error response of the request includes the field and the position of the decode error.
+int16_t decode_http_body(const struct st_json_field * fields, void * obj);
+
+// Context of the resumable handler of the current request (httpPt.h)
+st_http_pt * get_http_pt(void);
+
+// Response body writer of the handlers: restapi_writer_init(&w, buf) ... return restapi_writer_end(&w);
+void restapi_writer_init(st_json_writer * w, char * buf);
+int16_t restapi_writer_end(st_json_writer * w);
+
+// Representation fields: tables are NULL-terminated
+int32_t get_http_fields(const struct st_http_field * fields);
+void emit_http_fields(st_json_writer * w, const struct st_http_field * fields, uint16_t mask, const void* obj);
 
 #endif
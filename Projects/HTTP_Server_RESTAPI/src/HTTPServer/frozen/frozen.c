@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <limits.h>
 #include "frozen.h"
 
 #ifdef _WIN32
@@ -44,6 +45,7 @@ struct frozen {
   int max_tokens;
   int num_tokens;
   int do_realloc;
+  int count_tokens; /* keep counting when the token array is full */
 };
 
 static int parse_object(struct frozen *f);
@@ -129,6 +131,7 @@ static int get_escape_len(const char *s, int len) {
 }
 
 static int capture_ptr(struct frozen *f, const char *ptr, enum json_type type) {
+#ifndef FROZEN_NO_ALLOC
   if (f->do_realloc && f->num_tokens >= f->max_tokens) {
     int new_size = f->max_tokens == 0 ? 100 : f->max_tokens * 2;
     void *p = FROZEN_REALLOC(f->tokens, new_size * sizeof(f->tokens[0]));
@@ -136,16 +139,24 @@ static int capture_ptr(struct frozen *f, const char *ptr, enum json_type type) {
     f->max_tokens = new_size;
     f->tokens = (struct json_token *) p;
   }
+#endif
+  if (f->tokens != NULL && f->num_tokens < f->max_tokens) {
+    f->tokens[f->num_tokens].ptr = ptr;
+    f->tokens[f->num_tokens].type = type;
+    f->num_tokens++;
+    return 0;
+  }
+  if (f->count_tokens) {
+    f->num_tokens++;
+    return 0;
+  }
   if (f->tokens == NULL || f->max_tokens == 0) return 0;
-  if (f->num_tokens >= f->max_tokens) return JSON_TOKEN_ARRAY_TOO_SMALL;
-  f->tokens[f->num_tokens].ptr = ptr;
-  f->tokens[f->num_tokens].type = type;
-  f->num_tokens++;
-  return 0;
+  return JSON_TOKEN_ARRAY_TOO_SMALL;
 }
 
 static int capture_len(struct frozen *f, int token_index, const char *ptr) {
   if (f->tokens == 0 || f->max_tokens == 0) return 0;
+  if (f->count_tokens && token_index >= f->max_tokens) return 0;
   EXPECT(token_index >= 0 && token_index < f->max_tokens, JSON_STRING_INVALID);
   f->tokens[token_index].len = ptr - f->tokens[token_index].ptr;
   f->tokens[token_index].num_desc = (f->num_tokens - 1) - token_index;
@@ -375,6 +386,32 @@ int parse_json(const char *s, int s_len, struct json_token *arr, int arr_len) {
   return frozen.cur - s;
 }
 
+/*
+ * Same as parse_json(), but the whole document is parsed when the token array
+ * is full: *num_tokens receives the exact number of tokens the document needs,
+ * including the JSON_TYPE_EOF token. arr may be NULL to count only.
+ */
+int parse_json_arena(const char *s, int s_len, struct json_token *arr,
+                     int arr_len, int *num_tokens) {
+  struct frozen frozen;
+  int ret;
+
+  memset(&frozen, 0, sizeof(frozen));
+  frozen.end = s + s_len;
+  frozen.cur = s;
+  frozen.tokens = arr;
+  frozen.max_tokens = arr == NULL ? 0 : arr_len;
+  frozen.count_tokens = 1;
+
+  ret = doit(&frozen);
+  if (num_tokens != NULL) *num_tokens = frozen.num_tokens;
+  if (ret < 0) return ret;
+  if (frozen.num_tokens > arr_len) return JSON_TOKEN_ARRAY_TOO_SMALL;
+
+  return frozen.cur - s;
+}
+
+#ifndef FROZEN_NO_ALLOC
 struct json_token *parse_json2(const char *s, int s_len) {
   struct frozen frozen;
 
@@ -389,6 +426,7 @@ struct json_token *parse_json2(const char *s, int s_len) {
   }
   return frozen.tokens;
 }
+#endif
 
 static int path_part_len(const char *p) {
   int i = 0;
@@ -433,20 +471,197 @@ struct json_token *find_json_token(struct json_token *toks, const char *path) {
   return 0;
 }
 
-int json_emit_long(char *buf, int buf_len, long int value) {
-  char tmp[20];
-  int n = snprintf(tmp, sizeof(tmp), "%ld", value);
-  strncpy(buf, tmp, buf_len > 0 ? buf_len : 0);
+/*
+ * Number formatting without snprintf(). Cortex-M0 has no divide instruction,
+ * so n / 10 is done with shifts and adds (Hacker's Delight, divu10).
+ */
+static unsigned long json_divu10(unsigned long n, int *rem) {
+  unsigned long q, r;
+
+  q = (n >> 1) + (n >> 2);
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+#if ULONG_MAX > 0xffffffffUL
+  q += q >> 32;
+#endif
+  q >>= 3;
+  r = n - (((q << 2) + q) << 1);
+  while (r > 9) {
+    q++;
+    r -= 10;
+  }
+  *rem = (int) r;
+  return q;
+}
+
+static int json_count_digits(unsigned long u) {
+  unsigned long p10 = 10;
+  int n = 1;
+
+  while (u >= p10) {
+    n++;
+    if (p10 > ULONG_MAX / 10) break;
+    p10 = (p10 << 3) + (p10 << 1);
+  }
   return n;
 }
 
-int json_emit_double(char *buf, int buf_len, double value) {
-  char tmp[20];
-  int n = snprintf(tmp, sizeof(tmp), "%g", value);
-  strncpy(buf, tmp, buf_len > 0 ? buf_len : 0);
+/* Copies the number formatted in tmp (right-aligned) to the output */
+static int json_emit_tmp(char *buf, int buf_len, const char *p, int n) {
+  if (buf_len > 0) {
+    memcpy(buf, p, n < buf_len ? n : buf_len);
+    if (n < buf_len) {
+      buf[n] = '\0';
+    }
+  }
   return n;
 }
 
+int json_emit_long(char *buf, int buf_len, long int value) {
+  char tmp[24];
+  unsigned long u = value < 0 ? 0UL - (unsigned long) value : (unsigned long) value;
+  int n = json_count_digits(u) + (value < 0 ? 1 : 0);
+  int rem;
+  char *p;
+
+  /* Digits are written straight into the output when the number fits */
+  p = (n < buf_len) ? buf + n : tmp + n;
+  *p = '\0';
+  do {
+    u = json_divu10(u, &rem);
+    *--p = (char) ('0' + rem);
+  } while (u != 0);
+  if (value < 0) *--p = '-';
+
+  return (p == buf) ? n : json_emit_tmp(buf, buf_len, tmp, n);
+}
+
+/*
+ * Fixed-point decimal: value is scaled by 10^decimals,
+ * e.g. json_emit_fixed(buf, len, 3305, 3) -> "3.305" (sensor value in milli-units)
+ */
+int json_emit_fixed(char *buf, int buf_len, long value, int decimals) {
+  char tmp[32];
+  char *p = tmp + sizeof(tmp);
+  unsigned long u = value < 0 ? 0UL - (unsigned long) value : (unsigned long) value;
+  int i = 0, rem;
+
+  if (decimals < 0) decimals = 0;
+  if (decimals > 9) decimals = 9;
+
+  do {
+    if (i == decimals && i > 0) *--p = '.';
+    u = json_divu10(u, &rem);
+    *--p = (char) ('0' + rem);
+    i++;
+  } while (u != 0 || i <= decimals);
+  if (value < 0) *--p = '-';
+
+  return json_emit_tmp(buf, buf_len, p, (int) (tmp + sizeof(tmp) - p));
+}
+
+static double json_pow10(int n) {
+  double p = 1;
+
+  while (n-- > 0) p *= 10;
+  return p;
+}
+
+/*
+ * value * 10^n: steps of 1e8 while |n| > 22, then one power of ten (exact up
+ * to 1e22); 10^n itself overflows for the small numbers (n > 308)
+ */
+static double json_scale10(double value, int n) {
+  while (n > 22) { value *= 1e8; n -= 8; }
+  while (n < -22) { value /= 1e8; n += 8; }
+  return (n >= 0) ? value * json_pow10(n) : value / json_pow10(-n);
+}
+
+/*
+ * Same output as printf("%g"): 6 significant digits, trailing zeros removed,
+ * exponent form if the exponent is < -4 or >= 6 (a tie at the 7th digit may
+ * round up where printf rounds down). Not-a-number and infinity
+ * are not valid JSON numbers and are emitted as null.
+ */
+int json_emit_double(char *buf, int buf_len, double value) {
+  char tmp[24], digits[6];
+  char *p = tmp;
+  double scaled;
+  long m;
+  int e = 0, nd, i, rem;
+
+  if (value != value || value - value != 0) {
+    return json_emit_tmp(buf, buf_len, "null", 4);
+  }
+  if (value < 0) {
+    *p++ = '-';
+    value = -value;
+  }
+  if (value == 0) {
+    *p++ = '0';
+    return json_emit_tmp(buf, buf_len, tmp, (int) (p - tmp));
+  }
+
+  /* Decimal exponent, estimated on a copy */
+  scaled = value;
+  while (scaled >= 1e8) { scaled /= 1e8; e += 8; }
+  while (scaled >= 10) { scaled /= 10; e++; }
+  while (scaled < 1e-7) { scaled *= 1e8; e -= 8; }
+  while (scaled < 1) { scaled *= 10; e--; }
+
+  /*
+   * 6 significant digits, rounded; scaled by one power of ten up to 1e22, in
+   * steps beyond. The estimate is corrected if it is off by one.
+   */
+  for (i = 0; i < 3; i++) {
+    scaled = json_scale10(value, 5 - e);
+    if (scaled >= 1e6) e++;
+    else if (scaled < 1e5) e--;
+    else break;
+  }
+  m = (long) (scaled + 0.5);
+  if (m >= 1000000L) {
+    m = 100000L;
+    e++;
+  }
+  for (i = 5; i >= 0; i--) {
+    m = (long) json_divu10((unsigned long) m, &rem);
+    digits[i] = (char) ('0' + rem);
+  }
+  for (nd = 6; nd > 1 && digits[nd - 1] == '0'; nd--);
+
+  if (e < -4 || e >= 6) {
+    *p++ = digits[0];
+    if (nd > 1) {
+      *p++ = '.';
+      for (i = 1; i < nd; i++) *p++ = digits[i];
+    }
+    *p++ = 'e';
+    *p++ = e < 0 ? '-' : '+';
+    if (e < 0) e = -e;
+    if (e >= 100) {
+      *p++ = (char) ('0' + e / 100);
+      e %= 100;
+    }
+    *p++ = (char) ('0' + e / 10);
+    *p++ = (char) ('0' + e % 10);
+  } else if (e >= 0) {
+    for (i = 0; i <= e; i++) *p++ = i < nd ? digits[i] : '0';
+    if (nd > e + 1) {
+      *p++ = '.';
+      for (i = e + 1; i < nd; i++) *p++ = digits[i];
+    }
+  } else {
+    *p++ = '0';
+    *p++ = '.';
+    for (i = -1; i > e; i--) *p++ = '0';
+    for (i = 0; i < nd; i++) *p++ = digits[i];
+  }
+
+  return json_emit_tmp(buf, buf_len, tmp, (int) (p - tmp));
+}
+
 int json_emit_quoted_str(char *s, int s_len, const char *str, int len) {
   const char *begin = s, *end = s + s_len, *str_end = str + len;
   char ch;
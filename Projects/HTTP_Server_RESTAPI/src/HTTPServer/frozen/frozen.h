@@ -51,11 +51,17 @@ struct json_token {
 
 int parse_json(const char *json_string, int json_string_length,
                struct json_token *tokens_array, int size_of_tokens_array);
+int parse_json_arena(const char *json_string, int json_string_length,
+                     struct json_token *tokens_array, int size_of_tokens_array,
+                     int *num_tokens);
+#ifndef FROZEN_NO_ALLOC
 struct json_token *parse_json2(const char *json_string, int string_length);
+#endif
 struct json_token *find_json_token(struct json_token *toks, const char *path);
 
 int json_emit_long(char *buf, int buf_len, long value);
 int json_emit_double(char *buf, int buf_len, double value);
+int json_emit_fixed(char *buf, int buf_len, long value, int decimals);
 int json_emit_quoted_str(char *buf, int buf_len, const char *str, int len);
 int json_emit_unquoted_str(char *buf, int buf_len, const char *str, int len);
 int json_emit(char *buf, int buf_len, const char *fmt, ...);
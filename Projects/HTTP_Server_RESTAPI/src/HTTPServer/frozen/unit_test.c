@@ -20,14 +20,16 @@
 /*
  * To unit test on Mac system, do
  *
- * g++ unit_test.c -o unit_test -W -Wall -g -O0 -fprofile-arcs -ftest-coverage
- * clang unit_test.c -o unit_test -W -Wall -g -O0 -fprofile-arcs -ftest-coverage
+ * g++ unit_test.c -I. -o unit_test -W -Wall -g -O0 -fprofile-arcs -ftest-coverage
+ * clang unit_test.c -I. -o unit_test -W -Wall -g -O0 -fprofile-arcs -ftest-coverage
  * ./unit_test
  * gcov -a unit_test.c
  */
 
 #include "frozen.c"
+#include "../jsonWriter.c" /* Bounded streaming JSON writer of the HTTP server */
 
+#include <float.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -211,6 +213,39 @@ static const char *test_emit_escapes(void) {
   return NULL;
 }
 
+static char writer_out[100];
+static int writer_out_len = 0;
+
+static int16_t writer_flush(void *ctx, const char *buf, uint16_t len) {
+  (void) ctx;
+  memcpy(writer_out + writer_out_len, buf, len);
+  writer_out_len += len;
+  return len;
+}
+
+static const char *test_writer_escapes(void) {
+  const char *s = "\"a\\u0001\\n\\u001fb\\\"\"";
+  st_json_writer w;
+  char buf[100];
+
+  /* Fast path: the whole string fits in the buffer */
+  json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+  json_strn(&w, "a\x01\n\x1f" "b\"", 6);
+  ASSERT(json_writer_finish(&w) == (int) strlen(s));
+  ASSERT(memcmp(buf, s, strlen(s)) == 0);
+
+  /* Runs flushed through a small buffer */
+  writer_out_len = 0;
+  json_writer_init(&w, buf, 4, writer_flush, NULL);
+  json_strn(&w, "a\x01\n\x1f" "b\"", 6);
+  ASSERT(json_writer_finish(&w) >= 0);
+  writer_flush(NULL, buf, w.len);
+  ASSERT(writer_out_len == (int) strlen(s));
+  ASSERT(memcmp(writer_out, s, strlen(s)) == 0);
+
+  return NULL;
+}
+
 static const char *test_emit(void) {
   char buf[1000], *p = buf;
   const char *s5 = "{\"foo\":[-123,1.23,true]}";
@@ -242,6 +277,43 @@ static const char *test_emit(void) {
   return NULL;
 }
 
+static const char *test_emit_numbers(void) {
+  char buf[100];
+
+  ASSERT(json_emit_long(buf, sizeof(buf), 0) == 1);
+  ASSERT(strcmp(buf, "0") == 0);
+  ASSERT(json_emit_long(buf, sizeof(buf), -2147483647L - 1) == 11);
+  ASSERT(strcmp(buf, "-2147483648") == 0);
+  ASSERT(json_emit_long(buf, 3, 12345) == 5);
+  ASSERT(memcmp(buf, "123", 3) == 0);
+
+  ASSERT(json_emit_fixed(buf, sizeof(buf), 3305, 3) == 5);
+  ASSERT(strcmp(buf, "3.305") == 0);
+  ASSERT(json_emit_fixed(buf, sizeof(buf), -5, 2) == 5);
+  ASSERT(strcmp(buf, "-0.05") == 0);
+  ASSERT(json_emit_fixed(buf, sizeof(buf), 42, 0) == 2);
+  ASSERT(strcmp(buf, "42") == 0);
+
+  json_emit_double(buf, sizeof(buf), 0.0001);
+  ASSERT(strcmp(buf, "0.0001") == 0);
+  json_emit_double(buf, sizeof(buf), 1234567.0);
+  ASSERT(strcmp(buf, "1.23457e+06") == 0);
+  json_emit_double(buf, sizeof(buf), -2.5e-300);
+  ASSERT(strcmp(buf, "-2.5e-300") == 0);
+  json_emit_double(buf, sizeof(buf), 1e-305);
+  ASSERT(strcmp(buf, "1e-305") == 0);
+  json_emit_double(buf, sizeof(buf), DBL_MIN);
+  ASSERT(strcmp(buf, "2.22507e-308") == 0);
+  json_emit_double(buf, sizeof(buf), 1.5e-310); /* Subnormal */
+  ASSERT(strcmp(buf, "1.5e-310") == 0);
+  json_emit_double(buf, sizeof(buf), 4.9e-324); /* Smallest subnormal */
+  ASSERT(strcmp(buf, "4.94066e-324") == 0);
+  json_emit_double(buf, sizeof(buf), DBL_MAX);
+  ASSERT(strcmp(buf, "1.79769e+308") == 0);
+
+  return NULL;
+}
+
 static const char *test_nested(void) {
   struct json_token ar[100];
   const char *s = "{ a : [ [1, 2, { b : 2 } ] ] }";
@@ -264,6 +336,34 @@ static const char *test_nested(void) {
   return NULL;
 }
 
+static const char *test_arena(void) {
+  struct json_token ar[10];
+  const char *s = "{ \"type\": \"digital\", \"direction\": \"output\" }";
+  int n = -1;
+
+  /* Demand: object, 4 strings, EOF */
+  ASSERT(parse_json_arena(s, strlen(s), NULL, 0, &n) ==
+         JSON_TOKEN_ARRAY_TOO_SMALL);
+  ASSERT(n == 6);
+  n = -1;
+  ASSERT(parse_json_arena(s, strlen(s), ar, 3, &n) ==
+         JSON_TOKEN_ARRAY_TOO_SMALL);
+  ASSERT(n == 6);
+  ASSERT(parse_json_arena(s, strlen(s), ar, 6, &n) == (int) strlen(s));
+  ASSERT(n == 6);
+  ASSERT(ar[5].type == JSON_TYPE_EOF);
+  ASSERT(find_json_token(ar, "direction") == &ar[4]);
+  ASSERT(ar[0].num_desc == 4);
+
+  /* Syntax errors are reported before the token demand */
+  ASSERT(parse_json_arena("{ a: [1, 2", 10, ar, 2, &n) ==
+         JSON_STRING_INCOMPLETE);
+  ASSERT(parse_json_arena("{ a: 1 ]", 8, ar, 2, &n) == JSON_STRING_INVALID);
+
+  return NULL;
+}
+
+#ifndef FROZEN_NO_ALLOC
 static const char *test_realloc(void) {
   struct json_token *p;
   ASSERT(parse_json2("{ foo: 2 }", 2) == NULL);
@@ -271,15 +371,21 @@ static const char *test_realloc(void) {
   free(p);
   return NULL;
 }
+#endif
 
 static const char *run_all_tests(void) {
   RUN_TEST(test_errors);
   RUN_TEST(test_config);
   RUN_TEST(test_emit);
   RUN_TEST(test_emit_escapes);
+  RUN_TEST(test_writer_escapes);
+  RUN_TEST(test_emit_numbers);
   RUN_TEST(test_emit_overflow);
   RUN_TEST(test_nested);
+  RUN_TEST(test_arena);
+#ifndef FROZEN_NO_ALLOC
   RUN_TEST(test_realloc);
+#endif
   return NULL;
 }
 
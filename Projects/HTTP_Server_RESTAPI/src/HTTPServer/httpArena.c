@@ -0,0 +1,81 @@
+/**
+ * @file	httpArena.c
+ * @brief	HTTP Server - Request arena: scratch memory of the request being processed
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#include <stddef.h>
+
+#include "httpArena.h"
+
+#define LOG_MODULE			LOG_MODULE_HTTPSERVER
+#define LOG_MODULE_LEVEL	LOG_LEVEL_HTTPSERVER
+#include "logHandler.h"
+
+// Host build with AddressSanitizer: the free part of the pool is poisoned, so the overflows of a block are reported
+#if defined(__SANITIZE_ADDRESS__)
+	#include <sanitizer/asan_interface.h>
+	#define HTTP_ARENA_POISON(addr, size)	ASAN_POISON_MEMORY_REGION((addr), (size))
+	#define HTTP_ARENA_UNPOISON(addr, size)	ASAN_UNPOISON_MEMORY_REGION((addr), (size))
+#else
+	#define HTTP_ARENA_POISON(addr, size)
+	#define HTTP_ARENA_UNPOISON(addr, size)
+#endif
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+static void * http_arena_pool[HTTP_ARENA_SIZE / HTTP_ARENA_ALIGN];	// Aligned to HTTP_ARENA_ALIGN
+static uint16_t http_arena_top = 0;
+static uint16_t http_arena_high = 0;
+static uint32_t http_arena_fails = 0;
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+void * http_arena_alloc(uint16_t size)
+{
+	uint8_t * block;
+	uint16_t aligned = (uint16_t)((size + (HTTP_ARENA_ALIGN - 1)) & ~(HTTP_ARENA_ALIGN - 1));
+
+	if((aligned < size) || (aligned > (HTTP_ARENA_SIZE - http_arena_top)))
+	{
+		http_arena_fails++;
+		LOG_WARN2("Request arena full: %d bytes [used: %d]", size, http_arena_top);
+		return NULL;
+	}
+
+	block = (uint8_t *)http_arena_pool + http_arena_top;
+	http_arena_top += aligned;
+	if(http_arena_top > http_arena_high) http_arena_high = http_arena_top;
+
+	HTTP_ARENA_UNPOISON(block, size);
+
+	return block;
+}
+
+uint16_t http_arena_mark(void)
+{
+	return http_arena_top;
+}
+
+void http_arena_release(uint16_t mark)
+{
+	if(mark >= http_arena_top) return;
+
+	http_arena_top = mark;
+	HTTP_ARENA_POISON((uint8_t *)http_arena_pool + mark, HTTP_ARENA_SIZE - mark);
+}
+
+void get_http_arena_stats(st_http_arena_stats * stats)
+{
+	stats->size = HTTP_ARENA_SIZE;
+	stats->used = http_arena_top;
+	stats->high = http_arena_high;
+	stats->fails = http_arena_fails;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file	httpArena.h
+ * @brief	Header File for HTTP Server - Request arena: scratch memory of the request being processed
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#ifndef	__HTTPARENA_H__
+#define	__HTTPARENA_H__
+
+#include <stdint.h>
+
+// Bump allocator on one static pool, for the memory of one request: the parsed request and its URI (parser), the
+// resource name (router), the JSON body tokens and the temporaries of the handlers. Released all at once when the
+// request has been processed, or back to a mark by the user of a temporary; no free of single blocks.
+// The requests are processed one at a time (httpServer_run()); a resumable handler (httpPt.h) keeps nothing in the
+// arena across its waits
+#ifndef HTTP_ARENA_SIZE
+	#define HTTP_ARENA_SIZE		1280	// Longest URI (MAX_URI_SIZE) with its resource name, and the token pool of the body
+#endif
+
+#define HTTP_ARENA_ALIGN		sizeof(void *)	// Blocks hold pointers: 4 bytes on the Cortex-M0, 8 on 64-bit host builds
+
+typedef struct _st_http_arena_stats
+{
+	uint16_t size;
+	uint16_t used;			// Allocated now
+	uint16_t high;			// High-water mark since the boot: size the pool from it
+	uint32_t fails;			// Allocations refused: the pool was full
+} st_http_arena_stats;
+
+// Block of 'size' bytes (aligned to HTTP_ARENA_ALIGN), NULL if the pool is full; not initialized
+void * http_arena_alloc(uint16_t size);
+
+// Mark: the allocations made after it are released together by http_arena_release()
+uint16_t http_arena_mark(void);
+void http_arena_release(uint16_t mark);
+
+// End of the request: the whole pool
+#define http_arena_reset()		http_arena_release(0)
+
+void get_http_arena_stats(st_http_arena_stats * stats);
+
+#endif
@@ -0,0 +1,276 @@
+/**
+ * @file	httpDiag.c
+ * @brief	HTTP Server - Diagnostic resources ('/diag/...')
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#include <stddef.h>
+
+#include "traceHandler.h"
+#include "wdtHandler.h"
+#include "crashHandler.h"
+#include "memHandler.h"
+
+#include "httpParser_rest.h"
+#include "httpArena.h"
+#include "RESTapiHandler.h"
+#include "httpDiag.h"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+static int16_t diag_read_watchdog(char* buf);             // [GET] Watchdog supervisor: subsystems and the last reset
+static int16_t diag_read_crash(char* buf);                // [GET] Capture of the last HardFault
+static int16_t diag_read_memory(char* buf);               // [GET] Static RAM and stack high-water marks
+
+static void diag_hex(char * dst, const uint8_t * src, uint16_t len);
+static void diag_reg(st_json_writer * w, const char * key, uint32_t val);
+
+// Trace records of the crash capture: drained stream (traceHandler.h), in hex
+#define DIAG_CRASH_TRACE_SIZE	(TRACE_HEADER_SIZE + (CRASH_TRACE_EVENTS * sizeof(st_trace_event)))
+
+static const struct st_http_resource diag_table[] = 
+{
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "diag/trace",    NULL,               trace_generate, HTTP_CACHE_NO_STORE, "trace events, binary (host/tracedump)",           0, HTTP_RES_TYPE_BINARY },
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "diag/watchdog", diag_read_watchdog, NULL,           HTTP_CACHE_NO_STORE, "watchdog supervisor: subsystems, last reset cause", 0, 0 },
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "diag/crash",    diag_read_crash,    NULL,           HTTP_CACHE_NO_STORE, "last HardFault capture (host/crashsym)",          0, 0 },
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "diag/memory",   diag_read_memory,   NULL,           HTTP_CACHE_NO_STORE, "static RAM, stack high-water marks",              0, 0 },
+	
+	{ 0, NULL, NULL, NULL, 0, NULL, 0, 0 } // Last item: uri set to NULL
+};
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+int8_t http_diag_init(void)
+{
+	return reg_http_resources(diag_table);
+}
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+// { "timeout_ms": 2000, "resets": 1, "subsystems": [ { "name": "http", "deadline_ms": 1000, "age_ms": 4, "checkins": 1234 }, ... ],
+//   "last_reset": { "subsystem": "io", "task": "http", "late_ms": 1100, "uptime_ms": 52000 } }, "last_reset": null if not reset by the supervisor
+static int16_t diag_read_watchdog(char* buf)
+{
+	st_json_writer w;
+	const st_wdt_subsys * subsys;
+	const st_wdt_record * last = get_wdt_last_reset();
+	uint32_t now = get_wdt_tick();
+	uint8_t i;
+	
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	json_key(&w, "timeout_ms");
+	json_int(&w, WDT_TIMEOUT_MSEC);
+	json_key(&w, "resets");
+	json_int(&w, get_wdt_resets());
+	
+	json_key(&w, "subsystems");
+	json_begin_array(&w);
+	for(i = 0; i < get_wdt_subsys_count(); i++)
+	{
+		subsys = get_wdt_subsys(i);
+		json_begin_object(&w);
+		json_key(&w, "name");
+		json_str(&w, subsys->name);
+		json_key(&w, "deadline_ms");
+		json_int(&w, subsys->deadline);
+		json_key(&w, "age_ms");
+		json_int(&w, now - subsys->last);
+		json_key(&w, "checkins");
+		json_int(&w, subsys->checkins);
+		json_end(&w);
+	}
+	json_end(&w);
+	
+	json_key(&w, "last_reset");
+	if(last != NULL)
+	{
+		json_begin_object(&w);
+		json_key(&w, "subsystem");
+		json_str(&w, last->subsys);
+		json_key(&w, "task");
+		if(last->task[0] != '\0') json_str(&w, last->task);
+		else json_null(&w);
+		json_key(&w, "late_ms");
+		json_int(&w, last->late);
+		json_key(&w, "uptime_ms");
+		json_int(&w, last->uptime);
+		json_end(&w);
+	}
+	else json_null(&w);
+	
+	json_end(&w);
+	
+	return restapi_writer_end(&w);
+}
+
+// { "crash": { "pc": "0x000012A4", "lr": "0x00000F31", "sp": "0x20003E80", "xpsr": "0x01000003", "exc_return": "0xFFFFFFF9",
+//   "r0": ..., "r1": ..., "r2": ..., "r3": ..., "r12": ..., "task": "http", "socket": 1, "http_state": 2, "stack_free": 1024,
+//   "isr_stack_free": 320, "uptime_ms": 52000, "trace": "575a5452..." } }, "crash": null if no HardFault before this boot
+static int16_t diag_read_crash(char* buf)
+{
+	st_json_writer w;
+	const st_crash_record * last = get_crash_last();
+	char * trace;
+	int16_t len;
+	
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	json_key(&w, "crash");
+	if(last != NULL)
+	{
+		json_begin_object(&w);
+		diag_reg(&w, "pc", last->pc);
+		diag_reg(&w, "lr", last->lr);
+		diag_reg(&w, "sp", last->sp);
+		diag_reg(&w, "xpsr", last->xpsr);
+		diag_reg(&w, "exc_return", last->exc_return);
+		diag_reg(&w, "r0", last->r0);
+		diag_reg(&w, "r1", last->r1);
+		diag_reg(&w, "r2", last->r2);
+		diag_reg(&w, "r3", last->r3);
+		diag_reg(&w, "r12", last->r12);
+		json_key(&w, "task");
+		if(last->task[0] != '\0') json_str(&w, last->task);
+		else json_null(&w);
+		json_key(&w, "socket");
+		if(last->sock != CRASH_SOCK_NONE)
+		{
+			json_int(&w, last->sock);
+			json_key(&w, "http_state");
+			json_int(&w, last->http_state);
+		}
+		else json_null(&w);
+		json_key(&w, "stack_free");
+		json_int(&w, last->stack_free);
+		json_key(&w, "isr_stack_free");
+		json_int(&w, last->isr_stack_free);
+		json_key(&w, "uptime_ms");
+		json_int(&w, last->uptime);
+		
+		// Stream encoded in the upper half of the buffer (request arena), then expanded to hex from the start
+		json_key(&w, "trace");
+		if((trace = (char *)http_arena_alloc(DIAG_CRASH_TRACE_SIZE * 2)) != NULL)
+		{
+			len = trace_encode(trace + DIAG_CRASH_TRACE_SIZE, DIAG_CRASH_TRACE_SIZE, last->trace, last->trace_cnt, last->trace_seq);
+			diag_hex(trace, (const uint8_t *)(trace + DIAG_CRASH_TRACE_SIZE), len);
+			json_strn(&w, trace, len * 2);
+		}
+		else json_null(&w);
+		json_end(&w);
+	}
+	else json_null(&w);
+	
+	json_end(&w);
+	
+	return restapi_writer_end(&w);
+}
+
+// { "ram": { "data": 120, "bss": 9800, "stack": 2048, "heap": 1024, "noinit": 216, "free": 2900 },
+//   "stacks": [ { "name": "main", "size": 1536, "used": 900, "free": 636 }, { "name": "isr", "size": 512, "used": 180, "free": 332 } ],
+//   "arena": { "size": 1280, "used": 36, "high_water": 420, "failures": 0 } }
+// Per module static RAM: host/ramsize on the link map
+static int16_t diag_read_memory(char* buf)
+{
+	static const char * const stack_names[MEM_STACK_CNT] = { "main", "isr" }; // MEM_STACK_xxx
+	st_json_writer w;
+	st_mem_ram ram;
+	st_http_arena_stats arena;
+	uint32_t size, left;
+	uint8_t i;
+	
+	get_mem_ram(&ram);
+	get_http_arena_stats(&arena);
+	
+	restapi_writer_init(&w, buf);
+	json_begin_object(&w);
+	json_key(&w, "ram");
+	json_begin_object(&w);
+	json_key(&w, "data");
+	json_int(&w, ram.data);
+	json_key(&w, "bss");
+	json_int(&w, ram.bss);
+	json_key(&w, "stack");
+	json_int(&w, ram.stack);
+	json_key(&w, "heap");
+	json_int(&w, ram.heap);
+	json_key(&w, "noinit");
+	json_int(&w, ram.noinit);
+	json_key(&w, "free");
+	json_int(&w, ram.free);
+	json_end(&w);
+	
+	json_key(&w, "stacks");
+	json_begin_array(&w);
+	for(i = 0; i < MEM_STACK_CNT; i++)
+	{
+		size = get_stack_size(i);
+		left = get_stack_free(i);
+		json_begin_object(&w);
+		json_key(&w, "name");
+		json_str(&w, stack_names[i]);
+		json_key(&w, "size");
+		json_int(&w, size);
+		json_key(&w, "used");
+		json_int(&w, size - left);
+		json_key(&w, "free");
+		json_int(&w, left);
+		json_end(&w);
+	}
+	json_end(&w);
+	
+	// Request arena (httpArena.h): scratch memory of the requests
+	json_key(&w, "arena");
+	json_begin_object(&w);
+	json_key(&w, "size");
+	json_int(&w, arena.size);
+	json_key(&w, "used");
+	json_int(&w, arena.used);
+	json_key(&w, "high_water");
+	json_int(&w, arena.high);
+	json_key(&w, "failures");
+	json_int(&w, arena.fails);
+	json_end(&w);
+	
+	json_end(&w);
+	
+	return restapi_writer_end(&w);
+}
+
+// In place if 'src' is the upper half of 'dst': byte i is read before the digits 2i and 2i+1 are written
+static void diag_hex(char * dst, const uint8_t * src, uint16_t len)
+{
+	static const char digits[] = "0123456789abcdef";
+	uint8_t val;
+	uint16_t i;
+	
+	for(i = 0; i < len; i++)
+	{
+		val = src[i];
+		dst[i * 2] = digits[val >> 4];
+		dst[(i * 2) + 1] = digits[val & 0x0F];
+	}
+}
+
+// Register: "0x%08X"
+static void diag_reg(st_json_writer * w, const char * key, uint32_t val)
+{
+	static const char digits[] = "0123456789ABCDEF";
+	char str[10];
+	uint8_t i;
+	
+	str[0] = '0';
+	str[1] = 'x';
+	for(i = 0; i < 8; i++) str[2 + i] = digits[(val >> (28 - (i * 4))) & 0x0F];
+	
+	json_key(w, key);
+	json_strn(w, str, sizeof(str));
+}
@@ -0,0 +1,24 @@
+/**
+ * @file	httpDiag.h
+ * @brief	Header File for HTTP Server - Diagnostic resources ('/diag/...')
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#ifndef	__HTTPDIAG_H__
+#define	__HTTPDIAG_H__
+
+#include <stdint.h>
+
+// Registers the diagnostic resources: after RESTapi_init(), before httpServer_init()
+//  - '/diag/trace': the trace ring (traceHandler.h), binary; decoded by host/tracedump
+//  - '/diag/watchdog': the subsystems of the watchdog supervisor and the cause of the last reset (wdtHandler.h), JSON
+//  - '/diag/crash': the capture of the last HardFault (crashHandler.h), JSON; symbolised by host/crashsym
+//  - '/diag/memory': the static RAM, the high-water marks of the stacks (memHandler.h) and of the request arena (httpArena.h), JSON
+int8_t http_diag_init(void);
+
+#endif
@@ -0,0 +1,451 @@
+/**
+ * @file	httpMetrics.c
+ * @brief	HTTP Server - Metrics resource in the Prometheus text exposition format
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#include <string.h>
+
+#include "wizchip_conf.h"
+#include "socket.h"
+#include "timerHandler.h"
+#include "gpioHandler.h"
+#include "uartHandler.h"
+#include "schedHandler.h"
+
+#include "httpParser_rest.h"
+#include "httpServer_rest.h"
+#include "RESTapiHandler.h"
+#include "httpStats.h"
+#include "httpMetrics.h"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+// Samples of a metric family: one, one per HTTP socket, one per route (resources, then the unmatched requests),
+// one per status code, one histogram per route, or one per scheduler task (then the idle pseudo-task)
+#define METRICS_SCOPE_DEVICE	0
+#define METRICS_SCOPE_SOCKET	1
+#define METRICS_SCOPE_ROUTE		2
+#define METRICS_SCOPE_STATUS	3
+#define METRICS_SCOPE_HISTOGRAM	4
+#define METRICS_SCOPE_TASK		5
+
+// Histogram samples of a route: the buckets but the last one (le), +Inf, _sum and _count
+#define METRICS_HIST_SAMPLES	(HTTP_STATS_BUCKETS + 2)
+
+enum
+{
+	METRIC_UPTIME,
+	METRIC_LOOPS,
+	METRIC_LOOP_RATE,
+	METRIC_ADC,
+	METRIC_UART_DROPPED,
+	METRIC_SOCK_STATE,
+	METRIC_SOCK_STATUS,
+	METRIC_SOCK_TX_FREE,
+	METRIC_SOCK_RX_RECV,
+	METRIC_SOCK_CONNECTIONS,
+	METRIC_SOCK_OPENS,
+	METRIC_SOCK_REAPED,
+	METRIC_ROUTE_REQUESTS,
+	METRIC_ROUTE_ERRORS,
+	METRIC_ROUTE_BYTES_IN,
+	METRIC_ROUTE_BYTES_OUT,
+	METRIC_STATUS_RESPONSES,
+	METRIC_ROUTE_DURATION,
+	METRIC_TASK_RUNS,
+	METRIC_TASK_TIME,
+	METRIC_TASK_MAX
+};
+
+struct st_metric_family
+{
+	uint8_t id;
+	uint8_t scope;
+	const char* name;
+	const char* type;
+	const char* help;
+};
+
+static const struct st_metric_family metric_families[] =
+{
+	{ METRIC_UPTIME,           METRICS_SCOPE_DEVICE,    "device_uptime_seconds",              "gauge",     "Time since the device started" },
+	{ METRIC_LOOPS,            METRICS_SCOPE_DEVICE,    "main_loop_iterations_total",         "counter",   "Passes of the HTTP server task over its sockets" },
+	{ METRIC_LOOP_RATE,        METRICS_SCOPE_DEVICE,    "main_loop_iterations_per_second",    "gauge",     "Passes of the HTTP server task in the last second" },
+	{ METRIC_ADC,              METRICS_SCOPE_DEVICE,    "adc_conversions_total",              "counter",   "ADC conversions of the analog inputs" },
+	{ METRIC_UART_DROPPED,     METRICS_SCOPE_DEVICE,    "uart_tx_dropped_bytes_total",        "counter",   "Debug UART output dropped, TX ring full" },
+	{ METRIC_SOCK_STATE,       METRICS_SCOPE_SOCKET,    "http_socket_state",                  "gauge",     "HTTP process state of the socket (STATE_HTTP_xxx)" },
+	{ METRIC_SOCK_STATUS,      METRICS_SCOPE_SOCKET,    "wiz_socket_status",                  "gauge",     "Socket status register Sn_SR of the TCP/IP core" },
+	{ METRIC_SOCK_TX_FREE,     METRICS_SCOPE_SOCKET,    "wiz_socket_tx_free_bytes",           "gauge",     "Free space of the socket TX buffer (Sn_TX_FSR)" },
+	{ METRIC_SOCK_RX_RECV,     METRICS_SCOPE_SOCKET,    "wiz_socket_rx_received_bytes",       "gauge",     "Received data in the socket RX buffer (Sn_RX_RSR)" },
+	{ METRIC_SOCK_CONNECTIONS, METRICS_SCOPE_SOCKET,    "http_socket_connections_total",      "counter",   "TCP connections established on the socket" },
+	{ METRIC_SOCK_OPENS,       METRICS_SCOPE_SOCKET,    "http_socket_opens_total",            "counter",   "Server socket (re)opens after a close or a reset" },
+	{ METRIC_SOCK_REAPED,      METRICS_SCOPE_SOCKET,    "http_socket_reaped_total",           "counter",   "Connections closed by the reaper, no request in time" },
+	{ METRIC_ROUTE_REQUESTS,   METRICS_SCOPE_ROUTE,     "http_requests_total",                "counter",   "Requests by resource" },
+	{ METRIC_ROUTE_ERRORS,     METRICS_SCOPE_ROUTE,     "http_request_errors_total",          "counter",   "4xx / 5xx responses and cut responses, by resource" },
+	{ METRIC_ROUTE_BYTES_IN,   METRICS_SCOPE_ROUTE,     "http_request_bytes_total",           "counter",   "Request bytes received by resource" },
+	{ METRIC_ROUTE_BYTES_OUT,  METRICS_SCOPE_ROUTE,     "http_response_bytes_total",          "counter",   "Response bytes sent by resource" },
+	{ METRIC_STATUS_RESPONSES, METRICS_SCOPE_STATUS,    "http_responses_total",               "counter",   "Responses by status code" },
+	{ METRIC_ROUTE_DURATION,   METRICS_SCOPE_HISTOGRAM, "http_request_duration_seconds",      "histogram", "From the first byte of the request to the last byte of the response" },
+	{ METRIC_TASK_RUNS,        METRICS_SCOPE_TASK,      "sched_task_runs_total",              "counter",   "Runs of the main loop task (idle: sleeps)" },
+	{ METRIC_TASK_TIME,        METRICS_SCOPE_TASK,      "sched_task_run_seconds_total",       "counter",   "Run time of the main loop task (idle: time asleep)" },
+	{ METRIC_TASK_MAX,         METRICS_SCOPE_TASK,      "sched_task_run_max_seconds",         "gauge",     "Longest run of the main loop task" },
+
+	{ 0, 0, NULL, NULL, NULL } // Last item should be set to NULL
+};
+
+static const struct st_http_resource metrics_table[] = 
+{
+	{ HTTP_REQ_METHOD_GET | HTTP_REQ_METHOD_HEAD, "metrics", NULL, http_metrics_generate, HTTP_CACHE_NO_STORE, "metrics, prometheus text format", 0, HTTP_RES_TYPE_PROMETHEUS },
+	
+	{ 0, NULL, NULL, NULL, 0, NULL, 0, 0 } // Last item: uri set to NULL
+};
+
+static const char* const metric_methods[] = { "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", NULL }; // HTTP_REQ_METHOD_xxx bits
+
+static volatile uint32_t loop_cnt = 0;
+static volatile uint32_t loop_cnt_last = 0;
+static volatile uint32_t loop_rate = 0;
+
+extern struct st_http_info httpserver;
+extern st_http_socket HTTPSock[];
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+static uint16_t metric_put_str(char* line, uint16_t len, const char* str);
+static uint16_t metric_put_uint(char* line, uint16_t len, uint32_t val);
+static uint16_t metric_put_fixed(char* line, uint16_t len, uint32_t val, uint8_t decimals);
+static uint16_t metric_put_seconds(char* line, uint16_t len, uint32_t sec, uint32_t usec);
+static uint16_t metric_put_route(char* line, uint16_t len, uint8_t route);
+static uint16_t metric_samples(uint8_t scope);
+static uint16_t metric_line(char* line, uint32_t num);
+static uint16_t metric_sample(char* line, const struct st_metric_family* family, uint16_t index);
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+int8_t http_metrics_init(void)
+{
+	return reg_http_resources(metrics_table);
+}
+
+int16_t http_metrics_generate(char* buf, uint16_t size, uint32_t* cursor)
+{
+	char line[HTTP_METRICS_LINE_MAX];
+	uint16_t len = 0;
+	uint16_t n;
+
+	// Whole lines only: the line which does not fit is rendered again for the next chunk
+	while((n = metric_line(line, *cursor)) > 0)
+	{
+		if((uint32_t)len + n > size) break;
+
+		memcpy(buf + len, line, n);
+		len += n;
+		(*cursor)++;
+	}
+
+	return len;
+}
+
+void http_metrics_loop(void)
+{
+	loop_cnt++;
+}
+
+void http_metrics_time_handler(void)
+{
+	uint32_t cnt = loop_cnt;
+
+	loop_rate = cnt - loop_cnt_last;
+	loop_cnt_last = cnt;
+}
+
+////////////////////////////////////////////
+// Private Functions
+////////////////////////////////////////////
+static uint16_t metric_put_str(char* line, uint16_t len, const char* str)
+{
+	while(*str && (len < HTTP_METRICS_LINE_MAX - 1)) line[len++] = *str++;
+
+	return len;
+}
+
+static uint16_t metric_put_uint(char* line, uint16_t len, uint32_t val)
+{
+	char tmp[10];
+	uint8_t i = 0;
+
+	do
+	{
+		tmp[i++] = '0' + (val % 10);
+		val /= 10;
+	} while(val);
+
+	while(i && (len < HTTP_METRICS_LINE_MAX - 1)) line[len++] = tmp[--i];
+
+	return len;
+}
+
+// val scaled by 10^decimals, e.g., (1500, 3): 1.500
+static uint16_t metric_put_fixed(char* line, uint16_t len, uint32_t val, uint8_t decimals)
+{
+	char tmp[12];
+	uint8_t i = 0;
+
+	do
+	{
+		tmp[i++] = '0' + (val % 10);
+		val /= 10;
+		if(i == decimals) tmp[i++] = '.';
+	} while(val || (decimals && (i <= decimals + 1))); // 0.xxx
+
+	while(i && (len < HTTP_METRICS_LINE_MAX - 1)) line[len++] = tmp[--i];
+
+	return len;
+}
+
+// Seconds, then the microseconds as 6 decimals
+static uint16_t metric_put_seconds(char* line, uint16_t len, uint32_t sec, uint32_t usec)
+{
+	uint32_t div;
+
+	len = metric_put_uint(line, len, sec);
+	line[len++] = '.';
+	for(div = 100000; div; div /= 10) line[len++] = '0' + ((usec / div) % 10);
+
+	return len;
+}
+
+// Route labels: method="GET",uri="/userio/:id" of the resource (the first method of the entry),
+// uri="unmatched" without method for the requests which matched no resource
+static uint16_t metric_put_route(char* line, uint16_t len, uint8_t route)
+{
+	const struct st_http_resource * resource;
+	uint8_t i;
+
+	if(route >= get_http_resources_count()) return metric_put_str(line, len, "uri=\"unmatched\"");
+
+	resource = get_http_resource(route);
+	for(i = 0; metric_methods[i] != NULL; i++)
+	{
+		if(resource->method & (1 << i)) break;
+	}
+	len = metric_put_str(line, len, "method=\"");
+	if(metric_methods[i] != NULL) len = metric_put_str(line, len, metric_methods[i]);
+	len = metric_put_str(line, len, "\",uri=\"/");
+	len = metric_put_str(line, len, resource->uri);
+
+	return metric_put_str(line, len, "\"");
+}
+
+static uint16_t metric_samples(uint8_t scope)
+{
+	uint16_t cnt = 0;
+
+	switch(scope)
+	{
+		case METRICS_SCOPE_SOCKET:
+			cnt = httpserver.sock_cnt;
+			break;
+
+		case METRICS_SCOPE_ROUTE:
+			cnt = get_http_resources_count() + 1;
+			break;
+
+		case METRICS_SCOPE_STATUS:
+			while(get_http_stats_status(cnt, NULL) != NULL) cnt++;
+			break;
+
+		case METRICS_SCOPE_HISTOGRAM:
+			cnt = (get_http_resources_count() + 1) * METRICS_HIST_SAMPLES;
+			break;
+
+		case METRICS_SCOPE_TASK:
+			cnt = get_sched_task_count() + 1;
+			break;
+
+		case METRICS_SCOPE_DEVICE:
+		default:
+			cnt = 1;
+			break;
+	}
+
+	return cnt;
+}
+
+// Line 'num' of the response: '# HELP' and '# TYPE' of each family, then its samples; returns 0 after the last line
+static uint16_t metric_line(char* line, uint32_t num)
+{
+	const struct st_metric_family * family;
+	uint16_t len = 0;
+	uint32_t cnt;
+
+	for(family = metric_families; family->name != NULL; family++)
+	{
+		cnt = 2 + metric_samples(family->scope);
+		if(num < cnt) break;
+		num -= cnt;
+	}
+
+	if(family->name == NULL) return 0;
+
+	if(num < 2)
+	{
+		len = metric_put_str(line, len, (num == 0) ? "# HELP " : "# TYPE ");
+		len = metric_put_str(line, len, family->name);
+		len = metric_put_str(line, len, " ");
+		len = metric_put_str(line, len, (num == 0) ? family->help : family->type);
+	}
+	else
+	{
+		len = metric_sample(line, family, (uint16_t)(num - 2));
+	}
+
+	line[len++] = '\n';
+
+	return len;
+}
+
+static uint16_t metric_sample(char* line, const struct st_metric_family* family, uint16_t index)
+{
+	const st_http_stats * stats = NULL;
+	const st_http_latency * latency = NULL;
+	const st_sched_stats * task = NULL;
+	st_uptime uptime;
+	uint16_t len;
+	uint16_t status = 0;
+	uint32_t val = 0;
+	uint32_t cnt;
+	uint8_t sock = 0;
+	uint8_t route = 0;
+	uint8_t bucket = 0;
+	uint8_t i;
+
+	len = metric_put_str(line, 0, family->name);
+
+	// Labels
+	switch(family->scope)
+	{
+		case METRICS_SCOPE_SOCKET:
+			sock = httpserver.sock_list[index];
+			len = metric_put_str(line, len, "{socket=\"");
+			len = metric_put_uint(line, len, sock);
+			len = metric_put_str(line, len, "\"}");
+			break;
+
+		case METRICS_SCOPE_ROUTE:
+			route = (uint8_t)index;
+			stats = get_http_stats_route((route < get_http_resources_count()) ? route : HTTP_STATS_NO_ROUTE);
+			len = metric_put_str(line, len, "{");
+			len = metric_put_route(line, len, route);
+			len = metric_put_str(line, len, "}");
+			break;
+
+		case METRICS_SCOPE_STATUS:
+			stats = get_http_stats_status((uint8_t)index, &status);
+			len = metric_put_str(line, len, "{code=\"");
+			if(status) len = metric_put_uint(line, len, status);
+			else len = metric_put_str(line, len, "other");
+			len = metric_put_str(line, len, "\"}");
+			break;
+
+		case METRICS_SCOPE_HISTOGRAM:
+			route = (uint8_t)(index / METRICS_HIST_SAMPLES);
+			bucket = (uint8_t)(index % METRICS_HIST_SAMPLES);
+			stats = get_http_stats_route((route < get_http_resources_count()) ? route : HTTP_STATS_NO_ROUTE);
+			latency = get_http_latency_route((route < get_http_resources_count()) ? route : HTTP_STATS_NO_ROUTE);
+
+			if(bucket < HTTP_STATS_BUCKETS) len = metric_put_str(line, len, "_bucket{");
+			else if(bucket == HTTP_STATS_BUCKETS) len = metric_put_str(line, len, "_sum{");
+			else len = metric_put_str(line, len, "_count{");
+
+			len = metric_put_route(line, len, route);
+
+			if(bucket < HTTP_STATS_BUCKETS - 1) // Upper bound of the bucket, inclusive: 2^(n+4) us
+			{
+				len = metric_put_str(line, len, ",le=\"");
+				len = metric_put_fixed(line, len, (uint32_t)1 << (bucket + HTTP_STATS_BUCKET_MIN), 6);
+				len = metric_put_str(line, len, "\"");
+			}
+			else if(bucket == HTTP_STATS_BUCKETS - 1)
+			{
+				len = metric_put_str(line, len, ",le=\"+Inf\"");
+			}
+			len = metric_put_str(line, len, "}");
+			break;
+
+		case METRICS_SCOPE_TASK:
+			task = get_sched_stats((uint8_t)index);
+			len = metric_put_str(line, len, "{task=\"");
+			len = metric_put_str(line, len, task->name);
+			len = metric_put_str(line, len, "\"}");
+			break;
+
+		default:
+			break;
+	}
+
+	len = metric_put_str(line, len, " ");
+
+	// Value
+	switch(family->id)
+	{
+		case METRIC_UPTIME: // Seconds, then the milliseconds as 3 decimals
+			getDeviceUptime(&uptime);
+			len = metric_put_uint(line, len, ((uptime.hour * 60) + uptime.min) * 60 + uptime.sec);
+			val = uptime.msec;
+			line[len++] = '.';
+			line[len++] = '0' + (val / 100);
+			line[len++] = '0' + ((val / 10) % 10);
+			line[len++] = '0' + (val % 10);
+			return len;
+
+		case METRIC_LOOPS:            val = loop_cnt; break;
+		case METRIC_LOOP_RATE:        val = loop_rate; break;
+		case METRIC_ADC:              val = get_ADC_conversions(); break;
+		case METRIC_UART_DROPPED:     val = get_UART2_tx_dropped(); break;
+		case METRIC_SOCK_STATE:       val = HTTPSock[index].status; break;
+		case METRIC_SOCK_STATUS:      val = getSn_SR(sock); break;
+		case METRIC_SOCK_TX_FREE:     val = getSn_TX_FSR(sock); break;
+		case METRIC_SOCK_RX_RECV:     val = getSn_RX_RSR(sock); break;
+		case METRIC_SOCK_CONNECTIONS: val = HTTPSock[index].connections; break;
+		case METRIC_SOCK_OPENS:       val = HTTPSock[index].opens; break;
+		case METRIC_SOCK_REAPED:      val = HTTPSock[index].reaped; break;
+		case METRIC_ROUTE_REQUESTS:   val = stats->requests; break;
+		case METRIC_ROUTE_ERRORS:     val = stats->errors; break;
+		case METRIC_ROUTE_BYTES_IN:   val = stats->bytes_in; break;
+		case METRIC_ROUTE_BYTES_OUT:  val = stats->bytes_out; break;
+		case METRIC_STATUS_RESPONSES: val = stats->requests; break;
+
+		case METRIC_ROUTE_DURATION:
+			if(bucket == HTTP_STATS_BUCKETS) return metric_put_seconds(line, len, latency->sec, latency->usec);
+
+			// _count: the request counter of the route; the cumulative counts of the buckets wrap with it
+			if(bucket > HTTP_STATS_BUCKETS)
+			{
+				val = stats->requests;
+				break;
+			}
+			for(i = 0, cnt = 0; i <= bucket; i++) cnt += latency->hist[i];
+			val = cnt;
+			break;
+
+		case METRIC_TASK_RUNS:        val = task->runs; break;
+		case METRIC_TASK_MAX:         return metric_put_fixed(line, len, task->max_usec, 6);
+
+		case METRIC_TASK_TIME:        return metric_put_seconds(line, len, task->sec, task->usec);
+
+		default:
+			break;
+	}
+
+	return metric_put_uint(line, len, val);
+}
@@ -0,0 +1,33 @@
+/**
+ * @file	httpMetrics.h
+ * @brief	Header File for HTTP Server - Metrics resource in the Prometheus text exposition format
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#ifndef	__HTTPMETRICS_H__
+#define	__HTTPMETRICS_H__
+
+#include <stdint.h>
+
+// Max. length of a metric line: name, labels (method and URI of a resource) and value
+#define HTTP_METRICS_LINE_MAX	192
+
+// Registers the '/metrics' resource: after RESTapi_init(), before httpServer_init()
+int8_t http_metrics_init(void);
+
+// Body generator of the '/metrics' resource (st_http_resource): one metric line after the other, read from the live
+// counters while the response is sent; '*cursor' is the line number, so the number of metrics is not limited by the buffers
+int16_t http_metrics_generate(char* buf, uint16_t size, uint32_t* cursor);
+
+// HTTP server task: call once per pass over the sockets
+void http_metrics_loop(void);
+
+// 1s Tick Timer handler: HTTP server passes per second
+void http_metrics_time_handler(void);
+
+#endif
@@ -5,13 +5,25 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include "socket.h"
 #include "httpParser_rest.h"
+#include "httpArena.h"
+
+#define LOG_MODULE			LOG_MODULE_HTTPPARSER
+#define LOG_MODULE_LEVEL	LOG_LEVEL_HTTPPARSER
+#include "logHandler.h"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+// Parameter table of the current request; filled once by parse_http_request()
+static struct st_http_param http_params[MAX_HTTP_PARAMS];
+static uint8_t http_params_cnt = 0;
 
 /*****************************************************************************
  * Public types/enumerations/variables
  ****************************************************************************/
-uint8_t BUFPUB[512];
 
 const struct st_http_method method_table[] = 
 {
@@ -20,8 +32,9 @@ const struct st_http_method method_table[] =
 	{ HTTP_REQ_METHOD_POST,       HTTP_REQ_STR_POST        },
 	{ HTTP_REQ_METHOD_PUT,        HTTP_REQ_STR_PUT         },
 	{ HTTP_REQ_METHOD_DELETE,     HTTP_REQ_STR_DELETE      },
+	{ HTTP_REQ_METHOD_OPTIONS,    HTTP_REQ_STR_OPTIONS     },
 	
-	{ NULL, NULL } // Last item should be set to NULL
+	{ 0, NULL } // Last item should be set to 0
 };
 
 const struct st_http_status code_table[] = 
@@ -34,9 +47,11 @@ const struct st_http_status code_table[] =
 	{ HTTP_RES_CODE_NOT_FOUND,    HTTP_RES_STR_NOT_FOUND   },
 	{ HTTP_RES_CODE_NOT_ALLOWED,  HTTP_RES_STR_NOT_ALLOWED },
 	{ HTTP_RES_CODE_CONFLICT,     HTTP_RES_STR_CONFLICT    },
+	{ HTTP_RES_CODE_TOO_LARGE,    HTTP_RES_STR_TOO_LARGE   },
+	{ HTTP_RES_CODE_INT_SERVER,   HTTP_RES_STR_INT_SERVER  },
 	{ HTTP_RES_CODE_NOT_IMPLE,    HTTP_RES_STR_NOT_IMPLE   },
 	
-	{ NULL, NULL } // Last item should be set to NULL
+	{ 0, NULL } // Last item should be set to 0
 };
 
 const struct st_http_mime mime_table[] = 
@@ -48,6 +63,9 @@ const struct st_http_mime mime_table[] =
 	{ HTTP_RES_TYPE_CGI,   ".cgi",  ".CGI", 	HTTP_RES_STR_CGI   },
 	{ HTTP_RES_TYPE_XML,   ".xml",  ".XML", 	HTTP_RES_STR_XML   },
 	{ HTTP_RES_TYPE_JSON,  ".json", ".JSON", 	HTTP_RES_STR_JSON  },
+	{ HTTP_RES_TYPE_CBOR,  ".cbor", ".CBOR", 	HTTP_RES_STR_CBOR  },
+	{ HTTP_RES_TYPE_PROMETHEUS, ".prom", ".PROM", HTTP_RES_STR_PROMETHEUS },
+	{ HTTP_RES_TYPE_BINARY, ".bin",  ".BIN", 	HTTP_RES_STR_BINARY },
 	{ HTTP_RES_TYPE_GIF,   ".gif",  ".GIF", 	HTTP_RES_STR_GIF   },
 	{ HTTP_RES_TYPE_JPEG,  ".jpg",  ".jpeg", 	HTTP_RES_STR_JPEG  },
 	{ HTTP_RES_TYPE_PNG,   ".png",  ".PNG", 	HTTP_RES_STR_PNG   },
@@ -59,14 +77,24 @@ const struct st_http_mime mime_table[] =
 	{ HTTP_RES_TYPE_EOT,   ".eot",  ".EOT", 	HTTP_RES_STR_EOT   },
 	{ HTTP_RES_TYPE_SVG,   ".svg",  ".SVG", 	HTTP_RES_STR_SVG   },
 	
-	{ NULL, NULL, NULL, NULL } // Last item should be set to NULL
+	{ 0, NULL, NULL, NULL } // Last item should be set to 0
 };
 
 /*****************************************************************************
  * Private functions
  ****************************************************************************/
-static void replacetochar(uint8_t * str, uint8_t oldchar, uint8_t newchar); 	/* Replace old character with new character in the string */
 static uint8_t C2D(uint8_t c); 												/* Convert a character to HEX */
+static void parse_http_params(const char * str, uint16_t len);					/* Split the query string / form body into the parameter table */
+static const char * find_http_header(const char * headers, const char * end, const char * name);	/* Find the request header value */
+static uint8_t find_http_header_value(const char * hdr, const char * value);	/* Find the value in the header line, e.g., a media type of 'Accept' */
+
+#ifdef _USE_CORS_
+// Constant part of the CORS preflight response; only Access-Control-Allow-Methods depends on the resource
+static const char cors_origin_header[] = HTTP_RES_HEADER_CORS_ORIGIN HTTP_CORS_ALLOW_ORIGIN "\r\n";
+static const char cors_preflight_header[] = 
+	HTTP_RES_HEADER_CORS_HEADERS HTTP_CORS_ALLOW_HEADERS "\r\n"
+	HTTP_RES_HEADER_CORS_MAX_AGE HTTP_CORS_MAX_AGE "\r\n";
+#endif
 
 /**
  @brief	convert escape characters(%XX) to ASCII character
@@ -94,16 +122,18 @@ void make_http_response_header(
 	char * buf,            /**< pointer to response header to be made */
 	char type,             /**< response type */
 	uint32_t len,          /**< size of response content */
-	uint16_t http_status   /**< http status */
+	uint16_t http_status,  /**< http status */
+	const char * allow,    /**< method list of the resource for 'Allow' header (OPTIONS / 405), NULL: not used */
+	uint16_t cache         /**< cache policy, HTTP_CACHE_xxx or max-age (sec.) */
 	)
 {
-	const char * status_code;
-	const char * content_type;
+	const char * status_code = NULL;
+	const char * content_type = NULL;
 	uint8_t i;
 	uint16_t str_len;
 
 	// Find the HTTP status code
-	for(i = 0; code_table[i].code != NULL; i++)
+	for(i = 0; code_table[i].code != 0; i++)
 	{
 		if(http_status == code_table[i].code)
 		{
@@ -113,7 +143,7 @@ void make_http_response_header(
 	}
 	
 	// Find the HTTP Content-Type
-	for(i = 0; mime_table[i].type != NULL; i++)
+	for(i = 0; mime_table[i].type != 0; i++)
 	{
 		if(type == mime_table[i].type)
 		{
@@ -128,9 +158,65 @@ void make_http_response_header(
 	// Generate HTTP response header string
 	str_len = sprintf(buf, "%s %s\r\n", HTTP_VERSION_STR, status_code);
 	str_len += sprintf(buf+str_len, "%s %s\r\n", HTTP_RES_HEADER_TYPE, content_type);
-	str_len += sprintf(buf+str_len, "%s %d\r\n", HTTP_RES_HEADER_LEN, len);
+	if(len == HTTP_RES_LEN_CHUNKED)
+		str_len += sprintf(buf+str_len, "%s%s\r\n", HTTP_RES_HEADER_TRANSFER, "chunked");
+	else
+		str_len += sprintf(buf+str_len, "%s %d\r\n", HTTP_RES_HEADER_LEN, len);
 	str_len += sprintf(buf+str_len, "%s %s\r\n", HTTP_RES_HEADER_CONN, "close"); // or "keep-alive"
-	strcat(buf, "\r\n");
+	
+	if(cache == HTTP_CACHE_NO_STORE)
+		str_len += sprintf(buf+str_len, "%s%s\r\n", HTTP_RES_HEADER_CACHE, "no-store");
+	else if(cache != HTTP_CACHE_DEFAULT)
+		str_len += sprintf(buf+str_len, "%smax-age=%d\r\n", HTTP_RES_HEADER_CACHE, cache);
+	
+	if((cache != HTTP_CACHE_NO_STORE) && ((type == HTTP_RES_TYPE_JSON) || (type == HTTP_RES_TYPE_CBOR)))
+		str_len += sprintf(buf+str_len, "%s%s\r\n", HTTP_RES_HEADER_VARY, "Accept");
+	
+	if(allow)
+	{
+		str_len += sprintf(buf+str_len, "%s%s\r\n", HTTP_RES_HEADER_ALLOW, allow);
+	}
+	
+#ifdef _USE_CORS_
+	strcpy(buf+str_len, cors_origin_header);
+	str_len += sizeof(cors_origin_header) - 1;
+	
+	// CORS preflight: browser caches the result for HTTP_CORS_MAX_AGE seconds
+	if(allow)
+	{
+		str_len += sprintf(buf+str_len, "%s%s\r\n", HTTP_RES_HEADER_CORS_METHODS, allow);
+		
+		strcpy(buf+str_len, cors_preflight_header);
+		str_len += sizeof(cors_preflight_header) - 1;
+	}
+#endif
+	strcpy(buf+str_len, "\r\n");
+}
+
+
+/**
+ @brief	make the method list string of the resource from the method bitmask
+ @return	length of the string
+ */
+uint16_t make_http_method_list(
+	char * buf, 		/**< pointer to be made */
+	uint8_t methods		/**< bitmask of the HTTP_REQ_METHOD_xxx */
+	)
+{
+	uint8_t i;
+	uint16_t len = 0;
+	
+	buf[0] = '\0';
+	for(i = 0; method_table[i].method != 0; i++)
+	{
+		if(methods & method_table[i].method)
+		{
+			if(len) len += sprintf(buf+len, ", ");
+			len += sprintf(buf+len, "%s", method_table[i].method_str);
+		}
+	}
+	
+	return len;
 }
 
 
@@ -147,7 +233,7 @@ void find_http_uri_type(
 	char * buf;
 	buf = (char *)buff;
 	
-	for(i = 0; mime_table[i].type != NULL; i++)
+	for(i = 0; mime_table[i].type != 0; i++)
 	{
 		if(strstr(buf, mime_table[i].filext1) || strstr(buf, mime_table[i].filext2))
 		{
@@ -166,19 +252,29 @@ void find_http_uri_type(
  */ 
 void parse_http_request(
 	st_http_request * request,  /**< request to be returned */
-	uint8_t * buf               /**< pointer to be parsed */
+	uint8_t * buf,              /**< pointer to be parsed */
+	uint16_t size               /**< received bytes in the buffer, buf[size] is '\0' */
 	)
 {
-#ifndef _OLD_
-	// Todo: PUT update
-	/*
-	uint8_t tmp_buf[10]={0x00, };
-	char * body_ptr = NULL;
-	uint16_t body_len = 0;
-	*/
-#endif
-	
 	char * nexttok;
+	char * rest;
+	char * body;
+	const char * hdr;
+	uint16_t len;
+	uint32_t content_len;
+	uint8_t digits;
+	
+	http_params_cnt = 0;
+	request->URI = NULL;
+	request->BODY = NULL;
+	request->BODY_LEN = 0;
+	request->BODY_TYPE = HTTP_REQ_BODY_NONE;
+	
+	// Accept: representation of the REST API resources; searched before the request line is tokenized
+	request->ACCEPT = HTTP_RES_TYPE_JSON;
+	hdr = find_http_header((char *)buf, strstr((char *)buf, "\r\n\r\n"), HTTP_REQ_HEADER_ACCEPT);
+	if(hdr && find_http_header_value(hdr, HTTP_RES_STR_CBOR)) request->ACCEPT = HTTP_RES_TYPE_CBOR;
+	
 	nexttok = strtok((char*)buf," ");
 	
 	if(!nexttok)
@@ -214,6 +310,11 @@ void parse_http_request(
 		request->METHOD = HTTP_REQ_METHOD_DELETE;
 		nexttok = strtok(NULL,"\0");
 	}
+	else if (!strcmp(nexttok, HTTP_REQ_STR_OPTIONS)) // OPTIONS method
+	{
+		request->METHOD = HTTP_REQ_METHOD_OPTIONS;
+		nexttok = strtok(NULL," ");
+	}
 	else
 	{
 		request->METHOD = HTTP_REQ_METHOD_ERR;      // Error
@@ -225,88 +326,138 @@ void parse_http_request(
 		return;
 	}
 	
-	strcpy((char *)request->URI, nexttok);
-
-#ifndef _OLD_
+	// POST / PUT / DELETE: the token includes the rest of request (headers and body); the URI is the request target only,
+	// copied to the request arena: the receive buffer is overwritten by the response header
+	rest = nexttok;
+	len = strcspn(nexttok, " \r\n");
+	if(len > (MAX_URI_SIZE - 1)) len = MAX_URI_SIZE - 1;
+	if((request->URI = (uint8_t *)http_arena_alloc(len + 1)) == NULL)
+	{
+		request->METHOD = HTTP_REQ_METHOD_ERR;      // Error
+		return;
+	}
+	memcpy(request->URI, nexttok, len);
+	request->URI[len] = '\0';
 	
-	// Todo: PUT update
-	/*
-	if((request->METHOD == HTTP_REQ_METHOD_GET) || (request->METHOD == HTTP_REQ_METHOD_HEAD) || (request->METHOD == HTTP_REQ_METHOD_ERR)) return;
+	// Query string: parameters are kept as slices of the URI, decoded when the handler reads them
+	nexttok = memchr(request->URI, '?', len);
+	if(nexttok)
+	{
+		nexttok++;
+		parse_http_params(nexttok, len - (nexttok - (char *)request->URI));
+	}
 	
-	// Parse the additional part: Content length / Content body
-	mid((char *)request->URI, "Content-Length: ", "\r\n", (char *)tmp_buf);
-	body_len = ATOI(tmp_buf, 10);
-	body_ptr = strstr((char *)request->URI, "\r\n\r\n");
-	body_ptr+=4;
+	if((request->METHOD == HTTP_REQ_METHOD_GET) || (request->METHOD == HTTP_REQ_METHOD_HEAD) || (request->METHOD == HTTP_REQ_METHOD_OPTIONS) || (request->METHOD == HTTP_REQ_METHOD_ERR)) return;
 	
-	request->BODY_LEN = body_len;
-	request->BODY = (uint8_t *)body_ptr;
+	// Content body: in the receive buffer (binary bodies may include '\0'), Content-Length limits the body in the received part of the request
+	body = strstr(rest + len, "\r\n\r\n");
+	if(!body) return;
+	body += 4;
+	len = ((char *)buf + size) - body;
 	
-	printf("  >> bodylen = %d\r\n", request->BODY_LEN);
-	printf("  >> body\r\n%s\r\n", request->BODY);
-	*/
-#endif
+	if((hdr = find_http_header(rest, body, HTTP_REQ_HEADER_LEN)) != NULL)
+	{
+		// Up to 5 significant digits: a longer body does not fit in the 16-bit body length, and is refused instead of truncated
+		for(content_len = 0, digits = 0; (*hdr >= '0') && (*hdr <= '9') && (digits <= 5); hdr++)
+		{
+			content_len = (content_len * 10) + (*hdr - '0');
+			if(content_len) digits++;
+		}
+		if((digits > 5) || (content_len > 0xFFFF))
+		{
+			request->BODY_TYPE = HTTP_REQ_BODY_TOO_LARGE;
+			return;
+		}
+		if(content_len < len) len = (uint16_t)content_len;
+	}
+	
+	request->BODY = (uint8_t *)body;
+	request->BODY_LEN = len;
+	if(!len) return;
+	
+	// Form body: parameters are added after the query string parameters
+	hdr = find_http_header(rest, body, HTTP_REQ_HEADER_TYPE);
+	if(!hdr || !strncmp(hdr, HTTP_REQ_STR_JSON, sizeof(HTTP_REQ_STR_JSON)-1))
+	{
+		request->BODY_TYPE = HTTP_REQ_BODY_JSON;
+	}
+	else if(!strncmp(hdr, HTTP_REQ_STR_FORM, sizeof(HTTP_REQ_STR_FORM)-1))
+	{
+		request->BODY_TYPE = HTTP_REQ_BODY_FORM;
+		parse_http_params(body, len);
+	}
+	else if(!strncmp(hdr, HTTP_RES_STR_CBOR, sizeof(HTTP_RES_STR_CBOR)-1))
+	{
+		request->BODY_TYPE = HTTP_REQ_BODY_CBOR;
+	}
+	else
+	{
+		request->BODY_TYPE = HTTP_REQ_BODY_OTHER;
+	}
+	
+	LOG_DEBUG2("bodylen = %d, params = %d", request->BODY_LEN, http_params_cnt);
 }
 
 
 /**
- @brief	get next parameter value in the request
+ @brief	find the parameter of the current request
+ @return	raw key / value slice, NULL: parameter not found
  */
-uint8_t * get_http_param_value(char* uri, char* param_name)
+const struct st_http_param * find_http_param(
+	const char * name	/**< parameter name */
+	)
 {
+	uint8_t i;
+	uint16_t len;
+	
+	if(!name) return NULL;
+	len = strlen(name);
+	
+	for(i = 0; i < http_params_cnt; i++)
+	{
+		if((http_params[i].key_len == len) && !strncmp(http_params[i].key, name, len)) return &http_params[i];
+	}
+	
+	return NULL;
+}
+
 
-	uint8_t * name;
-	uint8_t * ret = BUFPUB;
-	uint8_t * pos2;
-	uint16_t len = 0, content_len = 0;
-	uint8_t tmp_buf[10]={0x00, };
-
-	if(!uri || !param_name) return 0;
-
-	/***************/
-	mid(uri, "Content-Length: ", "\r\n", (char *)tmp_buf);
-	content_len = ATOI(tmp_buf, 10);
-	//printf("content len=%d\r\n",content_len);
-	uri = strstr(uri, "\r\n\r\n");
-	uri+=4;
-	//printf("uri=%s\r\n",uri);
-	uri[content_len] = 0;
-	/***************/
-	
-	name = (uint8_t *)strstr(uri, param_name);
-	if(name != NULL)
+/**
+ @brief	get the parameter value of the current request, URL-decoded ('%XX' and '+') into the buffer
+ @return	length of the value, -1: parameter not found
+ */
+int16_t get_http_param_value(
+	const char * name,	/**< parameter name, e.g., "fields" */
+	char * buf,			/**< buffer for the decoded value (NULL-terminated, truncated to size) */
+	uint16_t size		/**< size of the buffer */
+	)
+{
+	const struct st_http_param * param;
+	uint16_t i;
+	int16_t len = 0;
+	
+	if(!buf || !size || ((param = find_http_param(name)) == NULL)) return -1;
+	
+	for(i = 0; (i < param->val_len) && (len < (size - 1)); i++, len++)
 	{
-		name += strlen(param_name) + 1;
-		pos2 = (uint8_t*)strstr((char*)name, "&");
-		if(!pos2)
+		if((param->val[i] == '%') && ((i + 2) < param->val_len))
 		{
-			pos2 = name + strlen((char*)name);
+			buf[len] = C2D(param->val[i+1])*0x10 + C2D(param->val[i+2]);
+			i += 2;
 		}
-		len = pos2 - name;
-
-		if(len)
+		else if(param->val[i] == '+')
 		{
-			ret[len] = 0;
-			strncpy((char*)ret,(char*)name, len);
-			unescape_http_url((char *)ret);
-			replacetochar(ret, '+' ,' ');
-			//ret[len] = 0;
-			//ret[strlen((int8*)ret)] = 0;
-			//printf("len=%d\r\n",len);
+			buf[len] = ' ';
 		}
 		else
 		{
-			ret[0] = 0;
+			buf[len] = param->val[i];
 		}
 	}
-	else
-	{
-		return 0;
-	}
-#ifdef _HTTPPARSER_DEBUG_
-	printf("  %s=%s\r\n", param_name, ret);
-#endif
-	return ret;
+	buf[len] = '\0';
+	
+	LOG_DEBUG2("param %s: %d bytes", name, len); // The value is not kept until the message is printed
+	return len;
 }
 
 
@@ -318,13 +469,16 @@ uint8_t get_http_uri_name(uint8_t * uri, uint8_t * uri_buf)
 	strcpy((char *)uri_buf, (char *)uri);
 
 	uri_ptr = (uint8_t *)strtok((char *)uri_buf, " ?");
+	if(!uri_ptr) // e.g., "?key=value"
+	{
+		uri_buf[0] = '\0';
+		return 0;
+	}
 
 	if(strcmp((char *)uri_ptr,"/")) uri_ptr++;
-	strcpy((char *)uri_buf, (char *)uri_ptr);
+	memmove(uri_buf, uri_ptr, strlen((char *)uri_ptr) + 1); // overlapped copy
 
-#ifdef _HTTPPARSER_DEBUG_
-	printf("  uri_name = %s\r\n", uri_buf);
-#endif
+	LOG_DEBUG1("uri_name: %d bytes", strlen((char *)uri_buf)); // uri_buf: overwritten by the next request
 
 	return 1;
 }
@@ -396,17 +550,97 @@ void mid(char* src, char* s1, char* s2, char* sub)
 ////////////////////////////////////////////////////////////////////
 
 /**
-@brief	replace the specified character in a string with new character
+@brief	split the query string or form body into the parameter table, "key=value&key=value..."
 */
-static void replacetochar(
-		uint8_t * str, 		/**< pointer to be replaced */
-		uint8_t oldchar, 	/**< old character */
-		uint8_t newchar	/**< new character */
+static void parse_http_params(
+		const char * str,	/**< pointer to be parsed */
+		uint16_t len		/**< length of the string */
 	)
 {
-	int x;
-	for (x = 0; str[x]; x++)
-		if (str[x] == oldchar) str[x] = newchar;
+	const char * end = str + len;
+	const char * pair;
+	const char * val;
+	struct st_http_param * param;
+	
+	while((str < end) && (http_params_cnt < MAX_HTTP_PARAMS))
+	{
+		pair = str;
+		while((str < end) && (*str != '&')) str++;
+		
+		if(str > pair) // empty pairs are skipped, e.g., "a=1&&b=2"
+		{
+			param = &http_params[http_params_cnt++];
+			param->key = pair;
+			if((val = memchr(pair, '=', str - pair)) != NULL)
+			{
+				param->key_len = val - pair;
+				param->val = val + 1;
+				param->val_len = str - (val + 1);
+			}
+			else // key only, e.g., "?pretty"
+			{
+				param->key_len = str - pair;
+				param->val = str;
+				param->val_len = 0;
+			}
+		}
+		str++; // '&'
+	}
+}
+
+/**
+@brief	find the request header value between the request-line and the body
+@return	pointer to the value (leading spaces skipped), NULL: header not found
+
+The field name is matched at the start of a header line, case-insensitively (RFC 9110 5.1): 'content-type:' is
+'Content-Type:', 'X-Content-Type:' is not
+*/
+static const char * find_http_header(
+		const char * headers,	/**< request-line and headers */
+		const char * end,		/**< end of the headers (start of the body), NULL: not received */
+		const char * name		/**< header name includes ':', e.g., "Content-Length:" */
+	)
+{
+	const char * line;
+	uint16_t len = strlen(name);
+	uint16_t i;
+	
+	if(!end) return NULL;
+	
+	// The header lines follow the request-line
+	for(line = strstr(headers, "\r\n"); line && (line < end); line = strstr(line, "\r\n"))
+	{
+		line += 2;
+		for(i = 0; (i < len) && (tolower((uint8_t)line[i]) == tolower((uint8_t)name[i])); i++);
+		if(i < len) continue;
+		
+		line += len;
+		while(*line == ' ') line++;
+		
+		return line;
+	}
+	
+	return NULL;
+}
+
+/**
+ @brief	find the value in the header line (e.g., a media type in the list of 'Accept')
+ @return	1: found, 0: not found
+ */
+static uint8_t find_http_header_value(
+		const char * hdr,		/**< header value returned by find_http_header() */
+		const char * value		/**< value to be found */
+	)
+{
+	uint16_t line = strcspn(hdr, "\r\n");
+	uint16_t len = strlen(value);
+	
+	for( ; line >= len; hdr++, line--)
+	{
+		if(!strncmp(hdr, value, len)) return 1;
+	}
+	
+	return 0;
 }
 
 /**
@@ -8,7 +8,10 @@
 #ifndef	__HTTPPARSER_H__
 #define	__HTTPPARSER_H__
 
-//#define _HTTPPARSER_DEBUG_
+// Debug messages: LOG_LEVEL_HTTPPARSER (logHandler.h)
+
+// CORS (Cross-Origin Resource Sharing) response headers enable
+#define _USE_CORS_
 
 #define HTTP_SERVER_PORT		80		/**< HTTP server well-known port number */
 
@@ -19,7 +22,9 @@
 #define HTTP_REQ_METHOD_POST      (uint8_t)(0x01 <<  2)  /**< POST Method    */
 #define HTTP_REQ_METHOD_PUT       (uint8_t)(0x01 <<  3)  /**< PUT Method     */
 #define HTTP_REQ_METHOD_DELETE    (uint8_t)(0x01 <<  4)  /**< DELETE Method  */
-// These methods are not implemented; 'OPTION', 'TRACE', 'CONNECT'
+#define HTTP_REQ_METHOD_OPTIONS   (uint8_t)(0x01 <<  5)  /**< OPTIONS Method */
+#define HTTP_REQ_METHOD_NUM       6                      /**< Number of the method bits */
+// These methods are not implemented; 'TRACE', 'CONNECT'
 
 // Method names are case-sensitive, and all registered methods are all upper-case.
 #define HTTP_REQ_STR_GET          "GET"
@@ -27,6 +32,7 @@
 #define HTTP_REQ_STR_POST         "POST"
 #define HTTP_REQ_STR_PUT          "PUT"
 #define HTTP_REQ_STR_DELETE       "DELETE"
+#define HTTP_REQ_STR_OPTIONS      "OPTIONS"
 
 /* HTTP Version */
 #define HTTP_VERSION_STR          "HTTP/1.1"
@@ -40,6 +46,7 @@
 #define HTTP_RES_CODE_NOT_FOUND   404    // The server has not found anything matching the Request-URI
 #define HTTP_RES_CODE_NOT_ALLOWED 405    // The method specified in the Request-Line is not allowed for the resource identified by the Request-URI
 #define HTTP_RES_CODE_CONFLICT    409    // The request could not be completed due to a conflict with the current state of the resource
+#define HTTP_RES_CODE_TOO_LARGE   413    // The request entity is larger than the server is willing or able to process
 #define HTTP_RES_CODE_INT_SERVER  500    // The server encountered an unexpected condition which prevented it from fulfilling the request
 #define HTTP_RES_CODE_NOT_IMPLE   501    // The server does not support the functionality required to fulfill the request
 
@@ -51,6 +58,7 @@
 #define HTTP_RES_STR_NOT_FOUND    "404 Not Found"           
 #define HTTP_RES_STR_NOT_ALLOWED  "405 Method Not Allowed"  
 #define HTTP_RES_STR_CONFLICT     "409 Conflict"            
+#define HTTP_RES_STR_TOO_LARGE    "413 Payload Too Large"
 #define HTTP_RES_STR_INT_SERVER   "500 Internal Server Error"
 #define HTTP_RES_STR_NOT_IMPLE    "501 Not Implemented" 
 
@@ -58,6 +66,44 @@
 #define HTTP_RES_HEADER_TYPE      "Content-Type: "    // HTTP response content type 
 #define HTTP_RES_HEADER_LEN       "Content-Length: "  // Byte length of entity
 #define HTTP_RES_HEADER_CONN      "Connection: "      // 'close' or 'keep-alive'
+#define HTTP_RES_HEADER_ALLOW     "Allow: "           // Methods supported by the resource (OPTIONS / 405)
+#define HTTP_RES_HEADER_CACHE     "Cache-Control: "   // Cache policy of the resource
+#define HTTP_RES_HEADER_VARY      "Vary: "            // 'Accept'; cached REST API responses depend on the representation (JSON / CBOR)
+#define HTTP_RES_HEADER_TRANSFER  "Transfer-Encoding: " // 'chunked'; streaming response body
+
+/* HTTP response body length: Streaming response (Transfer-Encoding: chunked) */
+#define HTTP_RES_LEN_CHUNKED      0xFFFFFFFF
+
+/* HTTP Cache policy: Cache-Control header */
+#define HTTP_CACHE_DEFAULT        0                   // Cache-Control header not used
+#define HTTP_CACHE_NO_STORE       0xFFFF              // 'no-store'; for live values (e.g., uptime, I/O status)
+// Other values: 'max-age' in seconds
+
+/* CORS Header fields */
+#define HTTP_RES_HEADER_CORS_ORIGIN     "Access-Control-Allow-Origin: "
+#define HTTP_RES_HEADER_CORS_METHODS    "Access-Control-Allow-Methods: "
+#define HTTP_RES_HEADER_CORS_HEADERS    "Access-Control-Allow-Headers: "
+#define HTTP_RES_HEADER_CORS_MAX_AGE    "Access-Control-Max-Age: "
+
+#define HTTP_CORS_ALLOW_ORIGIN    "*"
+#define HTTP_CORS_ALLOW_HEADERS   "Content-Type, Accept"
+#define HTTP_CORS_MAX_AGE         "86400"             // Preflight cache time (sec.), browsers may clamp this value
+
+// Request parameters: query string (all methods) and form body (application/x-www-form-urlencoded)
+#define MAX_HTTP_PARAMS           8                   // Parameters over this number are ignored
+#define HTTP_REQ_HEADER_TYPE      "Content-Type:"
+#define HTTP_REQ_HEADER_LEN       "Content-Length:"
+#define HTTP_REQ_STR_FORM         "application/x-www-form-urlencoded"
+#define HTTP_REQ_STR_JSON         "application/json"
+#define HTTP_REQ_HEADER_ACCEPT    "Accept:"           // REST API representation: HTTP_RES_STR_CBOR or JSON (default)
+
+// Request body types (Content-Type of the request)
+#define HTTP_REQ_BODY_NONE        0
+#define HTTP_REQ_BODY_JSON        1                   // application/json, or the body has no Content-Type
+#define HTTP_REQ_BODY_FORM        2                   // application/x-www-form-urlencoded
+#define HTTP_REQ_BODY_CBOR        3                   // application/cbor
+#define HTTP_REQ_BODY_OTHER       4
+#define HTTP_REQ_BODY_TOO_LARGE   5                   // Content-Length over 65535: not parsed, '413 Payload Too Large'
 
 /* HTTP Content Types (MIME) */
 // ERROR
@@ -71,6 +117,9 @@
 // Object notation format
 #define HTTP_RES_TYPE_XML         6
 #define HTTP_RES_TYPE_JSON        7
+#define HTTP_RES_TYPE_CBOR        13                  // RFC 7049 Concise Binary Object Representation
+#define HTTP_RES_TYPE_PROMETHEUS  14                  // Prometheus text exposition format (metrics)
+#define HTTP_RES_TYPE_BINARY      15                  // Binary data, e.g., the trace records
 // Image
 #define HTTP_RES_TYPE_GIF         8
 #define HTTP_RES_TYPE_JPEG        9
@@ -93,6 +142,9 @@
 // Object notation format
 #define HTTP_RES_STR_XML          "text/xml"
 #define HTTP_RES_STR_JSON         "application/json"
+#define HTTP_RES_STR_CBOR         "application/cbor"
+#define HTTP_RES_STR_PROMETHEUS   "text/plain; version=0.0.4"
+#define HTTP_RES_STR_BINARY       "application/octet-stream"
 // Image
 #define HTTP_RES_STR_GIF          "image/gif"
 #define HTTP_RES_STR_JPEG         "image/jpeg"
@@ -116,7 +168,7 @@
  */
 
 //#define MAX_URI_SIZE	1461
-#define MAX_URI_SIZE	512
+#define MAX_URI_SIZE	512		// Longest URI kept, '\0' included; the URI is allocated by its length (httpArena.h)
 
 struct st_http_method
 {
@@ -151,20 +203,33 @@ typedef struct _st_http_request
 {
 	uint8_t  METHOD;						/**< request method(METHOD_GET...). */
 	uint8_t  TYPE;						/**< request type(PTYPE_HTML...).   */
-	uint8_t  URI[MAX_URI_SIZE];			/**< request file name.             */
-	uint8_t  BODY_LEN;
+	uint8_t* URI;						/**< request target (path and query), in the request arena; NULL: no request line */
+	uint16_t BODY_LEN;
 	uint8_t* BODY;
+	uint8_t  BODY_TYPE;					/**< HTTP_REQ_BODY_xxx             */
+	uint8_t  ACCEPT;					/**< HTTP_RES_TYPE_JSON or HTTP_RES_TYPE_CBOR */
 } st_http_request;
 #endif
 
+// Request parameter: key / value slices of the request, not NULL-terminated and not URL-decoded
+struct st_http_param
+{
+	const char* key;
+	const char* val;
+	uint16_t    key_len;
+	uint16_t    val_len;
+};
+
 extern const struct st_http_method method_table[];
 extern const struct st_http_status code_table[];
 
 void unescape_http_url(char * url);									/* convert escape character to ascii */
-void parse_http_request(st_http_request *, uint8_t *);				/* parse request from peer */
+void parse_http_request(st_http_request *, uint8_t *, uint16_t);		/* parse request from peer (received bytes) */
 void find_http_uri_type(uint8_t *, uint8_t *);						/* find MIME type of a file */
-void make_http_response_header(char *, char, uint32_t, uint16_t);	/* make response header */
-uint8_t * get_http_param_value(char* uri, char* param_name);		/* get the user-specific parameter value */
+void make_http_response_header(char *, char, uint32_t, uint16_t, const char *, uint16_t);	/* make response header */
+uint16_t make_http_method_list(char * buf, uint8_t methods);				/* make the method list string, e.g., "GET, PUT" */
+const struct st_http_param * find_http_param(const char * name);	/* find the request parameter (raw slice) */
+int16_t get_http_param_value(const char * name, char * buf, uint16_t size);	/* get the URL-decoded parameter value */
 uint8_t get_http_uri_name(uint8_t * uri, uint8_t * uri_buf);		/* get the requested URI name */
 #ifdef _OLD_
 uint8_t * get_http_uri_name(uint8_t * uri);
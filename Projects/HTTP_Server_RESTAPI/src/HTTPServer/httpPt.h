@@ -0,0 +1,69 @@
+/**
+ * @file	httpPt.h
+ * @brief	Header File for HTTP Server - Resumable REST API handlers: stackless coroutines (protothreads)
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#ifndef	__HTTPPT_H__
+#define	__HTTPPT_H__
+
+#include <stdint.h>
+
+// A handler waiting for a slow operation (e.g. an ADC conversion, a peripheral transaction) returns RESTAPI_PENDING
+// instead of busy-waiting; the server serves the other sockets and calls the handler again from its wait
+// (http_resources_resume()) until it returns the result.
+//
+//	static int16_t restapi_xxx(char* buf)
+//	{
+//		st_http_pt * pt = get_http_pt();
+//		st_json_writer w;
+//
+//		HTTP_PT_BEGIN(pt);
+//		... first call: the request (resource ID, parameters, body), kept in pt->data for the resumes
+//		HTTP_PT_WAIT_UNTIL(pt, condition);
+//		HTTP_PT_END(pt);
+//		... the response: restapi_writer_init(&w, buf) ... return restapi_writer_end(&w);
+//	}
+//
+// - The local variables are not kept across a wait (no stack): the state is in pt->data
+// - The request is valid until the first wait only; the response is written after HTTP_PT_END
+// - No wait inside a 'switch' of the handler (the waits are case labels)
+// - A pending handler is abandoned when its connection is closed
+
+#define HTTP_PT_DATA_SIZE		16		// Bytes of the handler state kept across the waits
+
+// Context of a resumable handler, one per HTTP socket
+typedef struct _st_http_pt
+{
+	uint16_t lc;		// Local continuation: line of the wait to resume at, 0: first call
+	uint8_t  accept;	// Representation of the response (HTTP_RES_TYPE_xxx of the 'Accept' header), kept for the resumes
+	uint32_t time;		// Start of HTTP_PT_WAIT_MSEC (getDeviceTime_usec)
+	union
+	{
+		uint8_t  u8[HTTP_PT_DATA_SIZE];
+		uint16_t u16[HTTP_PT_DATA_SIZE / 2];
+		uint32_t u32[HTTP_PT_DATA_SIZE / 4];
+	} data;
+} st_http_pt;
+
+#define HTTP_PT_BEGIN(pt)				switch((pt)->lc) { case 0:
+
+// Returns RESTAPI_PENDING until the condition is true, evaluated again at each resume
+#define HTTP_PT_WAIT_UNTIL(pt, cond)	do { (pt)->lc = __LINE__; case __LINE__: if(!(cond)) return RESTAPI_PENDING; } while(0)
+
+// Lets the other sockets be served once
+#define HTTP_PT_YIELD(pt)				do { (pt)->lc = __LINE__; return RESTAPI_PENDING; case __LINE__: ; } while(0)
+
+// Wait of 'msec' milliseconds (getDeviceTime_usec), resumed at the server passes after it
+#define HTTP_PT_WAIT_MSEC(pt, msec)		do { (pt)->time = getDeviceTime_usec(); \
+											HTTP_PT_WAIT_UNTIL(pt, (getDeviceTime_usec() - (pt)->time) >= ((uint32_t)(msec) * 1000)); } while(0)
+
+// End of the waits: the code after it runs once, at the call the last wait ends
+#define HTTP_PT_END(pt)					} (pt)->lc = 0
+
+#endif
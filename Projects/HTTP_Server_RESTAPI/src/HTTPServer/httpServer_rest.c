@@ -8,7 +8,15 @@
 #include "common.h"
 #include "httpServer_rest.h"
 #include "httpParser_rest.h"
+#include "httpArena.h"
 #include "RESTapiHandler.h"
+#include "httpStats.h"
+#include "timerHandler.h"
+#include "traceHandler.h"
+
+#define LOG_MODULE			LOG_MODULE_HTTPSERVER
+#define LOG_MODULE_LEVEL	LOG_LEVEL_HTTPSERVER
+#include "logHandler.h"
 
 
 #ifndef DATA_BUF_SIZE
@@ -20,11 +28,22 @@
  ****************************************************************************/
 static uint8_t httpsock_num[_WIZCHIP_SOCK_NUM_] = {0, };
 static st_http_request * http_request;				/**< Pointer to received HTTP request */
-static st_http_request * parsed_http_request;		/**< Pointer to parsed HTTP request */
-static uint8_t http_req[MAX_URI_SIZE+16];			/**< Pointer to parsed HTTP request */
+static st_http_request * parsed_http_request;		/**< Pointer to parsed HTTP request, in the request arena */
 
 static uint8_t * http_response;						/**< Pointer to HTTP response header*/
-static uint8_t * http_response_body;				/**< Pointer to HTTP response body*/
+static uint8_t * http_response_body;				/**< Pointer to HTTP response body (HTTP_RES_BODY_SIZE), after the room of a chunk-size line */
+
+static volatile int8_t http_active_sock = -1;		/**< H/W socket served by httpServer_run(), -1: none (crash capture) */
+
+// Response body flushed by the handler's JSON writer before the handler returns: sent as chunked
+static struct st_http_flush
+{
+	uint8_t  sock;
+	uint8_t  method;
+	uint16_t cache;
+	uint8_t  type;									/**< Content type of the response: JSON or CBOR (Accept), or the resource's one */
+	uint8_t  chunked;								/**< The response header (chunked) has been sent */
+} http_flush;
 
 /*****************************************************************************
  * Public types/enumerations/variables
@@ -38,8 +57,14 @@ volatile uint32_t httpServer_tick_1s = 0;
  * Private functions
  ****************************************************************************/
 static void http_process_handler(uint8_t sock, st_http_request * p_http_request);
-static void send_http_response_header(uint8_t sock, uint8_t * buf, uint8_t content_type, uint32_t body_len, uint16_t http_status);
+static uint8_t http_resume_handler(uint8_t sock, int8_t seq_num);
+static uint8_t http_handler_response(uint8_t sock, int8_t seq_num, int16_t content_len);
+static void http_flush_begin(uint8_t sock, int8_t seq_num);
+static void send_http_response(uint8_t sock, int8_t seq_num, uint16_t content_type, int32_t content_len, uint16_t http_status, const char * allow, uint16_t cache);
+static void send_http_response_header(uint8_t sock, uint8_t * buf, uint8_t content_type, uint32_t body_len, uint16_t http_status, const char * allow, uint16_t cache);
 static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t content_len);
+static void send_http_response_chunk(uint8_t sock, int8_t seqnum);
+static int16_t http_response_flush(void * ctx, const char * buf, uint16_t len);
 //static void send_http_response_header(uint8_t sock, uint8_t content_type, uint32_t body_len, uint16_t http_status);
 //static void send_http_response_body(uint8_t sock, uint8_t * uri_name, uint8_t * buf, uint32_t start_addr, uint32_t file_len);
 
@@ -47,6 +72,8 @@ static int8_t  getAvailableHTTPSocketNum(void);
 static uint8_t getHTTPSocketNum(uint8_t seqnum);
 static int8_t  getHTTPSequenceNum(uint8_t sock);
 static int8_t  http_disconnect(uint8_t sock);
+static int32_t http_send(uint8_t sock, uint8_t * buf, uint16_t len);
+static void    http_stats_end(int8_t seqnum, uint8_t complete);
 
 /*****************************************************************************
  * Public functions
@@ -90,6 +117,13 @@ void httpServer_init(uint8_t * tx_buf, uint8_t * rx_buf, uint8_t sock_cnt, uint8
 		// Mapping the H/W socket numbers to the sequential index numbers
 		httpsock_num[i] = sock_list[i];
 	}
+	
+	for(i = 0; i < _WIZCHIP_SOCK_NUM_; i++) HTTPSock[i].resource = -1;
+	
+	http_stats_init();
+	
+	// REST API resources: build the resource nodes once after the registration
+	build_http_resources();
 }
 
 /* HTTP Server Run */
@@ -99,19 +133,15 @@ void httpServer_run(uint16_t server_port)
 	uint8_t sock_status;	// HW socket status
 	int8_t seqnum; 			// Sequence number
 	int16_t len;
-	
-#ifdef _HTTPSERVER_DEBUG_
 	uint8_t destip[4] = {0, };	// Destination IP address
-	uint16_t destport = 0;		// Destination Port number
-#endif
 	
 	sock = getAvailableHTTPSocketNum(); // Get the H/W socket number
 	if(sock < 0) return; // HW socket allocation failed
 	
 	seqnum = getHTTPSequenceNum(sock);
+	http_active_sock = sock;
 	
 	http_request = (st_http_request *)httpserver.recvbuf;		// HTTP Request Structure
-	parsed_http_request = (st_http_request *)http_req;
 	//parsed_http_request = (st_http_request *)httpserver.sendbuf; // old
 	
 	/* Web Service Start */
@@ -123,6 +153,11 @@ void httpServer_run(uint16_t server_port)
 			if(getSn_IR(sock) & Sn_IR_CON)
 			{
 				setSn_IR(sock, Sn_IR_CON);
+				HTTPSock[seqnum].connections++;
+				
+				getSn_DIPR(sock, destip);
+				TRACE_EVENT(sock, TRACE_EV_HTTP_CONNECT, getSn_DPORT(sock),
+					((uint32_t)destip[0] << 24) | ((uint32_t)destip[1] << 16) | ((uint32_t)destip[2] << 8) | destip[3]);
 			}
 
 			// HTTP Process states
@@ -131,64 +166,70 @@ void httpServer_run(uint16_t server_port)
 				case STATE_HTTP_IDLE :
 					if ((len = getSn_RX_RSR(sock)) > 0)
 					{
+						HTTPSock[seqnum].req_start = getDeviceTime_usec(); // Request statistics: first received byte
+						
 						if (len > DATA_BUF_SIZE) len = DATA_BUF_SIZE;
 						if ((len = recv(sock, (uint8_t *)http_request, len)) < 0) break;	// Exception handler
 						
+						HTTPSock[seqnum].req_active = 1;
+						HTTPSock[seqnum].req_bytes = len;
+						HTTPSock[seqnum].res_bytes = 0;
+						HTTPSock[seqnum].res_status = 0;
+						HTTPSock[seqnum].route = -1;
+						
 						*(((uint8_t *)http_request) + len) = '\0';	// End of string (EOS) marker
 						
-						parse_http_request(parsed_http_request, (uint8_t *)http_request);
-
-#ifdef _HTTPSERVER_DEBUG_
-						printf("> HTTP Request START ==========\r\n");
-						printf("%s", (uint8_t *)http_request);
-						printf("> HTTP Request END ============\r\n");
-#endif
+						// Request arena: the parsed request, its URI and the temporaries of the router and the handler
+						parsed_http_request = (st_http_request *)http_arena_alloc(sizeof(st_http_request)); // First block of the pool
+						parse_http_request(parsed_http_request, (uint8_t *)http_request, len);
+						TRACE_EVENT(sock, TRACE_EV_HTTP_REQUEST, parsed_http_request->METHOD, len);
 						
-#ifdef _HTTPSERVER_DEBUG_
-						getSn_DIPR(sock, destip);
-						destport = getSn_DPORT(sock);
-						printf("\r\n");
-						printf("> HTTPSocket[%d] : HTTP Request received ", sock);
-						printf("from %d.%d.%d.%d : %d\r\n", destip[0], destip[1], destip[2], destip[3], destport);
-#endif
-
-#ifdef _HTTPSERVER_DEBUG_
-						printf("> HTTPSocket[%d] : [State] STATE_HTTP_REQ_DONE\r\n", sock);
-#endif
 						// HTTP 'response' handler; includes send_http_response_header / body function
 						http_process_handler(sock, parsed_http_request);
-
-						if(HTTPSock[seqnum].file_len > 0) HTTPSock[seqnum].status = STATE_HTTP_RES_INPROC;
-						else HTTPSock[seqnum].status = STATE_HTTP_RES_DONE; // Send the 'HTTP response' end
 						
+						http_arena_reset(); // The request has been processed: a pending handler keeps nothing in the arena
+						parsed_http_request = NULL;
+
+						if(HTTPSock[seqnum].status != STATE_HTTP_REQ_DONE) // STATE_HTTP_REQ_DONE: REST API handler pending, no response yet
+						{
+							if((HTTPSock[seqnum].file_len > 0) || (HTTPSock[seqnum].resource >= 0)) HTTPSock[seqnum].status = STATE_HTTP_RES_INPROC;
+							else HTTPSock[seqnum].status = STATE_HTTP_RES_DONE; // Send the 'HTTP response' end
+						}
+						
+						TRACE_EVENT(sock, TRACE_EV_HTTP_STATE, HTTPSock[seqnum].status, 0);
 					}
 					break;
 
+				case STATE_HTTP_REQ_DONE :
+					/* Resume the pending REST API handler: the other sockets are served between the resumes */
+					if(http_resume_handler(sock, seqnum))
+					{
+						HTTPSock[seqnum].status = STATE_HTTP_RES_DONE;
+						TRACE_EVENT(sock, TRACE_EV_HTTP_STATE, HTTPSock[seqnum].status, 0);
+					}
+					break;
 
 				case STATE_HTTP_RES_INPROC :
 					/* Repeat: Send the remain parts of HTTP responses */
-#ifdef _HTTPSERVER_DEBUG_
-					printf("> HTTPSocket[%d] : [State] STATE_HTTP_RES_INPROC\r\n", sock);
-#endif
 					// Repeatedly send remaining data to client
-					send_http_response_body(sock, http_response, 0);
+					if(HTTPSock[seqnum].resource >= 0) send_http_response_chunk(sock, seqnum);
+					else send_http_response_body(sock, http_response, 0);
 
-					if(HTTPSock[seqnum].file_len == 0) HTTPSock[seqnum].status = STATE_HTTP_RES_DONE;
+					if((HTTPSock[seqnum].file_len == 0) && (HTTPSock[seqnum].resource < 0)) HTTPSock[seqnum].status = STATE_HTTP_RES_DONE;
 					break;
 
 				case STATE_HTTP_RES_DONE :
-#ifdef _HTTPSERVER_DEBUG_
-					printf("> HTTPSocket[%d] : [State] STATE_HTTP_RES_DONE\r\n", sock);
-#endif
 					// Socket file info structure re-initialize
 					HTTPSock[seqnum].file_len = 0;
 					HTTPSock[seqnum].file_offset = 0;
 					HTTPSock[seqnum].file_start = 0;
+					HTTPSock[seqnum].resource = -1;
 					HTTPSock[seqnum].status = STATE_HTTP_IDLE;
 					
 #ifdef _USE_WATCHDOG_
 					HTTPServer_WDT_Reset();
 #endif
+					http_stats_end(seqnum, 1);
 					http_disconnect(sock);
 					break;
 
@@ -198,13 +239,16 @@ void httpServer_run(uint16_t server_port)
 			break;
 
 		case SOCK_CLOSE_WAIT:
-#ifdef _HTTPSERVER_DEBUG_
-			printf("> HTTPSocket[%d] : ClOSE_WAIT\r\n", sock);	// if a peer requests to close the current connection
-#endif
+			TRACE_EVENT(sock, TRACE_EV_HTTP_CLOSE_WAIT, HTTPSock[seqnum].status, 0); // if a peer requests to close the current connection
+			
+			// Request statistics: closed by the peer before the end of the response
+			http_stats_end(seqnum, (HTTPSock[seqnum].status == STATE_HTTP_RES_DONE));
+			
 			// Socket file info structure re-initialize: HTTP connection 'close'
 			HTTPSock[seqnum].file_len = 0;
 			HTTPSock[seqnum].file_offset = 0;
 			HTTPSock[seqnum].file_start = 0;
+			HTTPSock[seqnum].resource = -1;
 			HTTPSock[seqnum].status = STATE_HTTP_IDLE;
 			
 			http_disconnect(sock);
@@ -224,16 +268,20 @@ void httpServer_run(uint16_t server_port)
 			break;
 
 		case SOCK_CLOSED:
-#ifdef _HTTPSERVER_DEBUG_
-			//printf("> HTTPSocket[%d] : CLOSED\r\n", sock);
-#endif
+			http_stats_end(seqnum, 0); // Connection reset during a request
+			
+			// Response in progress or handler pending: abandoned with the connection
+			HTTPSock[seqnum].file_len = 0;
+			HTTPSock[seqnum].file_offset = 0;
+			HTTPSock[seqnum].file_start = 0;
+			HTTPSock[seqnum].resource = -1;
+			HTTPSock[seqnum].status = STATE_HTTP_IDLE;
+			
 			if(server_port == 0) server_port = HTTP_SERVER_PORT;
 			if(socket(sock, Sn_MR_TCP, server_port, 0x00) == sock) // Init / Reinitialize the socket
 			{
-#ifdef _HTTPSERVER_DEBUG_
-				printf("> HTTPSocket[%d] : SERVER OPEN, Port: %d\r\n", sock, server_port);
-#endif
-				;
+				HTTPSock[seqnum].opens++;
+				TRACE_EVENT(sock, TRACE_EV_HTTP_OPEN, server_port, 0);
 			}
 			break;
 
@@ -241,11 +289,83 @@ void httpServer_run(uint16_t server_port)
 			break;
 	} // end of switch
 
+	http_active_sock = -1;
+
 #ifdef _USE_WATCHDOG_
 	HTTPServer_WDT_Reset();
 #endif
 }
 
+/* HTTP Server socket being served: 0 if none, e.g. read by the HardFault handler (crashHandler.c) */
+uint8_t get_httpServer_active(uint8_t * sock, uint8_t * state)
+{
+	int8_t s = http_active_sock;
+	int8_t seqnum;
+
+	if(s < 0) return 0;
+
+	seqnum = getHTTPSequenceNum((uint8_t)s);
+	*sock = (uint8_t)s;
+	*state = (seqnum < 0) ? STATE_HTTP_IDLE : HTTPSock[seqnum].status;
+
+	return 1;
+}
+
+/* HTTP Server Busy: the next httpServer_run() has work to do */
+uint8_t httpServer_busy(void)
+{
+	uint8_t i;
+	uint8_t sock;
+
+	for(i = 0; i < httpserver.sock_cnt; i++)
+	{
+		if(HTTPSock[i].status != STATE_HTTP_IDLE) return 1;
+
+		sock = httpsock_num[i];
+		switch(getSn_SR(sock))
+		{
+			case SOCK_CLOSED:
+			case SOCK_INIT:
+			case SOCK_CLOSE_WAIT:
+				return 1;
+
+			case SOCK_ESTABLISHED:
+				if(getSn_RX_RSR(sock) > 0) return 1;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return 0;
+}
+
+/* HTTP Server Reaper: connections idle for HTTP_MAX_TIMEOUT_SEC, e.g., opened and left without a request */
+void httpServer_reap(void)
+{
+	uint8_t i;
+	uint8_t sock;
+
+	for(i = 0; i < httpserver.sock_cnt; i++)
+	{
+		sock = httpsock_num[i];
+		if((getSn_SR(sock) != SOCK_ESTABLISHED) || (HTTPSock[i].status != STATE_HTTP_IDLE) || (getSn_RX_RSR(sock) > 0))
+		{
+			HTTPSock[i].idle_sec = 0;
+			continue;
+		}
+
+		if(++HTTPSock[i].idle_sec > HTTP_MAX_TIMEOUT_SEC)
+		{
+			HTTPSock[i].idle_sec = 0;
+			HTTPSock[i].reaped++;
+			TRACE_EVENT(sock, TRACE_EV_HTTP_REAP, HTTP_MAX_TIMEOUT_SEC, 0);
+			http_disconnect(sock);
+		}
+	}
+}
+
 
 ////////////////////////////////////////////
 // Private Functions
@@ -254,17 +374,32 @@ void httpServer_run(uint16_t server_port)
 static void http_process_handler(uint8_t sock, st_http_request * p_http_request)
 {
 	uint8_t * uri_name;
-	uint8_t uri_buf[MAX_URI_SIZE]={0x00, };
+	uint8_t * uri_buf = NULL;
+	uint16_t uri_mark = http_arena_mark();
 	int32_t content_len = 0;
 	uint16_t status_code = 0;
 	uint16_t content_type;
-	int8_t table_num;
+	uint16_t rest_type;
+	int8_t table_num = -1;
+	uint8_t allow_methods = 0;
+	const char * allow = NULL;
+	uint16_t cache = HTTP_CACHE_DEFAULT;
+	const struct st_http_resource * resource;
 	
-	//int8_t seq_num;
-	//if((seq_num = getHTTPSequenceNum(sock)) == -1) return; // exception handling; invalid number
+	int8_t seq_num;
+	if((seq_num = getHTTPSequenceNum(sock)) == -1) return; // exception handling; invalid number
 	
 	http_response = httpserver.recvbuf;
-	http_response_body = httpserver.sendbuf;
+	http_response_body = httpserver.sendbuf + HTTP_CHUNK_HEADER_SIZE;
+	
+	// Representation of the REST API responses and the error messages: JSON, or CBOR if the client accepts it
+	rest_type = (p_http_request->ACCEPT == HTTP_RES_TYPE_CBOR) ? HTTP_RES_TYPE_CBOR : HTTP_RES_TYPE_JSON;
+	HTTPSock[seq_num].method = p_http_request->METHOD;
+	HTTPSock[seq_num].rest_type = rest_type;
+	
+	// Resource name: the path of the URI, with room for INITIAL_RESOURCE
+	if(p_http_request->URI != NULL) uri_buf = (uint8_t *)http_arena_alloc(strlen((char *)p_http_request->URI) + sizeof(INITIAL_RESOURCE));
+	if(uri_buf == NULL) p_http_request->METHOD = HTTP_REQ_METHOD_ERR; // No request line, or the request arena is full
 	
 	// method Analyze
 	switch (p_http_request->METHOD)
@@ -278,84 +413,91 @@ static void http_process_handler(uint8_t sock, st_http_request * p_http_request)
 			break;
 
 		case HTTP_REQ_METHOD_POST :
-			mid((char *)p_http_request->URI, "/", " HTTP", (char *)uri_buf);
+			get_http_uri_name(p_http_request->URI, uri_buf);	// Query string is not a part of the resource name
 			uri_name = uri_buf;
 			find_http_uri_type(&p_http_request->TYPE, uri_name); // Check file type
 			break;
 		
 		case HTTP_REQ_METHOD_PUT :
-			mid((char *)p_http_request->URI, "/", " HTTP", (char *)uri_buf);
+			get_http_uri_name(p_http_request->URI, uri_buf);
 			uri_name = uri_buf;
 			find_http_uri_type(&p_http_request->TYPE, uri_name); // Check file type
 			
 			break;
 		
 		case HTTP_REQ_METHOD_DELETE :
-			mid((char *)p_http_request->URI, "/", " HTTP", (char *)uri_buf);
+			get_http_uri_name(p_http_request->URI, uri_buf);
 			uri_name = uri_buf;
 			find_http_uri_type(&p_http_request->TYPE, uri_name); // Check file type
 			
 			break;
 		
+		case HTTP_REQ_METHOD_OPTIONS :
+			get_http_uri_name(p_http_request->URI, uri_buf);
+			uri_name = uri_buf;
+			if (!strcmp((char *)uri_name, "/")) strcpy((char *)uri_name, INITIAL_RESOURCE);
+			find_http_uri_type(&p_http_request->TYPE, uri_name);
+			break;
+		
 		case HTTP_REQ_METHOD_ERR :
 		default :
+			uri_name = uri_buf;
 			status_code = HTTP_RES_CODE_NOT_IMPLE;
 			break;
 	}
 	
-#ifdef _HTTPSERVER_DEBUG_
-	printf("\r\n> HTTPSocket[%d] : HTTP Method = %.4x\r\n", sock, p_http_request->METHOD);
-	printf("> HTTPSocket[%d] : Request Type = %d\r\n", sock, p_http_request->TYPE);
-	printf("> HTTPSocket[%d] : Request URI = %s\r\n", sock, uri_name);
-#endif
-	
-	if(p_http_request->TYPE == 0) // REST API request or Requested file type not found
+	if(status_code == HTTP_RES_CODE_NOT_IMPLE) // Method not supported: no resource search
 	{
-		table_num = search_http_resources(p_http_request->METHOD, uri_name); // get the resource table number
+		content_type = rest_type;
+	}
+	else if(p_http_request->TYPE == 0) // REST API request or Requested file type not found
+	{
+		// get the resource table number, and the methods / 'Allow' header value of the matched URI
+		table_num = search_http_resources(p_http_request->METHOD, uri_name, &allow_methods, &allow);
 		
-		if(table_num < 0) // HTTP resource search failed
+		if(p_http_request->METHOD == HTTP_REQ_METHOD_OPTIONS) // CORS preflight or OPTIONS request: answered from the methods of the resource
+		{
+			content_type = rest_type;
+			
+			if(allow_methods) status_code = HTTP_RES_CODE_NO_CONTENT;
+			else status_code = HTTP_RES_CODE_NOT_FOUND;
+		}
+		else if(table_num < 0) // HTTP resource search failed
 		{
 			//content_type = HTTP_RES_TYPE_TEXT;
-			content_type = HTTP_RES_TYPE_JSON;
+			content_type = rest_type;
 			
-			if(table_num == RESTAPI_ERROR_RESOURCE_NOT_FOUND) status_code = HTTP_RES_CODE_NOT_FOUND;	// uri unmatched
 			if(table_num == RESTAPI_ERROR_METHOD_NOT_ALLOWED) status_code = HTTP_RES_CODE_NOT_ALLOWED; 	// uri matched but not supported method
-			else status_code = HTTP_RES_CODE_NOT_FOUND;
+			else status_code = HTTP_RES_CODE_NOT_FOUND;	// uri unmatched
+		}
+		else if((resource = get_http_resource(table_num))->generate != NULL) // HTTP resource search success: streaming response
+		{
+			// The body is generated and sent by chunks in STATE_HTTP_RES_INPROC: text of the resource's content type, JSON by default
+			content_type = resource->content_type ? resource->content_type : HTTP_RES_TYPE_JSON;
+			status_code = HTTP_RES_CODE_OK;
+			content_len = HTTP_RES_LEN_CHUNKED;
+			cache = resource->cache;
+			
+			if(p_http_request->METHOD != HTTP_REQ_METHOD_HEAD)
+			{
+				HTTPSock[seq_num].resource = table_num;
+				HTTPSock[seq_num].file_offset = 0;
+			}
 		}
 		else // HTTP resource search success
 		{
 			// REST API function handler
 			// If necessary, generating JSON object of HTTP response body and copy the object to send buffer(http_response_body)
-			content_len = http_resources_handler(p_http_request, http_response_body, table_num, status_code);
+			HTTPSock[seq_num].route = table_num;
+			TRACE_EVENT(sock, TRACE_EV_HTTP_ROUTE, table_num, p_http_request->TYPE);
 			
-			// content_len variable: content body length or API handling results (e.g., http error)
-			if(content_len == 1)
-			{
-				content_type = HTTP_RES_TYPE_JSON;
-				status_code = HTTP_RES_CODE_CREATED;
-				content_len = 0;
-			}
-			else if(content_len > 0)
-			{
-				content_type = HTTP_RES_TYPE_JSON;
-				status_code = HTTP_RES_CODE_OK;
-			}
-			else if(content_len == 0)
-			{
-				content_type = HTTP_RES_TYPE_JSON;
-				status_code = HTTP_RES_CODE_NO_CONTENT;
-			}
-			else if(content_len == RESTAPI_ERROR_CONFLICT)
-			{
-				content_type = HTTP_RES_TYPE_JSON;
-				status_code = HTTP_RES_CODE_CONFLICT;
-			}
-			else
-			{
-				content_type = HTTP_RES_TYPE_JSON;
-				status_code = HTTP_RES_CODE_NOT_FOUND;
-			}
+			http_arena_release(uri_mark); // The resource name is not used by the handler: room for its temporaries
+			http_flush_begin(sock, seq_num);
+			content_len = http_resources_handler(p_http_request, http_response_body, table_num, status_code, &HTTPSock[seq_num].pt, http_response_flush, &http_flush);
 			
+			// Resumable handler waiting: resumed in STATE_HTTP_REQ_DONE
+			if(!http_handler_response(sock, seq_num, content_len)) HTTPSock[seq_num].status = STATE_HTTP_REQ_DONE;
+			return;
 		}
 	}
 	else
@@ -364,45 +506,133 @@ static void http_process_handler(uint8_t sock, st_http_request * p_http_request)
 		// If the size of the requested file is larger than the buffer size, use the file_len / file_offset field in HTTPSock statuc
 		
 		// Other methods: return 'content not found'
-		content_type = HTTP_RES_TYPE_JSON;
+		content_type = rest_type;
 		status_code = HTTP_RES_CODE_NOT_FOUND;
 	}
 	
+	HTTPSock[seq_num].route = table_num;
+	TRACE_EVENT(sock, TRACE_EV_HTTP_ROUTE, table_num, p_http_request->TYPE);
+	send_http_response(sock, seq_num, content_type, content_len, status_code, allow, cache);
+}
+
+// Returns 1 when the response of the handler has been sent, 0: the handler is still pending
+static uint8_t http_resume_handler(uint8_t sock, int8_t seq_num)
+{
+	int16_t content_len;
+	
+	http_response = httpserver.recvbuf;
+	http_response_body = httpserver.sendbuf + HTTP_CHUNK_HEADER_SIZE;
+	
+	http_flush_begin(sock, seq_num);
+	content_len = http_resources_resume(http_response_body, HTTPSock[seq_num].route, &HTTPSock[seq_num].pt, http_response_flush, &http_flush);
+	
+	return http_handler_response(sock, seq_num, content_len);
+}
+
+// Response of the REST API handler (HTTPSock[seq_num].route); returns 0 if the handler is pending (RESTAPI_PENDING)
+static uint8_t http_handler_response(uint8_t sock, int8_t seq_num, int16_t content_len)
+{
+	const struct st_http_resource * resource = get_http_resource(HTTPSock[seq_num].route);
+	uint16_t rest_type = HTTPSock[seq_num].rest_type;
+	uint16_t content_type = rest_type;
+	uint16_t status_code;
+	uint16_t cache = HTTP_CACHE_DEFAULT;
+	
+	if(content_len == RESTAPI_PENDING) return 0;
+	
+	// The body was larger than the buffer: the header and the body have been sent in chunks by the writer
+	if(http_flush.chunked)
+	{
+		if(content_len > 0) content_len = http_response_flush(&http_flush, (char *)http_response_body, content_len);
+		
+		// Error after the 200 header (writer overflow, failed send): no last-chunk, the client sees a truncated body
+		// when the connection is closed (STATE_HTTP_RES_DONE); res_status 0: counted as an error by the statistics
+		if(content_len < 0)
+		{
+			HTTPSock[seq_num].res_status = 0;
+			return 1;
+		}
+		
+		HTTPSock[seq_num].res_status = HTTP_RES_CODE_OK;
+		if(HTTPSock[seq_num].method != HTTP_REQ_METHOD_HEAD) http_send(sock, (uint8_t *)"0\r\n\r\n", 5); // last-chunk
+		return 1;
+	}
+	
+	// content_len variable: content body length or API handling results (e.g., http error)
+	if(content_len == 1)
+	{
+		status_code = HTTP_RES_CODE_CREATED;
+		content_len = 0;
+	}
+	else if(content_len > 0)
+	{
+		content_type = resource->content_type ? resource->content_type : rest_type;
+		status_code = HTTP_RES_CODE_OK;
+		cache = resource->cache;
+	}
+	else if(content_len == 0) status_code = HTTP_RES_CODE_NO_CONTENT;
+	else if(content_len == RESTAPI_ERROR_CONFLICT) status_code = HTTP_RES_CODE_CONFLICT;
+	else if(content_len == RESTAPI_ERROR_BAD_REQUEST) status_code = HTTP_RES_CODE_BAD_REQUEST;
+	else if(content_len == RESTAPI_ERROR_OVERFLOW) status_code = HTTP_RES_CODE_INT_SERVER;
+	else if(content_len == RESTAPI_ERROR_TOO_LARGE) status_code = HTTP_RES_CODE_TOO_LARGE;
+	else status_code = HTTP_RES_CODE_NOT_FOUND;
+	
+	send_http_response(sock, seq_num, content_type, content_len, status_code, NULL, cache);
+	
+	return 1;
+}
+
+// Overflow policy of the REST API handler's writer: chunked response on the socket of the request
+static void http_flush_begin(uint8_t sock, int8_t seq_num)
+{
+	const struct st_http_resource * resource = get_http_resource(HTTPSock[seq_num].route);
+	
+	http_flush.sock = sock;
+	http_flush.method = HTTPSock[seq_num].method;
+	http_flush.cache = resource->cache;
+	http_flush.type = resource->content_type ? resource->content_type : HTTPSock[seq_num].rest_type;
+	http_flush.chunked = 0;
+}
+
+// Response header and body (http_response_body: 'content_len' bytes); error status codes get the error message body
+static void send_http_response(uint8_t sock, int8_t seq_num, uint16_t content_type, int32_t content_len, uint16_t http_status, const char * allow, uint16_t cache)
+{
 	// HTTP response error codes; 4xx or 5xx
-	// Generate the JSON body {"message": "xxxxxx", "code": xxx}
-	if(((status_code & HTTP_RES_CODE_BAD_REQUEST) == HTTP_RES_CODE_BAD_REQUEST) || ((status_code & HTTP_RES_CODE_INT_SERVER) == HTTP_RES_CODE_INT_SERVER))
+	// Generate the JSON (or CBOR) body {"message": "xxxxxx", "code": xxx}
+	if(((http_status & HTTP_RES_CODE_BAD_REQUEST) == HTTP_RES_CODE_BAD_REQUEST) || ((http_status & HTTP_RES_CODE_INT_SERVER) == HTTP_RES_CODE_INT_SERVER))
 	{
 		// Generating JSON object of HTTP Error messages
 		// e.g., {"errors":{ "error" : { "message":"Method not allowed", "code":404 } }
-		content_len = make_http_response_error_message(http_response_body, status_code);
+		content_type = HTTPSock[seq_num].rest_type;
+		content_len = make_http_response_error_message(http_response_body, http_status, content_type);
 	}
 	
 	// Generate and Send the HTTP response 'header'
-	send_http_response_header(sock, http_response, content_type, content_len, status_code);
+	// 'Allow' header: OPTIONS and 405 Method Not Allowed responses
+	if((http_status != HTTP_RES_CODE_NOT_ALLOWED) && (HTTPSock[seq_num].method != HTTP_REQ_METHOD_OPTIONS)) allow = NULL;
+	HTTPSock[seq_num].res_status = http_status;
+	send_http_response_header(sock, http_response, content_type, content_len, http_status, allow, cache);
 	
 	// If necessary, Send the HTTP response 'body'
-	if(p_http_request->METHOD != HTTP_REQ_METHOD_HEAD)
+	if(HTTPSock[seq_num].method != HTTP_REQ_METHOD_HEAD)
 	{
 		if(content_len > 0) send_http_response_body(sock, http_response_body, content_len);
 	}
 }
 
 
-static void send_http_response_header(uint8_t sock, uint8_t * buf, uint8_t content_type, uint32_t body_len, uint16_t http_status)
+static void send_http_response_header(uint8_t sock, uint8_t * buf, uint8_t content_type, uint32_t body_len, uint16_t http_status, const char * allow, uint16_t cache)
 {
-	make_http_response_header((char*)http_response, content_type, body_len, http_status);
-	send(sock, http_response, strlen((char *)http_response));
+	make_http_response_header((char*)buf, content_type, body_len, http_status, allow, cache);
+	http_send(sock, buf, strlen((char *)buf));
 	
-#ifdef _HTTPSERVER_DEBUG_
-	printf("> HTTPSocket[%d] : [Send] HTTP Response Header [ %d ]byte\r\n", sock, (uint16_t)strlen((char *)http_response));
-	printf("> HTTPSocket[%d] : [Send] HTTP Response Header\r\n %s", sock, (char *)http_response);
-#endif
+	TRACE_EVENT(sock, TRACE_EV_HTTP_RESPONSE, http_status, body_len);
 }
 
 //static void send_http_response_body(uint8_t sock, uint8_t * uri_name, uint8_t * buf, uint32_t start_addr, uint32_t file_len)
 static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t content_len)
 {
-	send(sock, buf, content_len);
+	http_send(sock, buf, content_len);
 	
 /*
 	int8_t get_seqnum;
@@ -430,24 +660,17 @@ static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t conten
 /////////////////////////////////////////////////////////////////////////////////////////////////
 // ## 20141219 Eric added, for 'File object structure' (fs) allocation reduced (8 -> 1)
 			memset(HTTPSock[get_seqnum].file_name, 0x00, MAX_CONTENT_NAME_LEN);
-			strcpy((char *)HTTPSock[get_seqnum].file_name, (char *)uri_name);
-#ifdef _HTTPSERVER_DEBUG_
-			printf("> HTTPSocket[%d] : HTTP Response body - file name [ %s ]\r\n", s, HTTPSock[get_seqnum].file_name);
-#endif
+			strcpy((char *)HTTPSock[get_seqnum].file_name, (char *)uri_name); // Not logged: '%s' arguments are printed later, the buffer of the socket may be reused
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
-#ifdef _HTTPSERVER_DEBUG_
-			printf("> HTTPSocket[%d] : HTTP Response body - file len [ %ld ]byte\r\n", s, file_len);
-#endif
+			LOG_DEBUG2("Socket %d: HTTP Response body - file len [ %d ]byte", s, file_len);
 		}
 		else
 		{
 			// Send process end
 			send_len = file_len;
 
-#ifdef _HTTPSERVER_DEBUG_
-			printf("> HTTPSocket[%d] : HTTP Response end - file len [ %ld ]byte\r\n", s, send_len);
-#endif
+			LOG_DEBUG2("Socket %d: HTTP Response end - file len [ %d ]byte", s, send_len);
 		}
 #ifdef _USE_FLASH_
 		addr = start_addr;
@@ -467,15 +690,11 @@ static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t conten
 		}
 		else
 		{
-#ifdef _HTTPSERVER_DEBUG_
-			printf("> HTTPSocket[%d] : HTTP Response end - file len [ %ld ]byte\r\n", s, HTTPSock[get_seqnum].file_len);
-#endif
+			LOG_DEBUG2("Socket %d: HTTP Response end - file len [ %d ]byte", s, HTTPSock[get_seqnum].file_len);
 			// Send process end
 			flag_datasend_end = 1;
 		}
-#ifdef _HTTPSERVER_DEBUG_
-			printf("> HTTPSocket[%d] : HTTP Response body - send len [ %ld ]byte\r\n", s, send_len);
-#endif
+			LOG_DEBUG2("Socket %d: HTTP Response body - send len [ %d ]byte", s, send_len);
 
 // ## 20141219 Eric added, for 'File object structure' (fs) allocation reduced (8 -> 1)
 #ifdef _USE_SDCARD_
@@ -486,9 +705,7 @@ static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t conten
 			else
 			{
 				send_len = 0;
-#ifdef _HTTPSERVER_DEBUG_
-				printf("> HTTPSocket[%d] : [FatFs] Error code return: %d (File Open) / HTTP Send Failed - %s\r\n", s, fr, HTTPSock[get_seqnum].file_name);
-#endif
+				LOG_ERROR2("Socket %d: [FatFs] Error code return: %d (File Open) / HTTP Send Failed", s, fr);
 			}
 #endif
 // ## 20141219 added end
@@ -500,9 +717,7 @@ static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t conten
 	if(fr != FR_OK)
 	{
 		send_len = 0;
-#ifdef _HTTPSERVER_DEBUG_
-		printf("> HTTPSocket[%d] : [FatFs] Error code return: %d (File Read) / HTTP Send Failed - %s\r\n", s, fr, HTTPSock[get_seqnum].file_name);
-#endif
+		LOG_ERROR2("Socket %d: [FatFs] Error code return: %d (File Read) / HTTP Send Failed", s, fr);
 	}
 	else
 	{
@@ -515,9 +730,7 @@ static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t conten
 #endif
 
 	// Requested content send to HTTP client
-#ifdef _HTTPSERVER_DEBUG_
-	printf("> HTTPSocket[%d] : [Send] HTTP Response body [ %ld ]byte\r\n", s, send_len);
-#endif
+	LOG_DEBUG2("Socket %d: [Send] HTTP Response body [ %d ]byte", s, send_len);
 
 	if(send_len) send(s, buf, send_len);
 	else flag_datasend_end = 1;
@@ -532,9 +745,7 @@ static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t conten
 	else
 	{
 		HTTPSock[get_seqnum].file_offset += send_len;
-#ifdef _HTTPSERVER_DEBUG_
-		printf("> HTTPSocket[%d] : HTTP Response body - offset [ %ld ]\r\n", s, HTTPSock[get_seqnum].file_offset);
-#endif
+		LOG_DEBUG2("Socket %d: HTTP Response body - offset [ %d ]", s, HTTPSock[get_seqnum].file_offset);
 	}
 
 // ## 20141219 Eric added, for 'File object structure' (fs) allocation reduced (8 -> 1)
@@ -546,6 +757,76 @@ static void send_http_response_body(uint8_t sock, uint8_t * buf, uint16_t conten
 }
 
 
+// Streaming response: one chunk per call, generated by the resource's body generator
+static void send_http_response_chunk(uint8_t sock, int8_t seqnum)
+{
+	const struct st_http_resource * resource = get_http_resource(HTTPSock[seqnum].resource);
+	uint8_t * buf = httpserver.sendbuf;
+	char chunk_header[HTTP_CHUNK_HEADER_SIZE + 1];
+	uint8_t header_len;
+	int16_t len = 0;
+	
+	// Wait for the free space of the socket TX buffer (non-blocking)
+	if(getSn_TX_FSR(sock) < (HTTP_CHUNK_HEADER_SIZE + HTTP_CHUNK_SIZE + 2)) return;
+	
+	if(resource && resource->generate)
+		len = resource->generate((char *)buf + HTTP_CHUNK_HEADER_SIZE, HTTP_CHUNK_SIZE, &HTTPSock[seqnum].file_offset);
+	
+	if(len > 0)
+	{
+		// chunk = chunk-size CRLF chunk-data CRLF; the chunk-size is placed right before the data
+		header_len = sprintf(chunk_header, "%X\r\n", len);
+		memcpy(buf + HTTP_CHUNK_HEADER_SIZE - header_len, chunk_header, header_len);
+		memcpy(buf + HTTP_CHUNK_HEADER_SIZE + len, "\r\n", 2);
+		
+		http_send(sock, buf + HTTP_CHUNK_HEADER_SIZE - header_len, header_len + len + 2);
+		TRACE_EVENT(sock, TRACE_EV_HTTP_CHUNK, len, HTTPSock[seqnum].file_offset);
+	}
+	else
+	{
+		// last-chunk
+		http_send(sock, (uint8_t *)"0\r\n\r\n", 5);
+		HTTPSock[seqnum].resource = -1;
+		TRACE_EVENT(sock, TRACE_EV_HTTP_STREAM_END, 0, HTTPSock[seqnum].file_offset);
+	}
+}
+
+
+/* Overflow policy of the handler's JSON writer: sends the full buffer as a chunk, the response header is sent first.
+   buf: http_response_body, with the room of the chunk framing around it (HTTP_RES_BODY_SIZE) */
+static int16_t http_response_flush(void * ctx, const char * buf, uint16_t len)
+{
+	struct st_http_flush * flush = (struct st_http_flush *)ctx;
+	uint8_t * chunk = (uint8_t *)buf;
+	char chunk_header[HTTP_CHUNK_HEADER_SIZE + 1];
+	uint8_t header_len;
+	uint8_t * header;
+	uint16_t mark;
+	
+	if(!flush->chunked)
+	{
+		// Header in the request arena: the receive buffer holds the request (body, parameters) of the running handler
+		mark = http_arena_mark();
+		if((header = (uint8_t *)http_arena_alloc(HTTP_CHUNKED_HEADER_SIZE)) == NULL) return -1;
+		send_http_response_header(flush->sock, header, flush->type, HTTP_RES_LEN_CHUNKED, HTTP_RES_CODE_OK, NULL, flush->cache);
+		http_arena_release(mark);
+		flush->chunked = 1;
+	}
+	
+	// HEAD: header only; zero-length chunk is the last-chunk, not sent here
+	if((flush->method == HTTP_REQ_METHOD_HEAD) || (len == 0)) return len;
+	
+	// chunk = chunk-size CRLF chunk-data CRLF, in one send; the chunk-size is placed right before the data
+	header_len = sprintf(chunk_header, "%X\r\n", len);
+	memcpy(chunk - header_len, chunk_header, header_len);
+	memcpy(chunk + len, "\r\n", 2);
+	if(http_send(flush->sock, chunk - header_len, header_len + len + 2) <= 0) return -1;
+	
+	TRACE_EVENT(flush->sock, TRACE_EV_HTTP_CHUNK, len, 0);
+	return len;
+}
+
+
 static int8_t getAvailableHTTPSocketNum(void)
 {
 	int8_t sock;
@@ -588,6 +869,34 @@ static int8_t http_disconnect(uint8_t sock)
 }
 
 
+/* send() of the responses: the bytes sent are counted for the request statistics */
+static int32_t http_send(uint8_t sock, uint8_t * buf, uint16_t len)
+{
+	int32_t ret = send(sock, buf, len);
+	int8_t seqnum;
+	
+	if((ret > 0) && ((seqnum = getHTTPSequenceNum(sock)) >= 0)) HTTPSock[seqnum].res_bytes += ret;
+	else if(ret <= 0) TRACE_EVENT(sock, TRACE_EV_HTTP_SEND_ERR, len, ret);
+	
+	return ret;
+}
+
+
+/* End of a request: route, status code, bytes and the time from the first received byte; 'complete' = 0: no (complete) response */
+static void http_stats_end(int8_t seqnum, uint8_t complete)
+{
+	uint32_t usec;
+	
+	if(!HTTPSock[seqnum].req_active) return;
+	
+	usec = getDeviceTime_usec() - HTTPSock[seqnum].req_start;
+	http_stats_record(HTTPSock[seqnum].route, complete ? HTTPSock[seqnum].res_status : 0, HTTPSock[seqnum].req_bytes,
+		HTTPSock[seqnum].res_bytes, usec);
+	TRACE_EVENT(getHTTPSocketNum(seqnum), TRACE_EV_HTTP_DONE, complete ? HTTPSock[seqnum].res_status : 0, usec);
+	HTTPSock[seqnum].req_active = 0;
+}
+
+
 void httpServer_time_handler(void)
 {
 	httpServer_tick_1s++;
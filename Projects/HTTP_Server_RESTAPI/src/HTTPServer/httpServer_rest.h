@@ -8,9 +8,9 @@
 
 #include <stdint.h>
 #include "W7500x_wztoe.h"
+#include "httpPt.h"
 
-// HTTP Server debug message enable
-#define _HTTPSERVER_DEBUG_
+// HTTP Server debug messages: trace events (traceHandler.h), drained by '/diag/trace'; log messages: LOG_LEVEL_HTTPSERVER (logHandler.h)
 
 #define INITIAL_WEBPAGE				"index.html"
 #define INITIAL_RESOURCE			"index"
@@ -23,15 +23,15 @@
 #endif
 */
 
-/* Watchdog timer */
-//#define _USE_WATCHDOG_
+/* Watchdog timer: the WDT reset callback (reg_httpServer_cbfunc) is the check-in of the HTTP server, once per httpServer_run() */
+#define _USE_WATCHDOG_
 
 /*********************************************
 * HTTP Process states list
 *********************************************/
 #define STATE_HTTP_IDLE             0        /* IDLE, Waiting for data received (TCP established) */
 #define STATE_HTTP_REQ_INPROC  		1        /* Received HTTP request from HTTP client */
-#define STATE_HTTP_REQ_DONE    		2        /* The end of HTTP request parse */
+#define STATE_HTTP_REQ_DONE    		2        /* The end of HTTP request parse, REST API handler pending (resumed) */
 #define STATE_HTTP_RES_INPROC  		3        /* Sending the HTTP response to HTTP client (in progress) */
 #define STATE_HTTP_RES_DONE    		4        /* The end of HTTP response send (HTTP transaction ended) */
 
@@ -51,7 +51,7 @@
 /*********************************************
 * HTTP Timeout
 *********************************************/
-#define HTTP_MAX_TIMEOUT_SEC		3 // Sec.
+#define HTTP_MAX_TIMEOUT_SEC		3 // Sec., connection without a request: closed by httpServer_reap()
 
 typedef enum
 {
@@ -71,13 +71,41 @@ struct st_http_info
 	uint8_t  storage_type;
 };
 
+/*********************************************
+* HTTP Streaming response (Transfer-Encoding: chunked)
+*********************************************/
+#define HTTP_CHUNK_SIZE				1024	// Max. body length of a chunk
+#define HTTP_CHUNK_HEADER_SIZE		6		// Chunk size in hex (max. 4-digit) + CRLF
+
+// Response body buffer of the REST API handlers: the send buffer less the framing of a chunk around it (chunk-size line
+// before, CRLF after), so a full buffer is sent as one chunk by one send
+#define HTTP_RES_BODY_SIZE			(DATA_BUF_SIZE - HTTP_CHUNK_HEADER_SIZE - 2)
+#define HTTP_CHUNKED_HEADER_SIZE	224		// Response header of a chunked REST API response (no 'Allow'), in the request arena
+
 typedef struct _st_http_socket
 {
 	uint8_t  status;
 	uint8_t  file_name[MAX_CONTENT_NAME_LEN];
 	uint32_t file_start;
 	uint32_t file_len;
-	uint32_t file_offset; // (start addr + sent size...)
+	uint32_t file_offset; // (start addr + sent size...) or the cursor of streaming response body generator
+	int8_t   resource;    // Streaming response: resource table number of the body generator, -1: not used
+	// Request of the REST API handler, kept while the handler is pending (STATE_HTTP_REQ_DONE)
+	uint8_t  method;      // HTTP_REQ_METHOD_xxx
+	uint8_t  rest_type;   // Representation of the responses: HTTP_RES_TYPE_JSON or HTTP_RES_TYPE_CBOR
+	st_http_pt pt;        // Resumable handler context (httpPt.h)
+	// Request statistics (httpStats.h)
+	uint8_t  req_active;  // A request is in progress: received, response not ended
+	int8_t   route;       // Resource table number, -1: none
+	uint16_t req_bytes;   // Request bytes received
+	uint16_t res_status;  // Status code of the response
+	uint32_t res_bytes;   // Response bytes sent
+	uint32_t req_start;   // Time of the first received byte (getDeviceTime_usec)
+	// Socket counters (httpMetrics.h)
+	uint32_t connections; // TCP connections established
+	uint32_t opens;       // Server socket (re)opens
+	uint32_t reaped;      // Connections closed by httpServer_reap()
+	uint8_t  idle_sec;    // Connected without a request (httpServer_reap)
 } st_http_socket;
 
 void reg_httpServer_cbfunc(void(*mcu_reset)(void), void(*wdt_reset)(void));
@@ -85,6 +113,16 @@ void reg_httpServer_cbfunc(void(*mcu_reset)(void), void(*wdt_reset)(void));
 void httpServer_init(uint8_t * tx_buf, uint8_t * rx_buf, uint8_t sock_cnt, uint8_t * sock_list);
 void httpServer_run(uint16_t server_port);
 
+// H/W socket served by httpServer_run() and its state (STATE_HTTP_xxx), 0: not in httpServer_run()
+uint8_t get_httpServer_active(uint8_t * sock, uint8_t * state);
+
+// 1: a response in progress, received data or a socket to (re)open / close: call httpServer_run() again without
+// waiting for a socket event
+uint8_t httpServer_busy(void);
+
+// Reaper, every second: closes the connections which sent no request within HTTP_MAX_TIMEOUT_SEC
+void httpServer_reap(void);
+
 /*
  * @brief HTTP Server 1sec Tick Timer handler
  * @note SHOULD BE register to your system 1s Tick timer handler
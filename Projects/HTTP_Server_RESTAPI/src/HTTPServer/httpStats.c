@@ -0,0 +1,121 @@
+/**
+ * @file	httpStats.c
+ * @brief	HTTP Server - Request counters and latency histograms per resource and per status code
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#include <string.h>
+
+#include "httpParser_rest.h"
+#include "httpStats.h"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+// Status codes with their own counters; the others are counted in the last item
+static const uint16_t http_stats_codes[] =
+{
+	HTTP_RES_CODE_OK,
+	HTTP_RES_CODE_CREATED,
+	HTTP_RES_CODE_NO_CONTENT,
+	HTTP_RES_CODE_BAD_REQUEST,
+	HTTP_RES_CODE_NOT_FOUND,
+	HTTP_RES_CODE_NOT_ALLOWED,
+	HTTP_RES_CODE_CONFLICT,
+	HTTP_RES_CODE_TOO_LARGE,
+	HTTP_RES_CODE_INT_SERVER,
+	HTTP_RES_CODE_NOT_IMPLE,
+	0 // Last item should be set to 0: other status codes, or no response
+};
+
+#define HTTP_STATS_CODES	(sizeof(http_stats_codes) / sizeof(http_stats_codes[0]))
+
+static st_http_stats stats_route[HTTP_STATS_ROUTES];
+static st_http_stats stats_status[HTTP_STATS_CODES];
+static st_http_latency latency_route[HTTP_STATS_ROUTES];
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+static void http_stats_add(st_http_stats * s, uint8_t error, uint16_t bytes_in, uint32_t bytes_out)
+{
+	s->requests++;
+	if(error) s->errors++;
+	s->bytes_in += bytes_in;
+	s->bytes_out += bytes_out;
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+void http_stats_init(void)
+{
+	memset(stats_route, 0, sizeof(stats_route));
+	memset(stats_status, 0, sizeof(stats_status));
+	memset(latency_route, 0, sizeof(latency_route));
+}
+
+// No CLZ on Cortex-M0: shifts, at most HTTP_STATS_BUCKETS times
+uint8_t http_stats_bucket(uint32_t usec)
+{
+	uint8_t bucket = 0;
+	
+	if(usec) usec--; // Upper bounds are inclusive, as the le label of the exported histogram
+	usec >>= (HTTP_STATS_BUCKET_MIN - 1);
+	while((usec >>= 1) && (bucket < HTTP_STATS_BUCKETS - 1)) bucket++;
+	
+	return bucket;
+}
+
+void http_stats_record(int8_t route, uint16_t status, uint16_t bytes_in, uint32_t bytes_out, uint32_t usec)
+{
+	uint8_t error = (status == 0) || (status >= HTTP_RES_CODE_BAD_REQUEST);
+	st_http_latency * latency;
+	uint8_t i;
+	
+	if((route < 0) || (route >= HTTP_STATS_NO_ROUTE)) route = HTTP_STATS_NO_ROUTE;
+	http_stats_add(&stats_route[route], error, bytes_in, bytes_out);
+	
+	for(i = 0; http_stats_codes[i] != 0; i++)
+	{
+		if(http_stats_codes[i] == status) break;
+	}
+	http_stats_add(&stats_status[i], error, bytes_in, bytes_out);
+	
+	latency = &latency_route[route];
+	latency->hist[http_stats_bucket(usec)]++;
+	latency->usec += usec; // No divide on Cortex-M0: the latencies are short
+	while(latency->usec >= 1000000)
+	{
+		latency->usec -= 1000000;
+		latency->sec++;
+	}
+}
+
+const st_http_stats * get_http_stats_route(uint8_t route)
+{
+	if(route >= HTTP_STATS_ROUTES) return NULL;
+	
+	return &stats_route[route];
+}
+
+const st_http_stats * get_http_stats_status(uint8_t index, uint16_t * status)
+{
+	if(index >= HTTP_STATS_CODES) return NULL;
+	
+	if(status) *status = http_stats_codes[index];
+	
+	return &stats_status[index];
+}
+
+const st_http_latency * get_http_latency_route(uint8_t route)
+{
+	if(route >= HTTP_STATS_ROUTES) return NULL;
+	
+	return &latency_route[route];
+}
@@ -0,0 +1,58 @@
+/**
+ * @file	httpStats.h
+ * @brief	Header File for HTTP Server - Request counters and latency histograms per resource and per status code
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#ifndef	__HTTPSTATS_H__
+#define	__HTTPSTATS_H__
+
+#include <stdint.h>
+
+#include "RESTapiHandler.h"	// MAX_HTTP_RESOURCES
+
+// Latency histogram: log2 buckets of microseconds, from the first received byte of the request to the last byte
+// of the response handed to the TCP/IP core. Bucket 0: up to 16us, bucket n: 2^(n+3)+1 to 2^(n+4) us, last bucket: over 2^18us
+#define HTTP_STATS_BUCKETS		16
+#define HTTP_STATS_BUCKET_MIN	4		// log2 of the upper bound of bucket 0
+
+// Routes: the resource table numbers, then the requests which matched no resource (404 / 501 / OPTIONS ...)
+#define HTTP_STATS_ROUTES		(MAX_HTTP_RESOURCES + 1)
+#define HTTP_STATS_NO_ROUTE		MAX_HTTP_RESOURCES
+
+typedef struct _st_http_stats
+{
+	uint32_t requests;
+	uint32_t errors;						// 4xx / 5xx responses, responses cut by the peer or by a handler error
+	uint32_t bytes_in;						// Request bytes received
+	uint32_t bytes_out;						// Response bytes sent
+} st_http_stats;
+
+// Latency histogram of a route (the histogram is exported per route only): the buckets wrap at 2^32 as the request
+// counter, their sum is 'requests' of the route
+typedef struct _st_http_latency
+{
+	uint32_t sec;							// Sum of the latencies: sec + usec, wraps after 136 years
+	uint32_t usec;
+	uint32_t hist[HTTP_STATS_BUCKETS];
+} st_http_latency;
+
+void http_stats_init(void);
+
+// Called at the end of each request; 'route': resource table number or -1, 'status': status code sent, 0 if none
+void http_stats_record(int8_t route, uint16_t status, uint16_t bytes_in, uint32_t bytes_out, uint32_t usec);
+
+// Snapshot access while the server runs (main loop context): NULL at the end of the list
+const st_http_stats * get_http_stats_route(uint8_t route);
+const st_http_stats * get_http_stats_status(uint8_t index, uint16_t * status);
+const st_http_latency * get_http_latency_route(uint8_t route);
+
+// Bucket of a latency (us)
+uint8_t http_stats_bucket(uint32_t usec);
+
+#endif
@@ -0,0 +1,485 @@
+/**
+ * @file	jsonDecoder.c
+ * @brief	HTTP Server - Schema-driven JSON / CBOR decoder
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#include <string.h>
+
+#include "jsonDecoder.h"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+typedef struct _st_json_scan
+{
+	const char * start;
+	const char * cur;
+	const char * end;
+} st_json_scan;
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+static int8_t json_decode_value(st_json_scan * s, const struct st_json_field * f, void * obj);
+static int8_t json_decode_error(st_json_decode_result * res, const st_json_scan * s, const char * pos, int8_t error);
+static void json_skip_ws(st_json_scan * s);
+static uint8_t json_expect(st_json_scan * s, char ch);
+static uint8_t json_scan_literal(st_json_scan * s, const char * lit);
+static int8_t json_scan_int(st_json_scan * s, int32_t * val);
+static int8_t json_scan_str(st_json_scan * s, char * dst, uint16_t size, uint16_t * len);
+static int8_t json_scan_hex4(st_json_scan * s, uint16_t * code);
+static int8_t cbor_decode_value(st_json_scan * s, const struct st_json_field * f, void * obj);
+static int8_t cbor_scan_head(st_json_scan * s, uint8_t * major, uint32_t * val, uint8_t * indef);
+
+// CBOR major types and simple values
+#define CBOR_UINT               0
+#define CBOR_NINT               1
+#define CBOR_TEXT               3
+#define CBOR_MAP                5
+#define CBOR_SIMPLE             7
+#define CBOR_FALSE              20
+#define CBOR_TRUE               21
+#define CBOR_BREAK              0xFF
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+int8_t json_decode(const char * json, uint16_t len, const struct st_json_field * fields, void * obj, st_json_decode_result * res)
+{
+	st_json_scan s;
+	char key[JSON_DECODE_KEY_SIZE];
+	uint16_t key_len;
+	const char * pos;
+	uint8_t i;
+	int8_t ret;
+
+	s.start = json;
+	s.cur = json;
+	s.end = json + len;
+
+	res->error = 0;
+	res->field = JSON_DECODE_NO_FIELD;
+	res->pos = 0;
+	res->present = 0;
+
+	json_skip_ws(&s);
+	if(!json_expect(&s, '{')) return json_decode_error(res, &s, s.cur, JSON_DECODE_ERROR_SYNTAX);
+
+	json_skip_ws(&s);
+	if(!json_expect(&s, '}'))
+	{
+		for(;;)
+		{
+			// Key: the member of the schema
+			json_skip_ws(&s);
+			pos = s.cur;
+			if((s.cur >= s.end) || (*s.cur != '"')) return json_decode_error(res, &s, s.cur, JSON_DECODE_ERROR_SYNTAX);
+			if((ret = json_scan_str(&s, key, sizeof(key), &key_len)) < 0) return json_decode_error(res, &s, s.cur, ret);
+
+			for(i = 0; fields[i].key != NULL; i++)
+			{
+				if((key_len < sizeof(key)) && !strcmp(fields[i].key, key)) break;
+			}
+			if(fields[i].key == NULL) return json_decode_error(res, &s, pos, JSON_DECODE_ERROR_KEY);
+
+			json_skip_ws(&s);
+			if(!json_expect(&s, ':')) return json_decode_error(res, &s, s.cur, JSON_DECODE_ERROR_SYNTAX);
+
+			// Value: written to the struct member
+			json_skip_ws(&s);
+			pos = s.cur;
+			if((ret = json_decode_value(&s, &fields[i], obj)) < 0)
+			{
+				res->field = i;
+				return json_decode_error(res, &s, (ret == JSON_DECODE_ERROR_SYNTAX) ? s.cur : pos, ret);
+			}
+			res->present |= (uint16_t)(1 << i);
+
+			json_skip_ws(&s);
+			if(json_expect(&s, ',')) continue;
+			if(json_expect(&s, '}')) break;
+
+			return json_decode_error(res, &s, s.cur, JSON_DECODE_ERROR_SYNTAX);
+		}
+	}
+
+	json_skip_ws(&s);
+	if(s.cur != s.end) return json_decode_error(res, &s, s.cur, JSON_DECODE_ERROR_SYNTAX);
+
+	return 0;
+}
+
+int8_t cbor_decode(const uint8_t * data, uint16_t len, const struct st_json_field * fields, void * obj, st_json_decode_result * res)
+{
+	st_json_scan s;
+	const char * pos;
+	uint32_t count, n, key_len;
+	uint8_t major, indef, key_indef;
+	uint8_t i;
+	int8_t ret;
+
+	s.start = (const char *)data;
+	s.cur = (const char *)data;
+	s.end = (const char *)data + len;
+
+	res->error = 0;
+	res->field = JSON_DECODE_NO_FIELD;
+	res->pos = 0;
+	res->present = 0;
+
+	if((cbor_scan_head(&s, &major, &count, &indef) < 0) || (major != CBOR_MAP)) return json_decode_error(res, &s, s.start, JSON_DECODE_ERROR_SYNTAX);
+
+	for(n = 0; indef || (n < count); n++)
+	{
+		// Key: text string of the schema
+		pos = s.cur;
+		if(indef && (s.cur < s.end) && ((uint8_t)*s.cur == CBOR_BREAK))
+		{
+			s.cur++;
+			break;
+		}
+		if((ret = cbor_scan_head(&s, &major, &key_len, &key_indef)) < 0) return json_decode_error(res, &s, pos, ret);
+		if((major != CBOR_TEXT) || key_indef) return json_decode_error(res, &s, pos, JSON_DECODE_ERROR_KEY);
+		if(key_len > (uint32_t)(s.end - s.cur)) return json_decode_error(res, &s, s.cur, JSON_DECODE_ERROR_SYNTAX);
+
+		for(i = 0; fields[i].key != NULL; i++)
+		{
+			if((strlen(fields[i].key) == key_len) && !strncmp(fields[i].key, s.cur, key_len)) break;
+		}
+		if(fields[i].key == NULL) return json_decode_error(res, &s, pos, JSON_DECODE_ERROR_KEY);
+		s.cur += key_len;
+
+		// Value: written to the struct member
+		pos = s.cur;
+		if((ret = cbor_decode_value(&s, &fields[i], obj)) < 0)
+		{
+			res->field = i;
+			return json_decode_error(res, &s, (ret == JSON_DECODE_ERROR_SYNTAX) ? s.cur : pos, ret);
+		}
+		res->present |= (uint16_t)(1 << i);
+	}
+
+	if(s.cur != s.end) return json_decode_error(res, &s, s.cur, JSON_DECODE_ERROR_SYNTAX);
+
+	return 0;
+}
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+static int8_t json_decode_value(st_json_scan * s, const struct st_json_field * f, void * obj)
+{
+	uint8_t * member = (uint8_t *)obj + f->offset;
+	char name[JSON_DECODE_NAME_SIZE];
+	uint16_t len;
+	int32_t val;
+	int8_t ret;
+	uint8_t i;
+
+	if(s->cur >= s->end) return JSON_DECODE_ERROR_SYNTAX;
+
+	switch(f->type)
+	{
+		case JSON_FIELD_INT:
+		case JSON_FIELD_UINT8:
+			if((*s->cur != '-') && ((*s->cur < '0') || (*s->cur > '9'))) return JSON_DECODE_ERROR_TYPE;
+			if((ret = json_scan_int(s, &val)) < 0) return ret;
+			if((val < f->min) || (val > f->max)) return JSON_DECODE_ERROR_RANGE;
+
+			if(f->type == JSON_FIELD_INT) *(int32_t *)member = val;
+			else *member = (uint8_t)val;
+			return 0;
+
+		case JSON_FIELD_BOOL:
+			if(json_scan_literal(s, "true")) *member = 1;
+			else if(json_scan_literal(s, "false")) *member = 0;
+			else return JSON_DECODE_ERROR_TYPE;
+			return 0;
+
+		case JSON_FIELD_STR:
+			if(*s->cur != '"') return JSON_DECODE_ERROR_TYPE;
+			if((ret = json_scan_str(s, (char *)member, (uint16_t)(f->max + 1), &len)) < 0) return ret;
+			if((len < f->min) || (len > f->max)) return JSON_DECODE_ERROR_RANGE;
+			return 0;
+
+		case JSON_FIELD_ENUM:
+			if(*s->cur != '"') return JSON_DECODE_ERROR_TYPE;
+			if((ret = json_scan_str(s, name, sizeof(name), &len)) < 0) return ret;
+
+			for(i = 0; (len < sizeof(name)) && (f->names[i] != NULL); i++)
+			{
+				if(!strcmp(f->names[i], name))
+				{
+					*member = i;
+					return 0;
+				}
+			}
+			return JSON_DECODE_ERROR_RANGE;
+
+		default:
+			return JSON_DECODE_ERROR_TYPE;
+	}
+}
+
+static int8_t json_decode_error(st_json_decode_result * res, const st_json_scan * s, const char * pos, int8_t error)
+{
+	res->error = error;
+	res->pos = (uint16_t)(pos - s->start);
+
+	return error;
+}
+
+static void json_skip_ws(st_json_scan * s)
+{
+	while((s->cur < s->end) && ((*s->cur == ' ') || (*s->cur == '\t') || (*s->cur == '\r') || (*s->cur == '\n'))) s->cur++;
+}
+
+// Skips the character if it is the next one
+static uint8_t json_expect(st_json_scan * s, char ch)
+{
+	if((s->cur >= s->end) || (*s->cur != ch)) return 0;
+
+	s->cur++;
+	return 1;
+}
+
+static uint8_t json_scan_literal(st_json_scan * s, const char * lit)
+{
+	uint16_t len = strlen(lit);
+
+	if(((uint16_t)(s->end - s->cur) < len) || strncmp(s->cur, lit, len)) return 0;
+
+	s->cur += len;
+	return 1;
+}
+
+// Integer number; fraction and exponent parts are not accepted (JSON_DECODE_ERROR_TYPE)
+static int8_t json_scan_int(st_json_scan * s, int32_t * val)
+{
+	const char * digits;
+	uint32_t n = 0;
+	uint8_t neg = 0;
+	uint8_t overflow = 0;
+	uint8_t d;
+
+	if(*s->cur == '-')
+	{
+		neg = 1;
+		s->cur++;
+	}
+
+	for(digits = s->cur; (s->cur < s->end) && (*s->cur >= '0') && (*s->cur <= '9'); s->cur++)
+	{
+		// No division: the M0 core has no divide instruction
+		d = *s->cur - '0';
+		if((n > 214748364UL) || ((n == 214748364UL) && (d > 8))) overflow = 1;
+		else n = (n * 10) + d;
+	}
+
+	if(s->cur == digits) return JSON_DECODE_ERROR_SYNTAX;
+	if((s->cur < s->end) && ((*s->cur == '.') || (*s->cur == 'e') || (*s->cur == 'E'))) return JSON_DECODE_ERROR_TYPE;
+	if(overflow || (!neg && (n > 0x7FFFFFFFUL))) return JSON_DECODE_ERROR_RANGE;
+
+	*val = neg ? (int32_t)(0 - n) : (int32_t)n;
+	return 0;
+}
+
+// Unescaped string into 'dst' (NULL-terminated, up to size - 1 characters); 'len' is the full length of the string.
+// \uXXXX escapes are written in UTF-8.
+static int8_t json_scan_str(st_json_scan * s, char * dst, uint16_t size, uint16_t * len)
+{
+	char ch[3];
+	uint16_t code;
+	uint8_t i, n;
+
+	*len = 0;
+	s->cur++; // '"'
+
+	while(s->cur < s->end)
+	{
+		ch[0] = *s->cur++;
+		n = 1;
+
+		if(ch[0] == '"')
+		{
+			dst[(*len < size) ? *len : (size - 1)] = '\0';
+			return 0;
+		}
+		if((uint8_t)ch[0] < 0x20)
+		{
+			s->cur--;
+			return JSON_DECODE_ERROR_SYNTAX;
+		}
+
+		if(ch[0] == '\\')
+		{
+			if(s->cur >= s->end) break;
+
+			switch(*s->cur++)
+			{
+				case '"':  ch[0] = '"';  break;
+				case '\\': ch[0] = '\\'; break;
+				case '/':  ch[0] = '/';  break;
+				case 'b':  ch[0] = '\b'; break;
+				case 'f':  ch[0] = '\f'; break;
+				case 'n':  ch[0] = '\n'; break;
+				case 'r':  ch[0] = '\r'; break;
+				case 't':  ch[0] = '\t'; break;
+				case 'u':
+					if(json_scan_hex4(s, &code) < 0) return JSON_DECODE_ERROR_SYNTAX;
+					if(code < 0x80)
+					{
+						ch[0] = (char)code;
+					}
+					else if(code < 0x800)
+					{
+						ch[0] = (char)(0xC0 | (code >> 6));
+						ch[1] = (char)(0x80 | (code & 0x3F));
+						n = 2;
+					}
+					else
+					{
+						ch[0] = (char)(0xE0 | (code >> 12));
+						ch[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+						ch[2] = (char)(0x80 | (code & 0x3F));
+						n = 3;
+					}
+					break;
+				default:
+					s->cur--;
+					return JSON_DECODE_ERROR_SYNTAX;
+			}
+		}
+
+		for(i = 0; i < n; i++, (*len)++)
+		{
+			if(*len < (size - 1)) dst[*len] = ch[i];
+		}
+	}
+
+	return JSON_DECODE_ERROR_SYNTAX; // Unterminated string
+}
+
+static int8_t json_scan_hex4(st_json_scan * s, uint16_t * code)
+{
+	uint8_t i;
+	char ch;
+
+	if((s->end - s->cur) < 4) return JSON_DECODE_ERROR_SYNTAX;
+
+	for(*code = 0, i = 0; i < 4; i++)
+	{
+		ch = *s->cur++;
+		*code <<= 4;
+		if((ch >= '0') && (ch <= '9')) *code |= ch - '0';
+		else if((ch >= 'a') && (ch <= 'f')) *code |= ch - 'a' + 10;
+		else if((ch >= 'A') && (ch <= 'F')) *code |= ch - 'A' + 10;
+		else return JSON_DECODE_ERROR_SYNTAX;
+	}
+
+	return 0;
+}
+
+static int8_t cbor_decode_value(st_json_scan * s, const struct st_json_field * f, void * obj)
+{
+	uint8_t * member = (uint8_t *)obj + f->offset;
+	uint32_t val;
+	int32_t num;
+	uint8_t major, indef;
+	uint8_t i;
+	int8_t ret;
+
+	if((ret = cbor_scan_head(s, &major, &val, &indef)) < 0) return ret;
+
+	switch(f->type)
+	{
+		case JSON_FIELD_INT:
+		case JSON_FIELD_UINT8:
+			if(((major != CBOR_UINT) && (major != CBOR_NINT)) || indef) return JSON_DECODE_ERROR_TYPE;
+			if(val > 0x7FFFFFFFUL) return JSON_DECODE_ERROR_RANGE;
+
+			num = (major == CBOR_UINT) ? (int32_t)val : (-1 - (int32_t)val);
+			if((num < f->min) || (num > f->max)) return JSON_DECODE_ERROR_RANGE;
+
+			if(f->type == JSON_FIELD_INT) *(int32_t *)member = num;
+			else *member = (uint8_t)num;
+			return 0;
+
+		case JSON_FIELD_BOOL:
+			if((major != CBOR_SIMPLE) || ((val != CBOR_FALSE) && (val != CBOR_TRUE))) return JSON_DECODE_ERROR_TYPE;
+			*member = (val == CBOR_TRUE);
+			return 0;
+
+		case JSON_FIELD_STR:
+		case JSON_FIELD_ENUM:
+			if((major != CBOR_TEXT) || indef) return JSON_DECODE_ERROR_TYPE;
+			if(val > (uint32_t)(s->end - s->cur)) return JSON_DECODE_ERROR_SYNTAX;
+
+			if(f->type == JSON_FIELD_STR)
+			{
+				if((val < (uint32_t)f->min) || (val > (uint32_t)f->max)) return JSON_DECODE_ERROR_RANGE;
+				memcpy(member, s->cur, val);
+				member[val] = '\0';
+				s->cur += val;
+				return 0;
+			}
+
+			for(i = 0; f->names[i] != NULL; i++)
+			{
+				if((strlen(f->names[i]) == val) && !strncmp(f->names[i], s->cur, val))
+				{
+					*member = i;
+					s->cur += val;
+					return 0;
+				}
+			}
+			return JSON_DECODE_ERROR_RANGE;
+
+		default:
+			return JSON_DECODE_ERROR_TYPE;
+	}
+}
+
+// Data item head: major type and the argument (big-endian, up to 32-bit values); indef: indefinite length
+static int8_t cbor_scan_head(st_json_scan * s, uint8_t * major, uint32_t * val, uint8_t * indef)
+{
+	uint8_t info, n;
+
+	if(s->cur >= s->end) return JSON_DECODE_ERROR_SYNTAX;
+
+	*major = (uint8_t)*s->cur >> 5;
+	info = (uint8_t)*s->cur & 0x1F;
+	s->cur++;
+
+	*val = 0;
+	*indef = 0;
+
+	if(info < 24)
+	{
+		*val = info;
+		return 0;
+	}
+	if(info == 31)
+	{
+		*indef = 1;
+		return 0;
+	}
+	if(info > 27) return JSON_DECODE_ERROR_SYNTAX;
+
+	n = 1 << (info - 24);
+	if((s->end - s->cur) < n) return JSON_DECODE_ERROR_SYNTAX;
+
+	for( ; n; n--, s->cur++)
+	{
+		if(*val > 0xFFFFFFUL) return JSON_DECODE_ERROR_RANGE; // 64-bit argument over 32 bits
+		*val = (*val << 8) | (uint8_t)*s->cur;
+	}
+
+	return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file	jsonDecoder.h
+ * @brief	Header File for HTTP Server - Schema-driven JSON / CBOR decoder
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#ifndef	__JSONDECODER_H__
+#define	__JSONDECODER_H__
+
+#include <stdint.h>
+#include <stddef.h> // offsetof()
+
+#define JSON_DECODE_ERROR_SYNTAX        (-1)    // Not a JSON object, or malformed
+#define JSON_DECODE_ERROR_KEY           (-2)    // Member not in the schema
+#define JSON_DECODE_ERROR_TYPE          (-3)    // Value type does not match the field type
+#define JSON_DECODE_ERROR_RANGE         (-4)    // Value out of the field bounds
+
+#define JSON_DECODE_MAX_FIELDS          16      // Fields per schema ('present' bitmask)
+#define JSON_DECODE_KEY_SIZE            16      // Longest key + 1
+#define JSON_DECODE_NAME_SIZE           16      // Longest ENUM name + 1
+#define JSON_DECODE_NO_FIELD            0xFF
+
+// Field types and the C types of the struct members
+#define JSON_FIELD_INT                  1       // int32_t, bounds: min / max
+#define JSON_FIELD_UINT8                2       // uint8_t, bounds: min / max
+#define JSON_FIELD_BOOL                 3       // uint8_t, true: 1 / false: 0
+#define JSON_FIELD_STR                  4       // char[max + 1], bounds: string length; NULL-terminated
+#define JSON_FIELD_ENUM                 5       // uint8_t, index of the string value in 'names'
+
+//{ key, type, offset, min, max, names }
+struct st_json_field
+{
+	const char* key;
+	uint8_t     type;       // JSON_FIELD_xxx
+	uint16_t    offset;     // offsetof() the member in the struct
+	int32_t     min;
+	int32_t     max;
+	const char* const* names; // JSON_FIELD_ENUM: NULL-terminated value names, NULL for the other types
+};
+
+typedef struct _st_json_decode_result
+{
+	int8_t   error;         // JSON_DECODE_ERROR_xxx, 0: no error
+	uint8_t  field;         // Schema index of the field with the error, JSON_DECODE_NO_FIELD: none
+	uint16_t pos;           // Byte offset of the error in the input
+	uint16_t present;       // Bitmask of the decoded fields (schema index)
+} st_json_decode_result;
+
+// Decodes a flat JSON object into the struct in one pass; the schema is NULL-terminated.
+// Members not in the body keep their values. Returns 0 or JSON_DECODE_ERROR_xxx (also in res->error).
+int8_t json_decode(const char * json, uint16_t len, const struct st_json_field * fields, void * obj, st_json_decode_result * res);
+
+// Same for a CBOR (RFC 7049) map with text string keys: the map may have an indefinite length, text strings may not.
+// Values: integers (major type 0 / 1) for INT / UINT8, true / false for BOOL, text strings for STR / ENUM.
+int8_t cbor_decode(const uint8_t * data, uint16_t len, const struct st_json_field * fields, void * obj, st_json_decode_result * res);
+
+#endif
@@ -0,0 +1,392 @@
+/**
+ * @file	jsonWriter.c
+ * @brief	HTTP Server - Bounded streaming JSON writer
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#include <string.h>
+
+#include "jsonWriter.h"
+#include "frozen.h" // json_emit_long(), json_emit_fixed()
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+static void json_write(st_json_writer * w, const char * str, uint16_t len);
+static void json_putc(st_json_writer * w, char ch);
+static uint8_t json_escape(char ch, char * esc);
+static void json_value(st_json_writer * w);
+static void json_begin(st_json_writer * w, char ch, uint8_t array);
+static void cbor_head(st_json_writer * w, uint8_t major, uint32_t val);
+static void cbor_int(st_json_writer * w, int32_t val);
+
+// CBOR major types and simple values
+#define CBOR_UINT               0
+#define CBOR_NINT               1
+#define CBOR_TEXT               3
+#define CBOR_ARRAY              4
+#define CBOR_TAG                6
+#define CBOR_MAP_INDEF          0xBF
+#define CBOR_ARRAY_INDEF        0x9F
+#define CBOR_BREAK              0xFF
+#define CBOR_FALSE              0xF4
+#define CBOR_TRUE               0xF5
+#define CBOR_NULL               0xF6
+#define CBOR_TAG_DECIMAL        4       // Decimal fraction: [exponent, mantissa]
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+void json_writer_init(st_json_writer * w, char * buf, uint16_t size, json_flush_func flush, void * ctx)
+{
+	w->buf = buf;
+	w->size = size;
+	w->len = 0;
+	w->flushed = 0;
+	w->depth = 0;
+	w->member = 0;
+	w->array = 0;
+	w->after_key = 0;
+	w->error = 0;
+	w->format = JSON_WRITER_FORMAT_JSON;
+	w->flush = flush;
+	w->ctx = ctx;
+}
+
+void json_writer_set_format(st_json_writer * w, uint8_t format)
+{
+	w->format = format;
+}
+
+int16_t json_writer_finish(st_json_writer * w)
+{
+	if((w->error == 0) && (w->depth != 0)) w->error = JSON_WRITER_ERROR_NESTING;
+	if(w->error) return w->error;
+
+	// Best-effort to 0-terminate (JSON text), not included in the length
+	if(w->len < w->size) w->buf[w->len] = '\0';
+
+	return w->len;
+}
+
+void json_begin_object(st_json_writer * w)
+{
+	json_begin(w, '{', 0);
+}
+
+void json_begin_array(st_json_writer * w)
+{
+	json_begin(w, '[', 1);
+}
+
+void json_end(st_json_writer * w)
+{
+	if(w->depth == 0)
+	{
+		w->error = JSON_WRITER_ERROR_NESTING;
+		return;
+	}
+
+	w->depth--;
+	if(w->format == JSON_WRITER_FORMAT_CBOR) json_putc(w, (char)CBOR_BREAK);
+	else json_putc(w, (w->array & (1 << w->depth)) ? ']' : '}');
+}
+
+void json_key(st_json_writer * w, const char * key)
+{
+	json_str(w, key);
+	if(w->format == JSON_WRITER_FORMAT_CBOR) return;
+
+	json_putc(w, ':');
+	w->after_key = 1;
+}
+
+void json_int(st_json_writer * w, int32_t val)
+{
+	char tmp[12];
+	int n;
+
+	if(w->format == JSON_WRITER_FORMAT_CBOR)
+	{
+		cbor_int(w, val);
+		return;
+	}
+
+	json_value(w);
+
+	// Digits are formatted straight into the buffer when the number fits
+	if((w->error == 0) && ((n = json_emit_long(w->buf + w->len, w->size - w->len, val)) < (w->size - w->len)))
+	{
+		w->len += n;
+		return;
+	}
+	json_write(w, tmp, json_emit_long(tmp, sizeof(tmp), val));
+}
+
+void json_fixed(st_json_writer * w, int32_t val, uint8_t decimals)
+{
+	char tmp[16];
+
+	if(w->format == JSON_WRITER_FORMAT_CBOR)
+	{
+		// Exact value without floating point: tag 4 [-decimals, val]
+		if(decimals)
+		{
+			cbor_head(w, CBOR_TAG, CBOR_TAG_DECIMAL);
+			cbor_head(w, CBOR_ARRAY, 2);
+			cbor_int(w, -(int32_t)decimals);
+		}
+		cbor_int(w, val);
+		return;
+	}
+
+	json_value(w);
+	json_write(w, tmp, json_emit_fixed(tmp, sizeof(tmp), val, decimals));
+}
+
+void json_str(st_json_writer * w, const char * str)
+{
+	json_strn(w, str, strlen(str));
+}
+
+void json_strn(st_json_writer * w, const char * str, uint16_t len)
+{
+	const char * run = str;
+	const char * end = str + len;
+	char * s;
+	char esc[6];
+
+	// CBOR: text string, no escapes
+	if(w->format == JSON_WRITER_FORMAT_CBOR)
+	{
+		cbor_head(w, CBOR_TEXT, len);
+		json_write(w, str, len);
+		return;
+	}
+
+	json_value(w);
+
+	// Fast path: fits in the buffer even if all the characters are escaped as \u00XX
+	if((w->error == 0) && (((uint32_t)len * 6 + 2) <= (uint32_t)(w->size - w->len)))
+	{
+		s = w->buf + w->len;
+		*s++ = '"';
+		while(str < end)
+		{
+			if(((uint8_t)*str >= 0x20) && (*str != '"') && (*str != '\\')) *s++ = *str++;
+			else s += json_escape(*str++, s);
+		}
+		*s++ = '"';
+		w->len = s - w->buf;
+		return;
+	}
+
+	// Characters are written in runs; only the escaped characters are split
+	json_putc(w, '"');
+	for( ; str < end; str++)
+	{
+		if(((uint8_t)*str >= 0x20) && (*str != '"') && (*str != '\\')) continue;
+
+		json_write(w, run, str - run);
+		json_write(w, esc, json_escape(*str, esc));
+		run = str + 1;
+	}
+	json_write(w, run, str - run);
+	json_putc(w, '"');
+}
+
+void json_bool(st_json_writer * w, uint8_t val)
+{
+	if(w->format == JSON_WRITER_FORMAT_CBOR)
+	{
+		json_putc(w, (char)(val ? CBOR_TRUE : CBOR_FALSE));
+		return;
+	}
+
+	json_value(w);
+	if(val) json_write(w, "true", 4);
+	else json_write(w, "false", 5);
+}
+
+void json_null(st_json_writer * w)
+{
+	if(w->format == JSON_WRITER_FORMAT_CBOR)
+	{
+		json_putc(w, (char)CBOR_NULL);
+		return;
+	}
+
+	json_value(w);
+	json_write(w, "null", 4);
+}
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+// Copies to the buffer; when the buffer is full, flushes it (overflow policy) or stops with JSON_WRITER_ERROR_OVERFLOW
+static void json_write(st_json_writer * w, const char * str, uint16_t len)
+{
+	uint16_t n;
+
+	// Fast path: fits in the buffer
+	if((len <= (w->size - w->len)) && (w->error == 0))
+	{
+		memcpy(w->buf + w->len, str, len);
+		w->len += len;
+		return;
+	}
+
+	while(len && (w->error == 0))
+	{
+		if(w->len == w->size)
+		{
+			if((w->flush == NULL) || (w->flush(w->ctx, w->buf, w->len) < 0))
+			{
+				w->error = JSON_WRITER_ERROR_OVERFLOW;
+				return;
+			}
+			w->flushed += w->len;
+			w->len = 0;
+		}
+
+		n = w->size - w->len;
+		if(n > len) n = len;
+
+		memcpy(w->buf + w->len, str, n);
+		w->len += n;
+		str += n;
+		len -= n;
+	}
+}
+
+static void json_putc(st_json_writer * w, char ch)
+{
+	if(w->len < w->size) w->buf[w->len++] = ch;
+	else json_write(w, &ch, 1);
+}
+
+// Escape sequence of '"', '\\' or a control character (RFC 8259): written to 'esc' (up to 6 characters), returns its length
+static uint8_t json_escape(char ch, char * esc)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	esc[0] = '\\';
+	switch(ch)
+	{
+		case '"':  esc[1] = '"';  return 2;
+		case '\\': esc[1] = '\\'; return 2;
+		case '\b': esc[1] = 'b';  return 2;
+		case '\f': esc[1] = 'f';  return 2;
+		case '\n': esc[1] = 'n';  return 2;
+		case '\r': esc[1] = 'r';  return 2;
+		case '\t': esc[1] = 't';  return 2;
+		default:   break;
+	}
+
+	// Other control characters: \u00XX
+	esc[1] = 'u';
+	esc[2] = '0';
+	esc[3] = '0';
+	esc[4] = hex[((uint8_t)ch >> 4) & 0x0F];
+	esc[5] = hex[(uint8_t)ch & 0x0F];
+
+	return 6;
+}
+
+// Separator before a value: a comma if the current object / array already has a member
+static void json_value(st_json_writer * w)
+{
+	uint8_t bit;
+
+	if(w->after_key)
+	{
+		w->after_key = 0;
+		return;
+	}
+	if(w->depth == 0) return;
+
+	bit = 1 << (w->depth - 1);
+	if(w->member & bit) json_putc(w, ',');
+	w->member |= bit;
+}
+
+static void json_begin(st_json_writer * w, char ch, uint8_t array)
+{
+	uint8_t bit;
+
+	if(w->depth >= JSON_WRITER_MAX_DEPTH)
+	{
+		w->error = JSON_WRITER_ERROR_NESTING;
+		return;
+	}
+
+	if(w->format == JSON_WRITER_FORMAT_CBOR)
+	{
+		json_putc(w, (char)(array ? CBOR_ARRAY_INDEF : CBOR_MAP_INDEF));
+	}
+	else
+	{
+		json_value(w);
+		json_putc(w, ch);
+	}
+
+	bit = 1 << w->depth;
+	w->member &= ~bit;
+	if(array) w->array |= bit;
+	else w->array &= ~bit;
+	w->depth++;
+}
+
+// CBOR data item head: major type and the argument in the shortest form
+static void cbor_head(st_json_writer * w, uint8_t major, uint32_t val)
+{
+	char tmp[5];
+	char * head = tmp;
+	uint8_t len;
+
+	// Formatted straight into the buffer when the longest head fits
+	if((w->error == 0) && ((w->size - w->len) >= (int)sizeof(tmp))) head = w->buf + w->len;
+
+	major <<= 5;
+	if(val < 24)
+	{
+		head[0] = (char)(major | val);
+		len = 1;
+	}
+	else if(val <= 0xFF)
+	{
+		head[0] = (char)(major | 24);
+		head[1] = (char)val;
+		len = 2;
+	}
+	else if(val <= 0xFFFF)
+	{
+		head[0] = (char)(major | 25);
+		head[1] = (char)(val >> 8);
+		head[2] = (char)val;
+		len = 3;
+	}
+	else
+	{
+		head[0] = (char)(major | 26);
+		head[1] = (char)(val >> 24);
+		head[2] = (char)(val >> 16);
+		head[3] = (char)(val >> 8);
+		head[4] = (char)val;
+		len = 5;
+	}
+	if(head == tmp) json_write(w, tmp, len);
+	else w->len += len;
+}
+
+// Negative integers: major type 1 with the argument -1 - val
+static void cbor_int(st_json_writer * w, int32_t val)
+{
+	if(val >= 0) cbor_head(w, CBOR_UINT, (uint32_t)val);
+	else cbor_head(w, CBOR_NINT, (uint32_t)(-(val + 1)));
+}
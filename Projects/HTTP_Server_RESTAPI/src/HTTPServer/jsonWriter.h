@@ -0,0 +1,61 @@
+/**
+ * @file	jsonWriter.h
+ * @brief	Header File for HTTP Server - Bounded streaming JSON writer
+ * @version 1.0
+ * @date	2016/03
+ * @par Revision
+ *			2016/03 - 1.0 Release
+ * @author
+ * \n\n @par Copyright (C) 1998 - 2016 WIZnet. All rights reserved.
+ */
+
+#ifndef	__JSONWRITER_H__
+#define	__JSONWRITER_H__
+
+#include <stdint.h>
+
+#define JSON_WRITER_MAX_DEPTH           8       // Nesting depth of objects / arrays
+#define JSON_WRITER_ERROR_OVERFLOW      (-1)    // Buffer full and no flush function (or flush failed)
+#define JSON_WRITER_ERROR_NESTING       (-2)    // Nesting depth exceeded or unbalanced json_end()
+
+// Output format: the same calls write JSON text or CBOR (RFC 7049) data items
+#define JSON_WRITER_FORMAT_JSON         0
+#define JSON_WRITER_FORMAT_CBOR         1       // Objects / arrays: indefinite-length maps / arrays, json_fixed(): decimal fraction (tag 4)
+
+// Overflow policy: called when the buffer is full, the writer continues from the start of the buffer after the flush.
+// Returns the flushed length, or a negative value on error.
+typedef int16_t (*json_flush_func)(void * ctx, const char * buf, uint16_t len);
+
+typedef struct _st_json_writer
+{
+	char*    buf;
+	uint16_t size;      // Buffer size
+	uint16_t len;       // Bytes in the buffer (not flushed yet)
+	uint32_t flushed;   // Bytes flushed out of the buffer
+	uint8_t  depth;
+	uint8_t  member;    // Bitmask per depth: the object / array has a member (comma needed)
+	uint8_t  array;     // Bitmask per depth: array (1) or object (0)
+	uint8_t  after_key; // The next value is a member value; no comma
+	int8_t   error;     // JSON_WRITER_ERROR_xxx, 0: no error
+	uint8_t  format;    // JSON_WRITER_FORMAT_xxx
+	json_flush_func flush;
+	void*    ctx;
+} st_json_writer;
+
+void json_writer_init(st_json_writer * w, char * buf, uint16_t size, json_flush_func flush, void * ctx);
+int16_t json_writer_finish(st_json_writer * w);	/* returns the length in the buffer, or JSON_WRITER_ERROR_xxx */
+void json_writer_set_format(st_json_writer * w, uint8_t format);	/* before the first value; JSON by default */
+
+void json_begin_object(st_json_writer * w);
+void json_begin_array(st_json_writer * w);
+void json_end(st_json_writer * w);				/* closes the current object or array */
+void json_key(st_json_writer * w, const char * key);
+
+void json_int(st_json_writer * w, int32_t val);
+void json_fixed(st_json_writer * w, int32_t val, uint8_t decimals);	/* val scaled by 10^decimals, e.g., (3305, 3): 3.305 */
+void json_str(st_json_writer * w, const char * str);
+void json_strn(st_json_writer * w, const char * str, uint16_t len);
+void json_bool(st_json_writer * w, uint8_t val);
+void json_null(st_json_writer * w);
+
+#endif
@@ -0,0 +1,113 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "W7500x.h"
+
+#include "httpServer_rest.h"
+#include "timerHandler.h"
+#include "schedHandler.h"
+#include "memHandler.h"
+#include "crashHandler.h"
+
+/* Private define ------------------------------------------------------------*/
+#define CRASH_RECORD_CAPTURED	0x43525348	// "CRSH": written by the HardFault handler, the reset follows
+#define CRASH_RECORD_REPORTED	0x43525352	// "CRSR": taken at the boot
+
+// The exception frame (8 words) is read only if it lies in the SRAM: a fault on a corrupted stack pointer
+#define CRASH_SRAM_BASE			0x20000000
+#define CRASH_SRAM_END			0x20004000
+#define CRASH_FRAME_SIZE		32
+
+/* Private functions prototypes ----------------------------------------------*/
+static uint32_t crash_record_sum(const st_crash_record * rec);
+
+/* Private variables ---------------------------------------------------------*/
+// No-init RAM: not zeroed by the C library at the boot (UNINIT region of the scatter file)
+static st_crash_record crash_record __attribute__((section("NoInit"), zero_init));
+
+static uint8_t crash_last_valid = 0;
+
+void crash_init(void)
+{
+	if((crash_record.magic == CRASH_RECORD_CAPTURED) && (crash_record.check == crash_record_sum(&crash_record)))
+	{
+		// Kept in place for this boot: reported once
+		crash_last_valid = 1;
+		crash_record.magic = CRASH_RECORD_REPORTED;
+		crash_record.check = crash_record_sum(&crash_record);
+	}
+	else
+	{
+		memset(&crash_record, 0, sizeof(crash_record)); // Power on: random contents, or reported at a former boot
+	}
+}
+
+// Handler mode, any stack state: no lock, no printf, nothing which may fault again
+void crash_capture(uint32_t * frame, uint32_t exc_return)
+{
+	st_crash_record * rec = &crash_record;
+	const char * task;
+	uint8_t sock, state;
+	uint32_t addr = (uint32_t)frame;
+
+	__disable_irq();
+
+	memset(rec, 0, sizeof(*rec));
+	rec->exc_return = exc_return;
+	rec->sp = addr + CRASH_FRAME_SIZE;
+
+	if((addr >= CRASH_SRAM_BASE) && (addr <= (CRASH_SRAM_END - CRASH_FRAME_SIZE)) && !(addr & 3))
+	{
+		rec->r0 = frame[0];
+		rec->r1 = frame[1];
+		rec->r2 = frame[2];
+		rec->r3 = frame[3];
+		rec->r12 = frame[4];
+		rec->lr = frame[5];
+		rec->pc = frame[6];
+		rec->xpsr = frame[7];
+	}
+
+	rec->uptime = (uint32_t)(getDeviceTime_usec64() / 1000);
+	rec->stack_free = (uint16_t)get_stack_free(MEM_STACK_MAIN);
+	rec->isr_stack_free = (uint16_t)get_stack_free(MEM_STACK_ISR);
+
+	if(get_httpServer_active(&sock, &state))
+	{
+		rec->sock = sock;
+		rec->http_state = state;
+	}
+	else
+	{
+		rec->sock = CRASH_SOCK_NONE;
+	}
+
+	task = get_sched_running();
+	if(task != NULL) strncpy(rec->task, task, CRASH_NAME_SIZE - 1);
+
+	rec->trace_cnt = trace_last(rec->trace, CRASH_TRACE_EVENTS, &rec->trace_seq);
+
+	rec->magic = CRASH_RECORD_CAPTURED;
+	rec->check = crash_record_sum(rec);
+
+	NVIC_SystemReset();
+	while(1);
+}
+
+const st_crash_record* get_crash_last(void)
+{
+	return crash_last_valid ? &crash_record : NULL;
+}
+
+/* Private functions ---------------------------------------------------------*/
+// Sum of the words of the record but the check
+static uint32_t crash_record_sum(const st_crash_record * rec)
+{
+	const uint32_t * p = (const uint32_t *)rec;
+	uint32_t sum = 0;
+	uint16_t i;
+
+	for(i = 0; i < (offsetof(st_crash_record, check) / 4); i++) sum += p[i];
+
+	return ~sum;
+}
@@ -0,0 +1,48 @@
+#ifndef CRASHHANDLER_H_
+#define CRASHHANDLER_H_
+
+#include <stdint.h>
+
+#include "traceHandler.h"
+
+// Crash capture: the HardFault handler (W7500x_it.c) records the registers stacked by the exception, the task, the
+// HTTP socket served and the last trace records in the no-init RAM (section "NoInit", W7500x_App.sct), then resets.
+// The capture is reported at the next boot and by '/diag/crash'; host/crashsym symbolises it against the .axf
+#define CRASH_TRACE_EVENTS		8		// Last trace records kept
+#define CRASH_NAME_SIZE			12
+
+#define CRASH_SOCK_NONE			0xFF
+
+typedef struct _st_crash_record
+{
+	uint32_t magic;							// CRASH_RECORD_xxx
+	uint32_t r0, r1, r2, r3, r12;			// Exception frame
+	uint32_t lr;							// Link register of the faulting code
+	uint32_t pc;							// Faulting instruction
+	uint32_t xpsr;
+	uint32_t exc_return;					// LR of the handler: stack of the frame (bit 2: PSP) and mode
+	uint32_t sp;							// Stack pointer at the fault (above the frame)
+	uint32_t uptime;						// ms since the boot
+	uint16_t stack_free;					// Main loop stack never used (memHandler.h), bytes
+	uint8_t  sock;							// H/W socket served by the HTTP server, CRASH_SOCK_NONE: none
+	uint8_t  http_state;					// Its state (STATE_HTTP_xxx)
+	char     task[CRASH_NAME_SIZE];			// Main loop task running, empty: none
+	uint32_t trace_seq;						// Sequence number of the first trace record
+	uint8_t  trace_cnt;
+	uint8_t  reserved;
+	uint16_t isr_stack_free;				// Interrupt handler stack never used, bytes
+	st_trace_event trace[CRASH_TRACE_EVENTS];
+	uint32_t check;							// Integrity of the record: the RAM contents are random at the power on
+} st_crash_record;
+
+// At the boot: takes the capture of the last HardFault (get_crash_last())
+void crash_init(void);
+
+// HardFault handler: 'frame' is the exception frame (r0-r3, r12, lr, pc, xPSR) on the stack of the faulting code;
+// does not return (system reset)
+void crash_capture(uint32_t * frame, uint32_t exc_return);
+
+// Capture of the HardFault before this boot, NULL: none
+const st_crash_record* get_crash_last(void);
+
+#endif /* CRASHHANDLER_H_ */
@@ -6,9 +6,9 @@
 #include "W7500x_board.h"
 #include "gpioHandler.h"
 
-#ifdef _GPIO_DEBUG_
-	#include <stdio.h>
-#endif
+#define LOG_MODULE			LOG_MODULE_GPIO
+#define LOG_MODULE_LEVEL	LOG_LEVEL_GPIO
+#include "logHandler.h"
 
 const uint16_t USER_IO_PIN[USER_IOn] =     {USER_IO_A_PIN, USER_IO_B_PIN, USER_IO_C_PIN, USER_IO_D_PIN};
 GPIO_TypeDef*  USER_IO_PORT[USER_IOn] =    {USER_IO_A_PORT, USER_IO_B_PORT, USER_IO_C_PORT, USER_IO_D_PORT};
@@ -18,6 +18,11 @@ uint8_t        USER_IO_SEL[USER_IOn] =     {USER_IO_A, USER_IO_B, USER_IO_C, USE
 const char*    USER_IO_STR[USER_IOn] =     {"a\0", "b\0", "c\0", "d\0"};
 const char*    USER_IO_PIN_STR[USER_IOn] = {"p30\0", "p29\0", "p28\0", "p27\0",}; 
 
+static uint32_t adc_conversions = 0;
+static uint16_t adc_sample[USER_IOn];		// Last sample of the analog inputs (IO_sample_analog)
+static uint8_t  adc_sampled = 0;			// Inputs of which adc_sample is valid: USER_IO_x bits
+static uint8_t  adc_converting = 0;			// Input of the conversion in progress (user_io_val_ready): USER_IO_x bit, 0: none
+
 /**
   * @brief  xxx Function
   */
@@ -37,6 +42,8 @@ void init_user_io(uint8_t io_sel)
 	struct __user_io_info *user_io_info = (struct __user_io_info *)&(get_DevConfig_pointer()->user_io_info);
 	uint8_t idx = 0;
 	GPIOMode_TypeDef gpio_mode;
+	
+	adc_sampled &= ~io_sel; // Converted on the next read until sampled again
 
 	if((user_io_info->user_io_enable & io_sel) == io_sel)
 	{
@@ -212,9 +219,10 @@ uint8_t get_user_io_val(uint16_t io_sel, uint16_t * val)
 		
 		if((user_io_info->user_io_type & io_sel) == io_sel) // IO_ANALOG == 1
 		{
-			// Analog Input: value
-			*val = read_ADC(USER_IO_ADC_CH[idx]);
-			//printf("===============> Analog input: %d <============\r\n", *val);
+			// Analog Input: value, the last sample if sampled periodically
+			if(adc_sampled & io_sel) *val = adc_sample[idx];
+			else *val = read_ADC(USER_IO_ADC_CH[idx]);
+			LOG_DEBUG2("Analog input %s: %d", USER_IO_STR[idx], *val);
 		}
 		else // IO_DIGITAL == 0
 		{
@@ -223,13 +231,13 @@ uint8_t get_user_io_val(uint16_t io_sel, uint16_t * val)
 			{
 				// Digital Output: status
 				status = (uint16_t)GPIO_ReadOutputDataBit(USER_IO_PORT[idx], USER_IO_PIN[idx]);
-				//printf("===============> Digital Output: %d <==============\r\n", status);
+				LOG_DEBUG2("Digital output %s: %d", USER_IO_STR[idx], status);
 			}
 			else // IO_INPUT == 0
 			{
 				// Digital Input: status
 				status = (uint16_t)GPIO_ReadInputDataBit(USER_IO_PORT[idx], USER_IO_PIN[idx]);
-				//printf("===============> Digital input: %d <==============\r\n", status);
+				LOG_DEBUG2("Digital input %s: %d", USER_IO_STR[idx], status);
 			}
 			
 			//*val |= (status << i);
@@ -287,7 +295,67 @@ uint16_t read_ADC(ADC_CH ch)
 	ADC_ChannelSelect(ch);				///< Select ADC channel to CH0
 	ADC_Start();						///< Start ADC
 	while(ADC_IsEOC());					///< Wait until End of Conversion
+	adc_conversions++;
 	
 	return ((uint16_t)ADC_ReadData());	///< read ADC Data
 }
 
+// Read of an analog input without waiting for the conversion (resumable REST API handlers): returns 1 when
+// get_user_io_val() returns without waiting, otherwise starts the conversion and returns 0 until it ends
+uint8_t user_io_val_ready(uint16_t io_sel)
+{
+	struct __user_io_info *user_io_info = (struct __user_io_info *)&(get_DevConfig_pointer()->user_io_info);
+	uint8_t idx;
+	
+	if((user_io_info->user_io_enable & io_sel) != io_sel) return 1;
+	if((user_io_info->user_io_type & io_sel) != io_sel) return 1; // Digital
+	
+	// End of the conversion: the result is the sample of its input, also when its reader is gone (closed connection)
+	if(adc_converting && !ADC_IsEOC())
+	{
+		idx = get_user_io_bitorder(adc_converting);
+		adc_sample[idx] = (uint16_t)ADC_ReadData();
+		adc_sampled |= adc_converting;
+		adc_converting = 0;
+		adc_conversions++;
+	}
+	
+	if(adc_sampled & io_sel) return 1;
+	
+	// One conversion at a time: the other inputs wait for its end
+	if(adc_converting == 0)
+	{
+		ADC_ChannelSelect(USER_IO_ADC_CH[get_user_io_bitorder(io_sel)]);
+		ADC_Start();
+		adc_converting = (uint8_t)io_sel;
+	}
+	
+	return 0;
+}
+
+uint32_t get_ADC_conversions(void)
+{
+	return adc_conversions;
+}
+
+// Periodic sampling of the enabled analog inputs: the reads (REST API) return the last sample instead of waiting for
+// a conversion
+void IO_sample_analog(void)
+{
+	struct __user_io_info *user_io_info = (struct __user_io_info *)&(get_DevConfig_pointer()->user_io_info);
+	uint8_t i;
+	
+	if(adc_converting) return; // ADC in use by user_io_val_ready(): sampled in the next period
+	
+	for(i = 0; i < USER_IOn; i++)
+	{
+		if(((user_io_info->user_io_enable & USER_IO_SEL[i]) == 0) || ((user_io_info->user_io_type & USER_IO_SEL[i]) == 0))
+		{
+			adc_sampled &= ~USER_IO_SEL[i];
+			continue;
+		}
+		
+		adc_sample[i] = read_ADC(USER_IO_ADC_CH[i]);
+		adc_sampled |= USER_IO_SEL[i];
+	}
+}
@@ -4,7 +4,7 @@
 #include <stdint.h>
 #include "W7500x_adc.h"
 
-#define _GPIO_DEBUG_
+// Debug messages: LOG_LEVEL_GPIO (logHandler.h)
 
 typedef enum
 {
@@ -54,6 +54,11 @@ uint8_t set_user_io_val(uint16_t io_sel, uint16_t * val);
 uint8_t get_user_io_bitorder(uint16_t io_sel);
 
 uint16_t read_ADC(ADC_CH ch);
+uint32_t get_ADC_conversions(void); // Number of read_ADC() conversions
+uint8_t user_io_val_ready(uint16_t io_sel); // 0: analog conversion in progress, get_user_io_val() would wait for it
+
+#define IO_SAMPLE_PERIOD_MSEC	100 // Analog inputs sampling period
+void IO_sample_analog(void); // Sampling of the analog inputs: periodic task
 
 void gpio_handler_timer_msec(void); // This function have to call every 1 millisecond by Timer IRQ handler routine.
 
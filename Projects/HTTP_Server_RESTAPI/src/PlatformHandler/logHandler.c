@@ -0,0 +1,77 @@
+#include <stdio.h>
+
+#include "logHandler.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct _st_log_msg
+{
+	const char * fmt;
+	log_arg_t arg[3];
+	uint8_t id;			// LOG_ID(): level, module
+} st_log_msg;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Private functions prototypes ----------------------------------------------*/
+static void log_print(const st_log_msg * msg);
+
+/* Private variables ---------------------------------------------------------*/
+static st_log_msg log_ring[LOG_RING_SIZE];
+static uint16_t log_head = 0;		// Messages captured
+static uint16_t log_tail = 0;		// Messages printed
+static uint16_t log_dropped = 0;	// Ring full: messages lost since the last print
+
+static const char * const log_level_str[] = { "", "Error", "Warn", "Info", "Debug" };
+static const char * const log_module_str[] = { "main", "httpserver", "httpparser", "restapi", "gpio" }; // LOG_MODULE_xxx
+
+void log_capture(uint8_t id, const char * fmt, log_arg_t arg0, log_arg_t arg1, log_arg_t arg2)
+{
+	st_log_msg * msg;
+
+	if((uint16_t)(log_head - log_tail) >= LOG_RING_SIZE)
+	{
+		log_dropped++;
+		return;
+	}
+
+	msg = &log_ring[log_head & (LOG_RING_SIZE - 1)];
+	msg->fmt = fmt;
+	msg->arg[0] = arg0;
+	msg->arg[1] = arg1;
+	msg->arg[2] = arg2;
+	msg->id = id;
+	log_head++;
+}
+
+void log_loop(void)
+{
+	if(log_head != log_tail)
+	{
+		log_print(&log_ring[log_tail & (LOG_RING_SIZE - 1)]);
+		log_tail++;
+	}
+	else if(log_dropped)
+	{
+		printf("  [Warn] log: %d messages dropped\r\n", log_dropped);
+		log_dropped = 0;
+	}
+}
+
+void log_flush(void)
+{
+	while((log_head != log_tail) || log_dropped) log_loop();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void log_print(const st_log_msg * msg)
+{
+	uint8_t level = msg->id >> 4;
+	uint8_t module = msg->id & 0x0F;
+
+	printf("  [%s] %s: ", log_level_str[(level <= LOG_LEVEL_DEBUG) ? level : 0],
+	       (module < sizeof(log_module_str) / sizeof(log_module_str[0])) ? log_module_str[module] : "?");
+
+	printf(msg->fmt, msg->arg[0], msg->arg[1], msg->arg[2]); // The arguments not in the format are ignored
+
+	printf("\r\n");
+}
@@ -0,0 +1,140 @@
+#ifndef LOGHANDLER_H_
+#define LOGHANDLER_H_
+
+#include <stdint.h>
+
+// Leveled log messages, levels per module at compile time.
+// A module defines LOG_MODULE and LOG_MODULE_LEVEL before this header:
+//     #define LOG_MODULE			LOG_MODULE_RESTAPI
+//     #define LOG_MODULE_LEVEL	LOG_LEVEL_RESTAPI
+//     #include "logHandler.h"
+// The messages over the level of the module are removed by the preprocessor (no code, no format string).
+// The others only store the format string and the arguments in a RAM ring (log_capture()): printf() of the message
+// is deferred to log_loop() in the main loop.
+//  - The arguments are captured by value: a '%s' argument must still be valid when the message is printed (constant strings)
+//  - Main loop only, not from the interrupt handlers (no lock)
+//  - C90: one macro per number of arguments, LOG_xxx() to LOG_xxx3()
+
+#define LOG_LEVEL_NONE			0
+#define LOG_LEVEL_ERROR			1
+#define LOG_LEVEL_WARN			2
+#define LOG_LEVEL_INFO			3
+#define LOG_LEVEL_DEBUG			4
+
+/*********************************************
+* Log levels of the modules (or -DLOG_LEVEL_xxx=n)
+*********************************************/
+#ifndef LOG_LEVEL_MAIN
+	#define LOG_LEVEL_MAIN			LOG_LEVEL_WARN
+#endif
+#ifndef LOG_LEVEL_HTTPSERVER
+	#define LOG_LEVEL_HTTPSERVER	LOG_LEVEL_WARN
+#endif
+#ifndef LOG_LEVEL_HTTPPARSER
+	#define LOG_LEVEL_HTTPPARSER	LOG_LEVEL_WARN
+#endif
+#ifndef LOG_LEVEL_RESTAPI
+	#define LOG_LEVEL_RESTAPI		LOG_LEVEL_WARN
+#endif
+#ifndef LOG_LEVEL_GPIO
+	#define LOG_LEVEL_GPIO			LOG_LEVEL_WARN
+#endif
+
+// Modules: index of the names in logHandler.c
+#define LOG_MODULE_MAIN			0
+#define LOG_MODULE_HTTPSERVER	1
+#define LOG_MODULE_HTTPPARSER	2
+#define LOG_MODULE_RESTAPI		3
+#define LOG_MODULE_GPIO			4
+
+#define LOG_RING_SIZE			16		// Messages waiting for log_loop(), power of 2 (20 bytes each)
+
+// Argument of a message: 32-bit on the target, a pointer on the host build
+typedef uintptr_t log_arg_t;
+
+// Message of the module: level in the upper 4 bits
+#define LOG_ID(level)			(uint8_t)(((level) << 4) | LOG_MODULE)
+
+void log_capture(uint8_t id, const char * fmt, log_arg_t arg0, log_arg_t arg1, log_arg_t arg2);
+
+// Main loop: prints the messages waiting ('  [Level] module: message')
+void log_loop(void);
+
+// Prints all the messages waiting: before the main loop (the ring holds a few messages only)
+void log_flush(void);
+
+#endif /* LOGHANDLER_H_ */
+
+/*********************************************
+* Log macros of the module: outside of the include guard, for the LOG_MODULE_LEVEL of each module
+*********************************************/
+#if defined(LOG_MODULE) && defined(LOG_MODULE_LEVEL)
+
+#undef LOG_ERROR
+#undef LOG_ERROR1
+#undef LOG_ERROR2
+#undef LOG_ERROR3
+#undef LOG_WARN
+#undef LOG_WARN1
+#undef LOG_WARN2
+#undef LOG_WARN3
+#undef LOG_INFO
+#undef LOG_INFO1
+#undef LOG_INFO2
+#undef LOG_INFO3
+#undef LOG_DEBUG
+#undef LOG_DEBUG1
+#undef LOG_DEBUG2
+#undef LOG_DEBUG3
+
+#define LOG_CAPTURE(level, fmt, a0, a1, a2)		log_capture(LOG_ID(level), (fmt), (log_arg_t)(a0), (log_arg_t)(a1), (log_arg_t)(a2))
+
+#if (LOG_MODULE_LEVEL >= LOG_LEVEL_ERROR)
+	#define LOG_ERROR(fmt)					LOG_CAPTURE(LOG_LEVEL_ERROR, fmt, 0, 0, 0)
+	#define LOG_ERROR1(fmt, a0)				LOG_CAPTURE(LOG_LEVEL_ERROR, fmt, a0, 0, 0)
+	#define LOG_ERROR2(fmt, a0, a1)			LOG_CAPTURE(LOG_LEVEL_ERROR, fmt, a0, a1, 0)
+	#define LOG_ERROR3(fmt, a0, a1, a2)		LOG_CAPTURE(LOG_LEVEL_ERROR, fmt, a0, a1, a2)
+#else
+	#define LOG_ERROR(fmt)
+	#define LOG_ERROR1(fmt, a0)
+	#define LOG_ERROR2(fmt, a0, a1)
+	#define LOG_ERROR3(fmt, a0, a1, a2)
+#endif
+
+#if (LOG_MODULE_LEVEL >= LOG_LEVEL_WARN)
+	#define LOG_WARN(fmt)					LOG_CAPTURE(LOG_LEVEL_WARN, fmt, 0, 0, 0)
+	#define LOG_WARN1(fmt, a0)				LOG_CAPTURE(LOG_LEVEL_WARN, fmt, a0, 0, 0)
+	#define LOG_WARN2(fmt, a0, a1)			LOG_CAPTURE(LOG_LEVEL_WARN, fmt, a0, a1, 0)
+	#define LOG_WARN3(fmt, a0, a1, a2)		LOG_CAPTURE(LOG_LEVEL_WARN, fmt, a0, a1, a2)
+#else
+	#define LOG_WARN(fmt)
+	#define LOG_WARN1(fmt, a0)
+	#define LOG_WARN2(fmt, a0, a1)
+	#define LOG_WARN3(fmt, a0, a1, a2)
+#endif
+
+#if (LOG_MODULE_LEVEL >= LOG_LEVEL_INFO)
+	#define LOG_INFO(fmt)					LOG_CAPTURE(LOG_LEVEL_INFO, fmt, 0, 0, 0)
+	#define LOG_INFO1(fmt, a0)				LOG_CAPTURE(LOG_LEVEL_INFO, fmt, a0, 0, 0)
+	#define LOG_INFO2(fmt, a0, a1)			LOG_CAPTURE(LOG_LEVEL_INFO, fmt, a0, a1, 0)
+	#define LOG_INFO3(fmt, a0, a1, a2)		LOG_CAPTURE(LOG_LEVEL_INFO, fmt, a0, a1, a2)
+#else
+	#define LOG_INFO(fmt)
+	#define LOG_INFO1(fmt, a0)
+	#define LOG_INFO2(fmt, a0, a1)
+	#define LOG_INFO3(fmt, a0, a1, a2)
+#endif
+
+#if (LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG)
+	#define LOG_DEBUG(fmt)					LOG_CAPTURE(LOG_LEVEL_DEBUG, fmt, 0, 0, 0)
+	#define LOG_DEBUG1(fmt, a0)				LOG_CAPTURE(LOG_LEVEL_DEBUG, fmt, a0, 0, 0)
+	#define LOG_DEBUG2(fmt, a0, a1)			LOG_CAPTURE(LOG_LEVEL_DEBUG, fmt, a0, a1, 0)
+	#define LOG_DEBUG3(fmt, a0, a1, a2)		LOG_CAPTURE(LOG_LEVEL_DEBUG, fmt, a0, a1, a2)
+#else
+	#define LOG_DEBUG(fmt)
+	#define LOG_DEBUG1(fmt, a0)
+	#define LOG_DEBUG2(fmt, a0, a1)
+	#define LOG_DEBUG3(fmt, a0, a1, a2)
+#endif
+
+#endif /* LOG_MODULE && LOG_MODULE_LEVEL */
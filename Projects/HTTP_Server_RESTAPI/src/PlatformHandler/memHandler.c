@@ -0,0 +1,95 @@
+#include "W7500x.h"
+
+#include "memHandler.h"
+
+/* Private define ------------------------------------------------------------*/
+// Words left below the stack pointer of stack_start(): its own stores
+#define STACK_PAINT_MARGIN		8
+
+// Linker symbols: section (STACK, HEAP of startup_W7500x.s) and region (W7500x_App.sct) limits
+extern uint32_t STACK$$Base;
+extern uint32_t STACK$$Limit;
+extern uint32_t HEAP$$Base;
+extern uint32_t HEAP$$Limit;
+extern uint32_t Image$$RW_IRAM1$$RW$$Length;
+extern uint32_t Image$$RW_IRAM1$$ZI$$Length;
+extern uint32_t Image$$RW_IRAM1$$ZI$$Limit;
+extern uint32_t Image$$RW_NOINIT$$Base;
+extern uint32_t Image$$RW_NOINIT$$ZI$$Length;
+
+#define STACK_BASE				((uint32_t *)&STACK$$Base)
+#define STACK_LIMIT				((uint32_t *)&STACK$$Limit)
+#define STACK_ISR_BASE			((uint32_t *)((uint8_t *)STACK_LIMIT - MEM_ISR_STACK_SIZE))
+
+#define LINKER_VALUE(sym)		((uint32_t)&(sym))
+
+/* Private functions prototypes ----------------------------------------------*/
+static void stack_switch(uint32_t psp, void (*entry)(void));
+
+void stack_start(void (*entry)(void))
+{
+	uint32_t * p = STACK_BASE;
+	uint32_t * sp = (uint32_t *)__get_MSP() - STACK_PAINT_MARGIN;
+
+	// Process stack: not used yet; main stack: below the frames of the boot code
+	while(p < sp) *p++ = STACK_PAINT_PATTERN;
+
+	stack_switch((uint32_t)STACK_ISR_BASE, entry);
+}
+
+uint32_t get_stack_size(uint8_t stack)
+{
+	if(stack == MEM_STACK_ISR) return MEM_ISR_STACK_SIZE;
+
+	return (uint32_t)((uint8_t *)STACK_ISR_BASE - (uint8_t *)STACK_BASE);
+}
+
+// The stacks grow down: the painted words from the base of the stack
+uint32_t get_stack_free(uint8_t stack)
+{
+	const uint32_t * base = (stack == MEM_STACK_ISR) ? STACK_ISR_BASE : STACK_BASE;
+	const uint32_t * limit = (stack == MEM_STACK_ISR) ? STACK_LIMIT : STACK_ISR_BASE;
+	const uint32_t * p = base;
+
+	while((p < limit) && (*p == STACK_PAINT_PATTERN)) p++;
+
+	return (uint32_t)((const uint8_t *)p - (const uint8_t *)base);
+}
+
+void get_mem_ram(st_mem_ram * ram)
+{
+	ram->stack = LINKER_VALUE(STACK$$Limit) - LINKER_VALUE(STACK$$Base);
+	ram->heap = LINKER_VALUE(HEAP$$Limit) - LINKER_VALUE(HEAP$$Base);
+	ram->data = LINKER_VALUE(Image$$RW_IRAM1$$RW$$Length);
+	ram->bss = LINKER_VALUE(Image$$RW_IRAM1$$ZI$$Length) - ram->stack - ram->heap; // The NOINIT areas are ZI
+	ram->noinit = LINKER_VALUE(Image$$RW_NOINIT$$ZI$$Length);
+	ram->free = LINKER_VALUE(Image$$RW_NOINIT$$Base) - LINKER_VALUE(Image$$RW_IRAM1$$ZI$$Limit);
+}
+
+/* Private functions ---------------------------------------------------------*/
+// Thread mode on the PSP (CONTROL.SPSEL), then the entry; the MSP stays where it is, for the interrupt handlers
+#if defined(__CC_ARM)
+static __asm void stack_switch(uint32_t psp, void (*entry)(void))
+{
+	PRESERVE8
+	MSR PSP, r0
+	MOVS r0, #2
+	MSR CONTROL, r0
+	ISB
+	BLX r1
+stack_switch_end
+	B stack_switch_end
+}
+#else
+__attribute__((naked)) static void stack_switch(uint32_t psp, void (*entry)(void))
+{
+	__asm volatile(
+		"MSR PSP, r0        \n"
+		"MOVS r0, #2        \n"
+		"MSR CONTROL, r0    \n"
+		"ISB                \n"
+		"BLX r1             \n"
+		"1: B 1b            \n"
+	);
+}
+#endif
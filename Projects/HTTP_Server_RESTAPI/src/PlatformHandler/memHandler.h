@@ -0,0 +1,39 @@
+#ifndef MEMHANDLER_H_
+#define MEMHANDLER_H_
+
+#include <stdint.h>
+
+// Stacks: the STACK area of startup_W7500x.s is split at the boot. The interrupt handlers keep the main stack (MSP: the
+// top MEM_ISR_STACK_SIZE bytes, below the frames of the boot code), the main loop runs on the process stack (PSP: the
+// rest). Both are painted; the words still painted have never been used since the boot (high-water marks)
+#ifndef MEM_ISR_STACK_SIZE
+	#define MEM_ISR_STACK_SIZE	0x200
+#endif
+
+#define STACK_PAINT_PATTERN		0xA5A5A5A5
+
+#define MEM_STACK_MAIN			0		// Process stack: main loop
+#define MEM_STACK_ISR			1		// Main stack: interrupt handlers
+#define MEM_STACK_CNT			2
+
+// Static RAM (bytes): the regions of W7500x_App.sct, from the linker symbols
+typedef struct _st_mem_ram
+{
+	uint32_t data;		// Initialized variables (RW)
+	uint32_t bss;		// Zero-initialized variables (ZI), but the stack and the heap
+	uint32_t stack;		// STACK area: both stacks
+	uint32_t heap;		// HEAP area (startup_W7500x.s)
+	uint32_t noinit;	// Records kept across a reset ("NoInit" section)
+	uint32_t free;		// Left in the RAM region: headroom of the buffers
+} st_mem_ram;
+
+// First in main(): paints the stacks, then calls 'entry' on the process stack; does not return
+void stack_start(void (*entry)(void));
+
+// MEM_STACK_xxx: size, and bytes never used since the boot
+uint32_t get_stack_size(uint8_t stack);
+uint32_t get_stack_free(uint8_t stack);
+
+void get_mem_ram(st_mem_ram * ram);
+
+#endif /* MEMHANDLER_H_ */
@@ -0,0 +1,208 @@
+#include <stddef.h>
+
+#include "W7500x.h"
+
+#include "timerHandler.h"
+#include "schedHandler.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct _st_sched_task
+{
+	void (*run)(void);
+	uint16_t period;		// ms, 0: no periodic timer
+	uint8_t  armed;			// The timer is in the wheel
+	uint32_t expires;		// Tick of the timer expiry
+	st_sched_stats stats;
+} st_sched_task;
+
+/* Private define ------------------------------------------------------------*/
+// The ready set and the timer wheel are shared with the interrupt handlers
+#define SCHED_LOCK(primask)		do { (primask) = __get_PRIMASK(); __disable_irq(); } while(0)
+#define SCHED_UNLOCK(primask)	__set_PRIMASK(primask)
+
+#define SCHED_WHEEL_MASK		(SCHED_WHEEL_SIZE - 1)
+
+/* Private functions prototypes ----------------------------------------------*/
+static void sched_arm(uint8_t id, uint32_t expires);
+static void sched_account(st_sched_stats * stats, uint32_t usec);
+
+/* Private variables ---------------------------------------------------------*/
+static st_sched_task sched_tasks[SCHED_MAX_TASKS];
+static uint8_t sched_task_cnt = 0;
+static st_sched_stats sched_idle = { "idle", 0, 0, 0, 0 };
+
+static volatile uint8_t sched_ready = 0;					// Ready set: bit n, task n
+static volatile uint8_t sched_wheel[SCHED_WHEEL_SIZE];		// Timers of the slot: bit n, task n
+static volatile uint32_t sched_ticks = 0;
+static volatile int8_t sched_running = SCHED_TASK_NONE;
+
+int8_t sched_add_task(const char* name, void (*run)(void), uint16_t period_msec)
+{
+	st_sched_task * task;
+	uint32_t primask;
+	int8_t id;
+
+	if((sched_task_cnt >= SCHED_MAX_TASKS) || (run == NULL)) return SCHED_TASK_NONE;
+
+	id = (int8_t)sched_task_cnt;
+	task = &sched_tasks[id];
+	task->run = run;
+	task->period = period_msec;
+	task->stats.name = name;
+
+	SCHED_LOCK(primask);
+	sched_task_cnt++;
+	if(period_msec) sched_arm(id, sched_ticks + period_msec);
+	SCHED_UNLOCK(primask);
+
+	return id;
+}
+
+void sched_post(int8_t id)
+{
+	uint32_t primask;
+
+	if((id < 0) || (id >= sched_task_cnt)) return;
+
+	SCHED_LOCK(primask);
+	sched_ready |= (uint8_t)(1 << id);
+	SCHED_UNLOCK(primask);
+}
+
+void sched_timer(int8_t id, uint16_t msec)
+{
+	uint32_t primask;
+
+	if((id < 0) || (id >= sched_task_cnt)) return;
+
+	if(msec == 0)
+	{
+		sched_post(id);
+		return;
+	}
+
+	SCHED_LOCK(primask);
+	sched_arm(id, sched_ticks + msec);
+	SCHED_UNLOCK(primask);
+}
+
+// The slot of the tick holds the timers expiring at this tick and the ones of the later turns of the wheel
+void sched_tick(void)
+{
+	st_sched_task * task;
+	uint32_t primask;
+	uint32_t now;
+	uint8_t slot;
+	uint8_t id;
+
+	SCHED_LOCK(primask);
+	now = ++sched_ticks;
+	slot = sched_wheel[now & SCHED_WHEEL_MASK];
+
+	for(id = 0; slot; id++, slot >>= 1)
+	{
+		if(!(slot & 1)) continue;
+
+		task = &sched_tasks[id];
+		if(task->expires != now) continue; // A later turn
+
+		sched_wheel[now & SCHED_WHEEL_MASK] &= (uint8_t)~(1 << id);
+		task->armed = 0;
+		sched_ready |= (uint8_t)(1 << id);
+
+		if(task->period) sched_arm(id, now + task->period); // From the expiry: no drift
+	}
+	SCHED_UNLOCK(primask);
+}
+
+void sched_run(void)
+{
+	st_sched_task * task;
+	uint32_t primask;
+	uint32_t start, end;
+	uint8_t ready;
+	uint8_t id;
+
+	while(1)
+	{
+		// One pass: the tasks ready at its start in the order of registration; a task posted again waits for the next
+		// pass, so a busy task does not starve the others
+		SCHED_LOCK(primask);
+		ready = sched_ready;
+		sched_ready = 0;
+
+		if(ready == 0)
+		{
+			// Sleep: __WFI() wakes up on a pending interrupt with the interrupts masked, so a post between the check and
+			// the sleep is not missed; the handler runs at the unlock
+			start = getDeviceTime_usec();
+			__WFI();
+			end = getDeviceTime_usec();
+			SCHED_UNLOCK(primask);
+
+			sched_account(&sched_idle, end - start);
+			continue;
+		}
+		SCHED_UNLOCK(primask);
+
+		for(id = 0; ready; id++, ready >>= 1)
+		{
+			if(!(ready & 1)) continue;
+
+			task = &sched_tasks[id];
+			start = getDeviceTime_usec();
+			sched_running = (int8_t)id;
+			task->run();
+			sched_running = SCHED_TASK_NONE;
+			sched_account(&task->stats, getDeviceTime_usec() - start);
+		}
+	}
+}
+
+const char* get_sched_running(void)
+{
+	int8_t id = sched_running;
+	
+	if(id == SCHED_TASK_NONE) return NULL;
+	
+	return sched_tasks[id].stats.name;
+}
+
+uint8_t get_sched_task_count(void)
+{
+	return sched_task_cnt;
+}
+
+const st_sched_stats* get_sched_stats(uint8_t id)
+{
+	if(id < sched_task_cnt) return &sched_tasks[id].stats;
+	if(id == sched_task_cnt) return &sched_idle;
+
+	return NULL;
+}
+
+/* Private functions ---------------------------------------------------------*/
+// Interrupts masked
+static void sched_arm(uint8_t id, uint32_t expires)
+{
+	st_sched_task * task = &sched_tasks[id];
+
+	if(task->armed) sched_wheel[task->expires & SCHED_WHEEL_MASK] &= (uint8_t)~(1 << id);
+
+	task->expires = expires;
+	task->armed = 1;
+	sched_wheel[expires & SCHED_WHEEL_MASK] |= (uint8_t)(1 << id);
+}
+
+// Main loop only: read by the metrics between the runs
+static void sched_account(st_sched_stats * stats, uint32_t usec)
+{
+	stats->runs++;
+	stats->usec += usec;
+	while(stats->usec >= 1000000)
+	{
+		stats->usec -= 1000000;
+		stats->sec++;
+	}
+	if(usec > stats->max_usec) stats->max_usec = usec;
+}
@@ -0,0 +1,46 @@
+#ifndef SCHEDHANDLER_H_
+#define SCHEDHANDLER_H_
+
+#include <stdint.h>
+
+// Cooperative run-to-completion scheduler of the main loop: a task runs when it is posted (by an interrupt handler or
+// a task) or when its timer expires (timer wheel, 1ms tick); the MCU sleeps (__WFI) while no task is ready
+#define SCHED_MAX_TASKS			8		// Tasks: bits of the ready set
+#define SCHED_WHEEL_SIZE		64		// Slots of the timer wheel (1ms each), power of 2; longer timers wait for more turns
+
+#define SCHED_TASK_NONE			-1
+
+// Run-time statistics of a task; the idle pseudo-task counts the sleeps and the time asleep
+typedef struct _st_sched_stats
+{
+	const char* name;
+	uint32_t runs;
+	uint32_t sec;			// Total run time: sec + usec
+	uint32_t usec;
+	uint32_t max_usec;		// Longest run
+} st_sched_stats;
+
+// Returns the task id (also the priority: the tasks ready at once run in the order of registration), SCHED_TASK_NONE if the table is full.
+// period_msec: the task runs periodically, 0: when posted or by sched_timer() only
+int8_t sched_add_task(const char* name, void (*run)(void), uint16_t period_msec);
+
+// Ready the task: from the interrupt handlers or the tasks; a task posted while it runs runs again in the next pass
+void sched_post(int8_t id);
+
+// Next run of the task in 'msec' (0: now), then every period if it has one
+void sched_timer(int8_t id, uint16_t msec);
+
+// 1ms Tick Timer handler: timer wheel
+void sched_tick(void);
+
+// Main loop: runs the ready tasks, sleeps when there is none; does not return
+void sched_run(void);
+
+// Name of the task running, NULL: none (e.g. read by the watchdog supervisor from the interrupt handler)
+const char* get_sched_running(void);
+
+// Run-time statistics: the tasks by id, then the idle pseudo-task at 'get_sched_task_count()'
+uint8_t get_sched_task_count(void);
+const st_sched_stats* get_sched_stats(uint8_t id);
+
+#endif /* SCHEDHANDLER_H_ */
@@ -3,17 +3,20 @@
 #include "common.h"
 #include "W7500x_board.h"
 #include "timerHandler.h"
+#include "schedHandler.h"
+#include "wdtHandler.h"
 #include "dhcp.h"
+#include "httpMetrics.h"
 
-static volatile uint16_t msec_cnt = 0;
-static volatile uint8_t  sec_cnt = 0;
-static volatile uint8_t  min_cnt = 0;
-static volatile uint32_t hour_cnt = 0;
+static volatile uint16_t msec_cnt = 0;	// Milliseconds of the 1s tick
+static volatile uint32_t usec_hi = 0;	// Timebase: wraps of Dualtimer 0_1, upper 32 bits
 
-// For main routine
-extern uint8_t flag_application_running;
-uint8_t flag_check_main_routine = 0;
-volatile uint16_t main_routine_check_time_msec = 0;
+// Dualtimer 0 clock: external oscillator (8MHz) / 8, 1MHz: the timer counts microseconds, no divide on Cortex-M0
+#define TIMER_CLK_HZ		1000000UL
+// Dualtimer 0_0: 1ms period
+#define TIMER_LOAD			(TIMER_CLK_HZ / 1000)
+// Dualtimer 0_1: free-running 32-bit down counter, the timebase (lower 32 bits: ~value)
+#define TIMEBASE_LOAD		0xFFFFFFFFUL
 
 void Timer_Configuration(void)
 {
@@ -21,11 +24,15 @@ void Timer_Configuration(void)
 	
 	NVIC_EnableIRQ(DUALTIMER0_IRQn);
 	
+	/* Dualtimer 0 clock: 1MHz */
+	CRG->TIMER0CLK_SSR = CRG_TIMERCLK_SSR_OCLK;
+	CRG->TIMER0CLK_PVSR = CRG_TIMERCLK_PVSR_DIV8;
+	
 	/* Dualtimer 0_0 clock enable */
 	DUALTIMER_ClockEnable(DUALTIMER0_0);
 
 	/* Dualtimer 0_0 configuration */
-	Dualtimer_InitStructure.TimerLoad = 0x0000BB80;
+	Dualtimer_InitStructure.TimerLoad = TIMER_LOAD;
 	Dualtimer_InitStructure.TimerControl_Mode = DUALTIMER_TimerControl_Periodic;
 	Dualtimer_InitStructure.TimerControl_OneShot = DUALTIMER_TimerControl_Wrapping;
 	Dualtimer_InitStructure.TimerControl_Pre = DUALTIMER_TimerControl_Pre_1;
@@ -35,8 +42,20 @@ void Timer_Configuration(void)
 
 	/* Dualtimer 0_0 Interrupt enable */
 	DUALTIMER_IntConfig(DUALTIMER0_0, ENABLE);
+	
+	/* Dualtimer 0_1: timebase */
+	DUALTIMER_ClockEnable(DUALTIMER0_1);
+	
+	Dualtimer_InitStructure.TimerLoad = TIMEBASE_LOAD;
+	Dualtimer_InitStructure.TimerControl_Mode = DUALTIMER_TimerControl_FreeRunning;
+	
+	DUALTIMER_Init(DUALTIMER0_1, &Dualtimer_InitStructure);
+	
+	/* Dualtimer 0_1 Interrupt enable: wrap, every 71 minutes */
+	DUALTIMER_IntConfig(DUALTIMER0_1, ENABLE);
 
-	/* Dualtimer 0_0 start */
+	/* Dualtimer 0_0 / 0_1 start */
+	DUALTIMER_Start(DUALTIMER0_1);
 	DUALTIMER_Start(DUALTIMER0_0);
 }
 
@@ -46,63 +65,88 @@ void Timer_IRQ_Handler(void)
 	{
 		DUALTIMER_IntClear(DUALTIMER0_0);
 		
-		msec_cnt++; // millisecond counter
-		
-		if(flag_application_running)
-		{
-			if(++main_routine_check_time_msec >= MAIN_ROUTINE_CHECK_CYCLE_MSEC)
-			{
-				flag_check_main_routine = 1;
-				main_routine_check_time_msec = 0;
-			}
-		}
+		sched_tick();	// Timer wheel of the main loop tasks
+		wdt_supervisor_tick();	// Watchdog: deadlines of the subsystems
 		
 		/* Second Process */
-		if(msec_cnt >= 1000 - 1) //second //if((msec_cnt % 1000) == 0) 
+		if(++msec_cnt >= 1000)
 		{
 			msec_cnt = 0;
-			sec_cnt++;
 			
 			DHCP_time_handler();	// Time counter for DHCP timeout
-		}
-		
-		/* Minute Process */
-		if(sec_cnt >= 60) //if((sec_cnt % 60) == 0) 
-		{
-			sec_cnt = 0;
-			min_cnt++;
-		}
-		
-		/* Hour Process */
-		if(min_cnt >= 60)
-		{
-			min_cnt = 0;
-			hour_cnt++;
+			http_metrics_time_handler();	// Main loop iterations per second
 		}
 	}
 
 	if(DUALTIMER_GetIntStatus(DUALTIMER0_1))
 	{
 		DUALTIMER_IntClear(DUALTIMER0_1);
+		usec_hi++; // Timebase wrap
 	}
 }
 
+// Lock-free: the upper half is read again if the wrap interrupt was served between the reads. A wrap not served yet
+// (interrupts masked, or read from a higher priority handler) is pending with the lower half just restarted
+uint64_t getDeviceTime_usec64(void)
+{
+	uint32_t hi, lo, wrap;
+	
+	do
+	{
+		hi = usec_hi;
+		lo = ~DUALTIMER_GetTimerValue(DUALTIMER0_1);
+		wrap = (DUALTIMER_GetIntStatus(DUALTIMER0_1) && (lo < 0x80000000UL)) ? 1 : 0;
+	} while(hi != usec_hi);
+	
+	return ((uint64_t)(hi + wrap) << 32) | lo;
+}
+
+uint32_t getDeviceTime_usec(void)
+{
+	return ~DUALTIMER_GetTimerValue(DUALTIMER0_1);
+}
+
+// 64-bit divides (run-time library): for the uptime resources, not for the instrumentation
+void getDeviceUptime(st_uptime * uptime)
+{
+	uint64_t msec = getDeviceTime_usec64() / 1000;
+	uint32_t sec = (uint32_t)(msec / 1000);
+	
+	uptime->msec = (uint16_t)(msec - ((uint64_t)sec * 1000));
+	uptime->hour = sec / 3600;
+	sec -= uptime->hour * 3600;
+	uptime->min = (uint8_t)(sec / 60);
+	uptime->sec = (uint8_t)(sec - (uptime->min * 60));
+}
+
 uint32_t getDeviceUptime_hour(void)
 {
-	return hour_cnt;
+	st_uptime uptime;
+	
+	getDeviceUptime(&uptime);
+	return uptime.hour;
 }
 
 uint8_t getDeviceUptime_min(void)
 {
-	return min_cnt;
+	st_uptime uptime;
+	
+	getDeviceUptime(&uptime);
+	return uptime.min;
 }
 
 uint8_t getDeviceUptime_sec(void)
 {
-	return sec_cnt;
+	st_uptime uptime;
+	
+	getDeviceUptime(&uptime);
+	return uptime.sec;
 }
 
 uint16_t getDeviceUptime_msec(void)
 {
-	return msec_cnt;
+	st_uptime uptime;
+	
+	getDeviceUptime(&uptime);
+	return uptime.msec;
 }
@@ -3,13 +3,28 @@
 
 #include <stdint.h>
 
-// For main routine checker
+// For main routine checker: period of the LED task
 #define MAIN_ROUTINE_CHECK_CYCLE_MSEC		100 // msec
-extern uint8_t flag_check_main_routine;
+
+typedef struct _st_uptime
+{
+	uint32_t hour;
+	uint8_t  min;
+	uint8_t  sec;
+	uint16_t msec;
+} st_uptime;
 
 void Timer_Configuration(void);
 void Timer_IRQ_Handler(void);
 
+// Timebase: free-running microseconds since the boot (Dualtimer 0_1), 64-bit: no wrap
+uint64_t getDeviceTime_usec64(void);
+// Lower 32 bits of the timebase, for intervals up to 71 minutes: (end - start) across the wrap
+uint32_t getDeviceTime_usec(void);
+
+// Uptime from one read of the timebase: the fields are consistent
+void getDeviceUptime(st_uptime * uptime);
+// One field of the uptime: a read of the timebase each
 uint32_t getDeviceUptime_hour(void);
 uint8_t  getDeviceUptime_min(void);
 uint8_t  getDeviceUptime_sec(void);
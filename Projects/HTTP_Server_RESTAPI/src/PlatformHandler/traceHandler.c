@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "W7500x.h"
+
+#include "timerHandler.h"
+#include "traceHandler.h"
+
+/* Private define ------------------------------------------------------------*/
+// Slot claim with the interrupts masked: the records can be written from the interrupt handlers
+#ifndef TRACE_NO_IRQ_LOCK
+	#define TRACE_LOCK(primask)		do { (primask) = __get_PRIMASK(); __disable_irq(); } while(0)
+	#define TRACE_UNLOCK(primask)	__set_PRIMASK(primask)
+#else // Host build: no interrupt handlers
+	#define TRACE_LOCK(primask)		((primask) = 0)
+	#define TRACE_UNLOCK(primask)	((void)(primask))
+#endif
+
+#define TRACE_DUMP_LINE			48	// Bytes per 'TRACE:' line
+
+// Drain cursor: records left + 1 (bits 31-24), sequence number of the last record + 1 (bits 23-0)
+#define TRACE_CURSOR_SEQ_MASK	0x00FFFFFF
+
+/* Private functions prototypes ----------------------------------------------*/
+static uint8_t * trace_put16(uint8_t * p, uint16_t val);
+static uint8_t * trace_put32(uint8_t * p, uint32_t val);
+static uint8_t * trace_put_record(uint8_t * p, const st_trace_event * ev);
+
+/* Private variables ---------------------------------------------------------*/
+static st_trace_event trace_ring[TRACE_RING_SIZE];
+static volatile uint32_t trace_head = 0; // Records written: sequence number of the next record
+
+void trace_event(uint8_t sock, uint8_t id, uint16_t arg0, uint32_t arg1)
+{
+	st_trace_event * ev;
+	uint32_t primask;
+
+	TRACE_LOCK(primask);
+	ev = &trace_ring[trace_head++ & (TRACE_RING_SIZE - 1)];
+	TRACE_UNLOCK(primask);
+
+	ev->time = getDeviceTime_usec();
+	ev->sock = sock;
+	ev->id = id;
+	ev->arg0 = arg0;
+	ev->arg1 = arg1;
+}
+
+// The drain ends at the records written when it started: the events of the drain itself (e.g. the chunks sent) are
+// left to the next one
+int16_t trace_generate(char* buf, uint16_t size, uint32_t* cursor)
+{
+	uint8_t * p = (uint8_t *)buf;
+	uint8_t * end = (uint8_t *)buf + size;
+	uint32_t head = trace_head;
+	uint32_t seq, left, skipped;
+	st_trace_event lost;
+
+	if(*cursor == 0)
+	{
+		if(size < TRACE_HEADER_SIZE + sizeof(st_trace_event)) return 0;
+
+		seq = (head > TRACE_RING_SIZE) ? (head - TRACE_RING_SIZE) : 0;
+		left = head - seq;
+		memcpy(p, TRACE_MAGIC, 4);
+		p[4] = TRACE_VERSION;
+		p[5] = sizeof(st_trace_event);
+		p = trace_put16(p + 6, TRACE_RING_SIZE);
+		p = trace_put32(p, seq);
+		p = trace_put32(p, head);
+	}
+	else
+	{
+		left = (*cursor >> 24) - 1;
+		seq = (*cursor - left) & TRACE_CURSOR_SEQ_MASK; // Lower 24 bits: enough for the distance to the head
+	}
+
+	// Overwritten while the ring is drained: a TRACE_EV_LOST record with the number of the records skipped
+	skipped = (head - seq) & TRACE_CURSOR_SEQ_MASK;
+	if(left && (skipped > TRACE_RING_SIZE) && ((end - p) >= (int16_t)sizeof(st_trace_event)))
+	{
+		skipped -= TRACE_RING_SIZE;
+		if(skipped > left) skipped = left;
+
+		lost.time = getDeviceTime_usec();
+		lost.sock = TRACE_SOCK_NONE;
+		lost.id = TRACE_EV_LOST;
+		lost.arg0 = 0;
+		lost.arg1 = skipped;
+		p = trace_put_record(p, &lost);
+		seq += skipped;
+		left -= skipped;
+	}
+
+	while(left && ((end - p) >= (int16_t)sizeof(st_trace_event)))
+	{
+		p = trace_put_record(p, &trace_ring[seq & (TRACE_RING_SIZE - 1)]);
+		seq++;
+		left--;
+	}
+
+	*cursor = ((left + 1) << 24) | ((seq + left) & TRACE_CURSOR_SEQ_MASK);
+
+	return (int16_t)(p - (uint8_t *)buf);
+}
+
+void trace_dump(void)
+{
+	uint8_t buf[TRACE_DUMP_LINE];
+	uint32_t cursor = 0;
+	int16_t len, i;
+
+	while((len = trace_generate((char *)buf, sizeof(buf), &cursor)) > 0)
+	{
+		printf("TRACE:");
+		for(i = 0; i < len; i++) printf("%02x", buf[i]);
+		printf("\r\n");
+	}
+}
+
+uint8_t trace_last(st_trace_event * events, uint8_t cnt, uint32_t * seq)
+{
+	uint32_t head = trace_head;
+	uint32_t first;
+	uint8_t i;
+	
+	if(cnt > TRACE_RING_SIZE) cnt = TRACE_RING_SIZE;
+	if(cnt > head) cnt = (uint8_t)head;
+	
+	first = head - cnt;
+	for(i = 0; i < cnt; i++) events[i] = trace_ring[(first + i) & (TRACE_RING_SIZE - 1)];
+	
+	*seq = first;
+	return cnt;
+}
+
+int16_t trace_encode(char* buf, uint16_t size, const st_trace_event * events, uint8_t cnt, uint32_t seq)
+{
+	uint8_t * p = (uint8_t *)buf;
+	uint8_t i;
+	
+	if(size < TRACE_HEADER_SIZE + ((uint16_t)cnt * sizeof(st_trace_event))) return 0;
+	
+	memcpy(p, TRACE_MAGIC, 4);
+	p[4] = TRACE_VERSION;
+	p[5] = sizeof(st_trace_event);
+	p = trace_put16(p + 6, cnt);
+	p = trace_put32(p, seq);
+	p = trace_put32(p, seq + cnt);
+	
+	for(i = 0; i < cnt; i++) p = trace_put_record(p, &events[i]);
+	
+	return (int16_t)(p - (uint8_t *)buf);
+}
+
+/* Private functions ---------------------------------------------------------*/
+static uint8_t * trace_put16(uint8_t * p, uint16_t val)
+{
+	p[0] = (uint8_t)val;
+	p[1] = (uint8_t)(val >> 8);
+
+	return p + 2;
+}
+
+static uint8_t * trace_put32(uint8_t * p, uint32_t val)
+{
+	p = trace_put16(p, (uint16_t)val);
+
+	return trace_put16(p, (uint16_t)(val >> 16));
+}
+
+static uint8_t * trace_put_record(uint8_t * p, const st_trace_event * ev)
+{
+	p = trace_put32(p, ev->time);
+	*p++ = ev->sock;
+	*p++ = ev->id;
+	p = trace_put16(p, ev->arg0);
+
+	return trace_put32(p, ev->arg1);
+}
@@ -0,0 +1,73 @@
+#ifndef TRACEHANDLER_H_
+#define TRACEHANDLER_H_
+
+#include <stdint.h>
+
+// Binary trace: fixed-size event records in a RAM ring, the oldest records are overwritten.
+// Written with a few stores (no formatting), so the trace stays enabled in the release build; drained on demand
+// over HTTP ('/diag/trace') or the debug UART (trace_dump()), rendered by host/tracedump
+#define _USE_TRACE_
+
+#define TRACE_RING_SIZE			64		// Records, power of 2 up to 128 (12 bytes each)
+
+typedef struct _st_trace_event
+{
+	uint32_t time;		// getDeviceTime_usec()
+	uint8_t  sock;		// H/W socket number, TRACE_SOCK_NONE: not a socket event
+	uint8_t  id;		// TRACE_EV_xxx
+	uint16_t arg0;
+	uint32_t arg1;
+} st_trace_event;
+
+#define TRACE_SOCK_NONE			0xFF
+
+// Drained stream: header, then the records from the oldest to the newest (little-endian)
+//  - 'W' 'Z' 'T' 'R', version, record size, ring size (16-bit), sequence number of the first record (32-bit), records written (32-bit)
+#define TRACE_MAGIC				"WZTR"
+#define TRACE_VERSION			1
+#define TRACE_HEADER_SIZE		16
+
+/*********************************************
+* Trace events: arg0, arg1
+*********************************************/
+// System
+#define TRACE_EV_LOST			0x01	// -, records overwritten while the ring was drained
+#define TRACE_EV_BOOT			0x02	// -, -
+// HTTP server (httpServer_rest.c)
+#define TRACE_EV_HTTP_OPEN		0x10	// server port, -
+#define TRACE_EV_HTTP_CONNECT	0x11	// peer port, peer IP address (a.b.c.d: 0xaabbccdd)
+#define TRACE_EV_HTTP_REQUEST	0x12	// method (HTTP_REQ_METHOD_xxx), request bytes received
+#define TRACE_EV_HTTP_ROUTE		0x13	// resource table number (0xFFFF: none), request type (HTTP_RES_TYPE_xxx of the URI)
+#define TRACE_EV_HTTP_RESPONSE	0x14	// status code, body length (0xFFFFFFFF: chunked)
+#define TRACE_EV_HTTP_CHUNK		0x15	// chunk length, generator cursor (0 for the handler's writer)
+#define TRACE_EV_HTTP_STREAM_END	0x16	// -, generator cursor
+#define TRACE_EV_HTTP_STATE		0x17	// new state (STATE_HTTP_xxx), -
+#define TRACE_EV_HTTP_CLOSE_WAIT	0x18	// state (STATE_HTTP_xxx), -
+#define TRACE_EV_HTTP_DONE		0x19	// status code (0: no complete response), latency (us)
+#define TRACE_EV_HTTP_SEND_ERR	0x1A	// length, send() result
+#define TRACE_EV_HTTP_REAP		0x1B	// idle time limit (s), -
+
+#ifdef _USE_TRACE_
+	#define TRACE_EVENT(sock, id, arg0, arg1)	trace_event((sock), (id), (uint16_t)(arg0), (uint32_t)(arg1))
+#else
+	#define TRACE_EVENT(sock, id, arg0, arg1)
+#endif
+
+void trace_event(uint8_t sock, uint8_t id, uint16_t arg0, uint32_t arg1);
+
+// Drain: the header then the records, whole records only; '*cursor' starts from 0, returns 0 at the end.
+// Body generator of the '/diag/trace' resource (st_http_resource)
+int16_t trace_generate(char* buf, uint16_t size, uint32_t* cursor);
+
+// Drain to the debug UART (printf): 'TRACE:' lines of the stream in hex
+void trace_dump(void);
+
+// Copy of the newest records (up to 'cnt'), from the oldest; '*seq': sequence number of the first. Returns the number
+// of records copied. No lock: from the fault handler (crashHandler.c)
+uint8_t trace_last(st_trace_event * events, uint8_t cnt, uint32_t * seq);
+
+// Stream of the drain (header, records) for a copy of the records, e.g. the records of a crash capture; returns its
+// length, 0 if 'size' is too small
+int16_t trace_encode(char* buf, uint16_t size, const st_trace_event * events, uint8_t cnt, uint32_t seq);
+
+#endif /* TRACEHANDLER_H_ */
@@ -7,14 +7,25 @@
 /* Private typedef -----------------------------------------------------------*/
 
 /* Private define ------------------------------------------------------------*/
+#define UART2_TX_RING_MASK		(UART2_TX_RING_SIZE - 1)
 
 /* Private functions prototypes ----------------------------------------------*/
+static void UART2_TxNext(void);
 
 /* Private functions ---------------------------------------------------------*/
 
 /* Private macro -------------------------------------------------------------*/
+// The ring indexes are shared with UART2_IRQ_Handler()
+#define UART2_TX_LOCK(primask)		do { (primask) = __get_PRIMASK(); __disable_irq(); } while(0)
+#define UART2_TX_UNLOCK(primask)	__set_PRIMASK(primask)
 
 /* Private variables ---------------------------------------------------------*/
+static uint8_t uart2_tx_ring[UART2_TX_RING_SIZE];
+static volatile uint16_t uart2_tx_head = 0;	// Next byte written
+static volatile uint16_t uart2_tx_tail = 0;	// Next byte sent
+static volatile uint8_t uart2_tx_busy = 0;	// A byte is in the UART: the TX interrupt sends the next one
+static volatile uint8_t uart2_tx_blocking = 1;
+static volatile uint32_t uart2_tx_dropped = 0;
 
 void UART1_Configuration(void)
 {
@@ -39,4 +50,101 @@ void UART2_Configuration(void)
 {
 	/* Configure UART2: Simple UART */
 	S_UART_Init(115200);
+	
+	/* TX interrupt: the TX buffer of the UART is free again */
+	S_UART_ITConfig(S_UART_CTRL_TXI, ENABLE);
+	NVIC_EnableIRQ(UART2_IRQn);
+}
+
+uint16_t UART2_Write(const uint8_t * buf, uint16_t len)
+{
+	uint32_t primask;
+	uint16_t i;
+
+	for(i = 0; i < len; i++)
+	{
+		UART2_TX_LOCK(primask);
+		
+		if(((uart2_tx_head - uart2_tx_tail) & UART2_TX_RING_MASK) == UART2_TX_RING_MASK) // Ring full
+		{
+			if(uart2_tx_blocking)
+			{
+				// Polls the UART: the TX interrupt may be masked by the caller
+				while(((uart2_tx_head - uart2_tx_tail) & UART2_TX_RING_MASK) == UART2_TX_RING_MASK) UART2_TxNext();
+			}
+#if (UART2_TX_POLICY == UART2_TX_DROP_OLDEST)
+			else
+			{
+				uart2_tx_tail = (uart2_tx_tail + 1) & UART2_TX_RING_MASK;
+				uart2_tx_dropped++;
+			}
+#else
+			else
+			{
+				uart2_tx_dropped += (len - i);
+				UART2_TX_UNLOCK(primask);
+				break;
+			}
+#endif
+		}
+		
+		uart2_tx_ring[uart2_tx_head] = buf[i];
+		uart2_tx_head = (uart2_tx_head + 1) & UART2_TX_RING_MASK;
+		
+		if(!uart2_tx_busy) UART2_TxNext(); // Idle: the first byte starts the TX interrupts
+		
+		UART2_TX_UNLOCK(primask);
+	}
+
+	return i;
+}
+
+void UART2_SetTxBlocking(FunctionalState NewState)
+{
+	uart2_tx_blocking = (NewState != DISABLE);
+}
+
+void UART2_Flush(void)
+{
+	uint32_t primask;
+
+	while(uart2_tx_head != uart2_tx_tail)
+	{
+		UART2_TX_LOCK(primask);
+		UART2_TxNext();
+		UART2_TX_UNLOCK(primask);
+	}
+}
+
+void UART2_IRQ_Handler(void)
+{
+	if(S_UART_GetITStatus(S_UART_INTSTATUS_TXI))
+	{
+		S_UART_ClearITPendingBit(S_UART_INTSTATUS_TXI);
+		UART2_TxNext();
+	}
+}
+
+uint32_t get_UART2_tx_dropped(void)
+{
+	return uart2_tx_dropped;
+}
+
+// Next byte of the ring into the UART TX buffer, if free; called with the interrupts masked or from the handler
+static void UART2_TxNext(void)
+{
+	if(S_UART_GetFlagStatus(S_UART_STATE_TXF) == SET)
+	{
+		uart2_tx_busy = 1; // The TX interrupt follows when the buffer is free
+	}
+	else if(uart2_tx_head != uart2_tx_tail)
+	{
+		UART2->DATA = uart2_tx_ring[uart2_tx_tail];
+		uart2_tx_tail = (uart2_tx_tail + 1) & UART2_TX_RING_MASK;
+		uart2_tx_busy = 1;
+	}
+	else
+	{
+		uart2_tx_busy = 0;
+	}
 }
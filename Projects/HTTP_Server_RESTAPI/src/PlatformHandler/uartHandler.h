@@ -1,9 +1,35 @@
 #ifndef UARTHANDLER_H_
 #define UARTHANDLER_H_
 
+#include <stdint.h>
+#include "W7500x.h"
+
 //#define _UART_DEBUG_
 
+// Debug UART (UART2) TX ring: printf() copies into the ring, the UART2 TX interrupt drains it
+#define UART2_TX_RING_SIZE		512		// Bytes, power of 2
+
+// Ring full, when the TX is not blocking (UART2_SetTxBlocking(DISABLE)): the bytes dropped are counted
+#define UART2_TX_DROP_NEWEST	0		// The bytes written are dropped: the lines already queued are kept whole
+#define UART2_TX_DROP_OLDEST	1		// The oldest queued bytes are dropped: the latest messages are kept
+#define UART2_TX_POLICY			UART2_TX_DROP_NEWEST
+
 void UART1_Configuration(void);
 void UART2_Configuration(void);
 
+// Copies 'len' bytes into the TX ring; returns the number of bytes queued (dropped bytes are not counted)
+uint16_t UART2_Write(const uint8_t * buf, uint16_t len);
+
+// Blocking: waits for space in the ring instead of dropping (default, for the boot messages); the wait drains the
+// UART by polling, so it also works with the interrupts masked
+void UART2_SetTxBlocking(FunctionalState NewState);
+
+// Waits until the TX ring is empty
+void UART2_Flush(void);
+
+// UART2 interrupt handler (W7500x_it.c)
+void UART2_IRQ_Handler(void);
+
+uint32_t get_UART2_tx_dropped(void); // Bytes dropped since the boot
+
 #endif /* UARTHANDLER_H_ */
@@ -0,0 +1,184 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "W7500x.h"
+#include "W7500x_crg.h"
+#include "W7500x_wdt.h"
+
+#include "schedHandler.h"
+#include "wdtHandler.h"
+
+/* Private define ------------------------------------------------------------*/
+// Watchdog clock: internal 8MHz RC oscillator, runs without the external clock
+#define WDT_CLK_KHZ				8000
+// The counter times out twice without a kick: the interrupt (not enabled in the NVIC), then the reset
+#define WDT_LOAD				((WDT_TIMEOUT_MSEC / 2) * WDT_CLK_KHZ)
+
+#define WDT_RECORD_STARVED		0x57445453	// "WDTS": written by the supervisor, the reset follows
+#define WDT_RECORD_REPORTED		0x57445452	// "WDTR": taken at the boot
+
+/* Private functions prototypes ----------------------------------------------*/
+static void wdt_record_seal(st_wdt_record * rec);
+static uint8_t wdt_record_valid(const st_wdt_record * rec);
+static void wdt_record_name(char * dst, const char * src);
+
+/* Private variables ---------------------------------------------------------*/
+// No-init RAM: not zeroed by the C library at the boot (UNINIT region of the scatter file)
+static st_wdt_record wdt_record __attribute__((section("NoInit"), zero_init));
+
+static st_wdt_record wdt_last_reset;
+static uint8_t wdt_last_reset_valid = 0;
+
+static st_wdt_subsys wdt_subsys[WDT_MAX_SUBSYS];
+static uint8_t wdt_subsys_cnt = 0;
+
+static volatile uint32_t wdt_ticks = 0;
+static uint8_t wdt_check_cnt = 0;
+static uint8_t wdt_running = 0;
+static uint8_t wdt_starved = 0;
+
+void wdt_supervisor_init(void)
+{
+	if(wdt_record_valid(&wdt_record))
+	{
+		if(wdt_record.magic == WDT_RECORD_STARVED)
+		{
+			wdt_last_reset = wdt_record;
+			wdt_last_reset_valid = 1;
+		}
+	}
+	else // Power on: random contents
+	{
+		memset(&wdt_record, 0, sizeof(wdt_record));
+	}
+
+	wdt_record.magic = WDT_RECORD_REPORTED;
+	wdt_record_seal(&wdt_record);
+}
+
+int8_t wdt_add_subsys(const char* name, uint16_t deadline_msec)
+{
+	st_wdt_subsys * subsys;
+
+	if((wdt_subsys_cnt >= WDT_MAX_SUBSYS) || wdt_running) return WDT_SUBSYS_NONE;
+
+	subsys = &wdt_subsys[wdt_subsys_cnt];
+	subsys->name = name;
+	subsys->deadline = deadline_msec;
+	subsys->last = wdt_ticks;
+	subsys->checkins = 0;
+
+	return (int8_t)wdt_subsys_cnt++;
+}
+
+void wdt_checkin(int8_t id)
+{
+	if((id < 0) || (id >= wdt_subsys_cnt)) return;
+
+	wdt_subsys[id].last = wdt_ticks; // One store: read by the supervisor in the interrupt handler
+	wdt_subsys[id].checkins++;
+}
+
+void wdt_supervisor_start(void)
+{
+	WDT_InitTypeDef WDT_InitStructure;
+	uint8_t i;
+
+	CRG_WDOGCLK_HS_SourceSelect(CRG_RCLK);
+	CRG_WDOGCLK_HS_SetPrescale(CRG_PREDIV1);
+
+	WDT_InitStructure.WDTLoad = WDT_LOAD;
+	WDT_InitStructure.WDTControl_RstEn = WDTControl_RstEnable;
+	WDT_Init(&WDT_InitStructure);
+
+	// Deadlines from now: the initialization before the start is not supervised
+	for(i = 0; i < wdt_subsys_cnt; i++) wdt_subsys[i].last = wdt_ticks;
+
+	wdt_running = 1;
+	WDT_Start();
+}
+
+// Once a subsystem missed its deadline the watchdog is not kicked any more, also if it checks in again
+void wdt_supervisor_tick(void)
+{
+	st_wdt_subsys * subsys;
+	const char * task;
+	uint32_t now, late;
+	uint8_t i;
+
+	now = ++wdt_ticks;
+
+	if(!wdt_running || wdt_starved) return;
+	if(++wdt_check_cnt < WDT_CHECK_MSEC) return;
+	wdt_check_cnt = 0;
+
+	for(i = 0; i < wdt_subsys_cnt; i++)
+	{
+		subsys = &wdt_subsys[i];
+		late = now - subsys->last;
+		if(late <= subsys->deadline) continue;
+
+		// The culprit: kept across the reset
+		task = get_sched_running();
+		wdt_record.resets++;
+		wdt_record_name(wdt_record.subsys, subsys->name);
+		wdt_record_name(wdt_record.task, (task != NULL) ? task : "");
+		wdt_record.late = late;
+		wdt_record.uptime = now;
+		wdt_record.magic = WDT_RECORD_STARVED;
+		wdt_record_seal(&wdt_record);
+
+		wdt_starved = 1;
+		return;
+	}
+
+	WDT_IntClear(); // Kick: reload of the counter
+}
+
+const st_wdt_record* get_wdt_last_reset(void)
+{
+	return wdt_last_reset_valid ? &wdt_last_reset : NULL;
+}
+
+uint32_t get_wdt_resets(void)
+{
+	return wdt_record.resets;
+}
+
+uint8_t get_wdt_subsys_count(void)
+{
+	return wdt_subsys_cnt;
+}
+
+const st_wdt_subsys* get_wdt_subsys(uint8_t id)
+{
+	if(id >= wdt_subsys_cnt) return NULL;
+
+	return &wdt_subsys[id];
+}
+
+uint32_t get_wdt_tick(void)
+{
+	return wdt_ticks;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void wdt_record_seal(st_wdt_record * rec)
+{
+	rec->check = ~(rec->magic ^ rec->resets ^ rec->late ^ rec->uptime);
+}
+
+static uint8_t wdt_record_valid(const st_wdt_record * rec)
+{
+	if((rec->magic != WDT_RECORD_STARVED) && (rec->magic != WDT_RECORD_REPORTED)) return 0;
+	if(rec->check != ~(rec->magic ^ rec->resets ^ rec->late ^ rec->uptime)) return 0;
+	if((rec->subsys[WDT_NAME_SIZE - 1] != '\0') || (rec->task[WDT_NAME_SIZE - 1] != '\0')) return 0;
+
+	return 1;
+}
+
+static void wdt_record_name(char * dst, const char * src)
+{
+	strncpy(dst, src, WDT_NAME_SIZE - 1);
+	dst[WDT_NAME_SIZE - 1] = '\0';
+}
@@ -0,0 +1,62 @@
+#ifndef WDTHANDLER_H_
+#define WDTHANDLER_H_
+
+#include <stdint.h>
+
+// Watchdog supervisor: the watchdog timer is kicked only while every registered subsystem checks in within its
+// deadline (checked every WDT_CHECK_MSEC by the 1ms Tick Timer). The first subsystem which misses its deadline is
+// recorded in the no-init RAM (section "NoInit", W7500x_App.sct), which survives the reset: reported at the next boot
+// and by '/diag/watchdog'
+#define WDT_MAX_SUBSYS			6
+#define WDT_TIMEOUT_MSEC		2000	// Reset this time after the last kick
+#define WDT_CHECK_MSEC			100		// Supervisor period: check of the deadlines, then the kick
+
+#define WDT_SUBSYS_NONE			-1
+
+typedef struct _st_wdt_subsys
+{
+	const char* name;
+	uint16_t deadline;		// ms between two check-ins
+	uint32_t last;			// Tick (ms) of the last check-in
+	uint32_t checkins;
+} st_wdt_subsys;
+
+// Reset by the supervisor, kept across the reset
+#define WDT_NAME_SIZE			12
+
+typedef struct _st_wdt_record
+{
+	uint32_t magic;					// WDT_RECORD_xxx
+	uint32_t resets;				// Resets by the supervisor since the power on
+	char     subsys[WDT_NAME_SIZE];	// Subsystem which missed its deadline
+	char     task[WDT_NAME_SIZE];	// Main loop task running at that time, empty: none
+	uint32_t late;					// ms since the last check-in of the subsystem
+	uint32_t uptime;				// ms since the boot
+	uint32_t check;					// Integrity of the record: the RAM contents are random at the power on
+} st_wdt_record;
+
+// At the boot: takes the record of the last reset by the supervisor (get_wdt_last_reset())
+void wdt_supervisor_init(void);
+
+// Returns the subsystem id, WDT_SUBSYS_NONE if the table is full; before wdt_supervisor_start()
+int8_t wdt_add_subsys(const char* name, uint16_t deadline_msec);
+
+// Liveness token of the subsystem: from the main loop
+void wdt_checkin(int8_t id);
+
+// Watchdog timer start: reset WDT_TIMEOUT_MSEC after the last kick
+void wdt_supervisor_start(void);
+
+// 1ms Tick Timer handler: deadlines and kick
+void wdt_supervisor_tick(void);
+
+// Record of the reset by the supervisor before this boot, NULL: other reset (power on, reset pin, ...)
+const st_wdt_record* get_wdt_last_reset(void);
+uint32_t get_wdt_resets(void);
+
+// Subsystems: ages of the check-ins (ms) from 'get_wdt_tick()'
+uint8_t get_wdt_subsys_count(void);
+const st_wdt_subsys* get_wdt_subsys(uint8_t id);
+uint32_t get_wdt_tick(void);
+
+#endif /* WDTHANDLER_H_ */
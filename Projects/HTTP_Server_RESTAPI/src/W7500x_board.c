@@ -1,13 +1,22 @@
 #include "W7500x.h"
 #include "W7500x_miim.h"
 #include "W7500x_gpio.h"
+#include "W7500x_wztoe.h"
+#include "wizchip_conf.h"
 
 #include "common.h"
 #include "W7500x_board.h"
 #include "timerHandler.h"
+#include "schedHandler.h"
+
+// Socket events of the WZTOE interrupt; not SENDOK: polled and cleared by send()
+#define WZTOE_SOCK_EVENTS		(Sn_IR_CON | Sn_IR_DISCON | Sn_IR_RECV | Sn_IR_TIMEOUT)
 
 static void PHY_Init(void);
 
+static uint8_t wztoe_irq_socks = 0;					// Sockets of the interrupt: bit n, socket n
+static int8_t  wztoe_irq_task = SCHED_TASK_NONE;
+
 GPIO_TypeDef* LED_PORT[LEDn] = {LED1_GPIO_PORT, LED2_GPIO_PORT};
 const uint16_t LED_PIN[LEDn] = {LED1_PIN, LED2_PIN};
 PAD_Type LED_PAD[LEDn] = {LED1_GPIO_PAD, LED2_GPIO_PAD};
@@ -24,6 +33,59 @@ void W7500x_Board_Init(void)
 	LED_Init(LED2);
 }
 
+/**
+  * @brief  Configures the WZTOE socket interrupt: the events of the sockets post a scheduler task.
+  * @param  sock_list, sock_cnt: H/W sockets
+  * @param  task: Scheduler task which handles the sockets, calls WZTOE_IRQ_Rearm() before reading them
+  * @retval None
+  */
+void WZTOE_IRQ_Configuration(uint8_t * sock_list, uint8_t sock_cnt, int8_t task)
+{
+	uint8_t i;
+	
+	wztoe_irq_task = task;
+	
+	for(i = 0; i < sock_cnt; i++)
+	{
+		setSn_IMR(sock_list[i], WZTOE_SOCK_EVENTS);
+		wztoe_irq_socks |= (uint8_t)(1 << sock_list[i]);
+	}
+	setSIMR(wztoe_irq_socks);
+	
+	NVIC_EnableIRQ(WZTOE_IRQn);
+}
+
+/**
+  * @brief  WZTOE interrupt: the interrupt stays asserted while the socket events are set, so it is masked until the
+  *         task has read the sockets.
+  * @param  None
+  * @retval None
+  */
+void WZTOE_IRQ_Handler(void)
+{
+	NVIC_DisableIRQ(WZTOE_IRQn);
+	sched_post(wztoe_irq_task);
+}
+
+/**
+  * @brief  Clears the socket events and unmasks the WZTOE interrupt: the events up to this call are handled by the
+  *         reads of the sockets which follow, the later ones post the task again.
+  *         CON is left to the HTTP server, which counts the connections with it.
+  * @param  None
+  * @retval None
+  */
+void WZTOE_IRQ_Rearm(void)
+{
+	uint8_t i;
+	
+	for(i = 0; i < _WIZCHIP_SOCK_NUM_; i++)
+	{
+		if(wztoe_irq_socks & (1 << i)) setSn_ICR(i, WZTOE_SOCK_EVENTS & ~Sn_IR_CON);
+	}
+	
+	NVIC_EnableIRQ(WZTOE_IRQn);
+}
+
 static void PHY_Init(void)
 {
 #ifdef __DEF_USED_IC101AG__ // For using W7500 + (IC+101AG Phy)
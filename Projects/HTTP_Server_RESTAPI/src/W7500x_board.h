@@ -127,6 +127,11 @@
 	
 	void W7500x_Board_Init(void);
 	
+	// WZTOE socket interrupt: wakes the scheduler task of the sockets
+	void WZTOE_IRQ_Configuration(uint8_t * sock_list, uint8_t sock_cnt, int8_t task);
+	void WZTOE_IRQ_Handler(void);
+	void WZTOE_IRQ_Rearm(void);
+	
 	void LED_Init(Led_TypeDef Led);
 	void LED_On(Led_TypeDef Led);
 	void LED_Off(Led_TypeDef Led);
@@ -22,6 +22,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include "W7500x.h"
 #include "timerHandler.h"
+#include "uartHandler.h"
+#include "crashHandler.h"
+#include "W7500x_board.h"
 
 
 /* Private typedef -----------------------------------------------------------*/
@@ -46,11 +49,45 @@ void NMI_Handler(void)
 
 /**
   * @brief  This function handles Hard Fault exception.
+  *         Passes the exception frame (on the MSP or the PSP, bit 2 of EXC_RETURN) and EXC_RETURN to crash_capture(),
+  *         which records them and resets the system.
   * @param  None
   * @retval None
   */
-void HardFault_Handler(void)
-{}
+#if defined(__CC_ARM)
+__asm void HardFault_Handler(void)
+{
+	IMPORT crash_capture
+	MOVS r0, #4
+	MOV r1, lr
+	TST r0, r1
+	BNE HardFault_psp
+	MRS r0, MSP
+	B HardFault_capture
+HardFault_psp
+	MRS r0, PSP
+HardFault_capture
+	LDR r2, =crash_capture
+	BX r2
+	ALIGN
+}
+#else
+__attribute__((naked)) void HardFault_Handler(void)
+{
+	__asm volatile(
+		"MOVS r0, #4        \n"
+		"MOV r1, lr         \n"
+		"TST r0, r1         \n"
+		"BNE 1f             \n"
+		"MRS r0, MSP        \n"
+		"B 2f               \n"
+		"1: MRS r0, PSP     \n"
+		"2: LDR r2, =crash_capture \n"
+		"BX r2              \n"
+		".ltorg             \n"
+	);
+}
+#endif
 
 /**
   * @brief  This function handles SVCall exception.
@@ -125,7 +162,9 @@ void UART1_Handler(void)
   * @retval None
   */
 void UART2_Handler(void)
-{}
+{
+	UART2_IRQ_Handler();
+}
 
 
 /**
@@ -289,7 +328,9 @@ void ADC_Handler(void)
   * @retval None
   */
 void WZTOE_Handler(void)
-{}
+{
+	WZTOE_IRQ_Handler();
+}
 
 /**
   * @brief  This function handles EXTI Handler.
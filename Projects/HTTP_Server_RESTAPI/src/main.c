@@ -35,25 +35,51 @@
 #include "timerHandler.h"
 #include "uartHandler.h"
 #include "gpioHandler.h"
+#include "traceHandler.h"
+#include "schedHandler.h"
+#include "wdtHandler.h"
+#include "memHandler.h"
+#include "crashHandler.h"
 
 #include "httpServer_rest.h"
+#include "RESTapiHandler.h"
+#include "httpMetrics.h"
+#include "httpDiag.h"
+
+#define LOG_MODULE			LOG_MODULE_MAIN
+#define LOG_MODULE_LEVEL	LOG_LEVEL_MAIN
+#include "logHandler.h"
 
 /* Private typedef -----------------------------------------------------------*/
 
 /* Private define ------------------------------------------------------------*/
-//#define _MAIN_DEBUG_	// debugging message enable
 //#define _USE_DNS_
 //#define _USE_DHCP_
 
 /* Private function prototypes -----------------------------------------------*/
 static void W7500x_Init(void);
+static void app_main(void);
 static void W7500x_WZTOE_Init(void);
 
+// Main loop tasks (schedHandler.h)
+static void task_http_server(void);
+static void task_http_reaper(void);
+static void task_io_sample(void);
+static void task_log(void);
+static void task_led(void);
+static void task_link(void);
+static void wdt_checkin_http(void);
+#ifdef _USE_TRACE_
+static void task_console(void);
+#endif
+
 
 // Debug messages
 void display_Dev_Info_header(void);
 void display_Dev_Info_main(void);
 void display_Dev_Info_http(void);
+void display_Dev_Info_wdt(void);
+void display_Dev_Info_crash(void);
 
 void delay(__IO uint32_t milliseconds); // Notice: used ioLibray
 void TimingDelay_Decrement(void);
@@ -63,6 +89,7 @@ void TimingDelay_Decrement(void);
 	#include "dhcp_cb.h"
 	int8_t process_dhcp(void);
 	void display_Dev_Info_dhcp(void);
+	static void task_dhcp(void);
 	uint8_t flag_process_dhcp_success = OFF;
 #endif
 
@@ -76,10 +103,19 @@ void TimingDelay_Decrement(void);
 /* Private variables ---------------------------------------------------------*/
 static __IO uint32_t TimingDelay;
 
+static int8_t task_http = SCHED_TASK_NONE;
+
+// Watchdog supervisor: subsystems
+static int8_t wdt_http = WDT_SUBSYS_NONE;
+static int8_t wdt_link = WDT_SUBSYS_NONE;
+static int8_t wdt_io = WDT_SUBSYS_NONE;
+
+static uint8_t link_up = 0xFF; // PHY link status, 0xFF: not read yet
+
 /* Public variables ---------------------------------------------------------*/
 // Shared buffer declaration
 uint8_t g_send_buf[DATA_BUF_SIZE];
-uint8_t g_recv_buf[DATA_BUF_SIZE];
+uint8_t g_recv_buf[DATA_BUF_SIZE + 1]; // + End of string (EOS) marker of a full-size request (httpServer_run)
 
 uint8_t flag_application_running = OFF;
 
@@ -91,15 +127,44 @@ uint8_t mac[] = {0x00, 0x08, 0xDC, 0xaa, 0xbb, 0xcc};
 #define HTTP_SERVER_PORT	80
 uint8_t sock_list[] = {3, 4, 5};
 
+// Main loop tasks: periods (ms)
+#define TASK_HTTP_POLL_MSEC		10		// Socket state changes without an interrupt, e.g., the end of a close
+#define TASK_DHCP_MSEC			100
+#define TASK_REAPER_MSEC		1000
+#define TASK_LOG_MSEC			10		// One log message per run
+#define TASK_CONSOLE_MSEC		50
+#define TASK_LINK_MSEC			500
+
+// Watchdog supervisor: deadlines of the subsystems (ms)
+#define WDT_HTTP_DEADLINE_MSEC	1000	// HTTP server passes: 10ms poll at least
+#define WDT_LINK_DEADLINE_MSEC	2000	// Network link monitor
+#define WDT_IO_DEADLINE_MSEC	1000	// Analog input sampler
+
 /**
   * @brief  Main program
   * @param  None
   * @retval None
   */
 int main(void)
+{
+	/* Stacks: the application on the process stack, the interrupt handlers on the main stack; painted for the high-water marks */
+	stack_start(app_main); // Does not return
+	
+	return 0;
+}
+
+/**
+  * @brief  Application: initialization and main loop, on the process stack
+  * @param  None
+  * @retval None
+  */
+static void app_main(void)
 {
 	DevConfig *dev_config = get_DevConfig_pointer();
-	uint8_t i;
+	
+	/* Watchdog supervisor and crash capture: records of the last reset, before anything else */
+	wdt_supervisor_init();
+	crash_init();
 	
 	////////////////////////////////////////////////////////////////////////////////////////////////////
 	// W7500x Hardware Initialize
@@ -114,6 +179,8 @@ int main(void)
 	/* W7500x Board Initialization */
 	W7500x_Board_Init();
 	
+	log_flush(); // Log messages of the initialization
+	
 	////////////////////////////////////////////////////////////////////////////////////////////////////
 	// W7500x Application: Initialize
 	////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -134,6 +201,8 @@ int main(void)
 	// Debug UART: Device information print out
 	display_Dev_Info_header();
 	display_Dev_Info_main();
+	display_Dev_Info_wdt();
+	display_Dev_Info_crash();
 	
 	////////////////////////////////////////////////////////////////////////////////////////////////////
 	// W7500x Application: DHCP client
@@ -160,6 +229,7 @@ int main(void)
 	}
 	
 	// Debug UART: Network information print out (includes DHCP IP allocation result)
+	log_flush();
 	display_Net_Info();
 	display_Dev_Info_http();
 	
@@ -185,26 +255,133 @@ int main(void)
 	flag_application_running = ON;
 	LED_On(LED1);
 	
+	/* REST API resources: built-in resources */
+	// User modules register the additional resources here, e.g., reg_http_resources(user_resource_table);
+	RESTapi_init();
+	http_metrics_init(); // '/metrics': Prometheus text format
+	http_diag_init(); // '/diag/trace'
+	
+	TRACE_EVENT(TRACE_SOCK_NONE, TRACE_EV_BOOT, 0, 0);
+	
 	httpServer_init(g_send_buf, g_recv_buf, MAX_HTTPSOCK, sock_list);
 	
-	while(1) // main loop
-	{
-		for(i = 0; i < MAX_HTTPSOCK; i++) httpServer_run(HTTP_SERVER_PORT);
-		
+	/* Main loop tasks: the tasks ready at once run in this order */
+	task_http = sched_add_task("http", task_http_server, TASK_HTTP_POLL_MSEC);
 #ifdef _USE_DHCP_
-		if(dev_config->options.dhcp_use) DHCP_run(); // DHCP client handler for IP renewal
+	if(dev_config->options.dhcp_use) sched_add_task("dhcp", task_dhcp, TASK_DHCP_MSEC); // DHCP client handler for IP renewal
 #endif
-		
-		if(flag_check_main_routine)
+	sched_add_task("reaper", task_http_reaper, TASK_REAPER_MSEC);
+	sched_add_task("io", task_io_sample, IO_SAMPLE_PERIOD_MSEC);
+#ifdef _USE_TRACE_
+	sched_add_task("console", task_console, TASK_CONSOLE_MSEC);
+#endif
+	sched_add_task("log", task_log, TASK_LOG_MSEC);
+	sched_add_task("led", task_led, MAIN_ROUTINE_CHECK_CYCLE_MSEC);
+	sched_add_task("link", task_link, TASK_LINK_MSEC);
+	
+	/* Watchdog supervisor: the subsystems check in from their tasks */
+	wdt_http = wdt_add_subsys("http", WDT_HTTP_DEADLINE_MSEC);
+	wdt_link = wdt_add_subsys("link", WDT_LINK_DEADLINE_MSEC);
+	wdt_io = wdt_add_subsys("io", WDT_IO_DEADLINE_MSEC);
+	reg_httpServer_cbfunc(NULL, wdt_checkin_http);
+	
+	/* Socket events wake up the HTTP server task */
+	WZTOE_IRQ_Configuration(sock_list, MAX_HTTPSOCK, task_http);
+	sched_post(task_http);
+	
+	log_flush();
+	
+	/* Debug UART: from now on printf() does not wait for the UART (UART2_TX_POLICY when the TX ring is full) */
+	UART2_SetTxBlocking(DISABLE);
+	
+	wdt_supervisor_start();
+	
+	sched_run(); // main loop: does not return
+} // End of app_main
+
+
+/*****************************************************************************
+ * Main loop tasks
+ ****************************************************************************/
+static void task_http_server(void)
+{
+	uint8_t i;
+	
+	WZTOE_IRQ_Rearm(); // Socket events from now on post the task again
+	
+	for(i = 0; i < MAX_HTTPSOCK; i++) httpServer_run(HTTP_SERVER_PORT);
+	
+	http_metrics_loop(); // HTTP server passes: '/metrics'
+	
+	if(httpServer_busy()) sched_post(task_http); // Response in progress: the next pass without waiting for an event
+}
+
+static void task_http_reaper(void)
+{
+	httpServer_reap();
+}
+
+static void task_io_sample(void)
+{
+	IO_sample_analog();
+	wdt_checkin(wdt_io);
+}
+
+static void task_log(void)
+{
+	log_loop(); // Deferred log messages: one printf() per run
+}
+
+static void task_led(void)
+{
+	// Device working indicator
+	// LEDs blink rapidly (100ms)
+	LED_Toggle(LED1);
+	LED_Toggle(LED2);
+}
+
+static void task_link(void)
+{
+	// Network link monitor: PHY link status (MDIO)
+	uint8_t up = (uint8_t)link();
+	
+	if(up != link_up)
+	{
+		if(link_up != 0xFF) LOG_WARN1("PHY link %s", up ? "up" : "down");
+		link_up = up;
+	}
+	
+	wdt_checkin(wdt_link);
+}
+
+// HTTP server WDT reset callback (reg_httpServer_cbfunc)
+static void wdt_checkin_http(void)
+{
+	wdt_checkin(wdt_http);
+}
+
+#ifdef _USE_TRACE_
+static void task_console(void)
+{
+	// Debug UART: 't' drains the trace ring ('TRACE:' lines, decoded by host/tracedump)
+	if(S_UART_GetFlagStatus(S_UART_STATE_RXF) == SET)
+	{
+		if(S_UART_ReceiveData() == 't')
 		{
-			// Device working indicator
-			// LEDs blink rapidly (100ms)
-			LED_Toggle(LED1);
-			LED_Toggle(LED2);
-			flag_check_main_routine = 0;
+			UART2_SetTxBlocking(ENABLE); // The dump is larger than the TX ring: wait instead of dropping
+			trace_dump();
+			UART2_SetTxBlocking(DISABLE);
 		}
-	} // End of application main loop
-} // End of main
+	}
+}
+#endif
+
+#ifdef _USE_DHCP_
+static void task_dhcp(void)
+{
+	DHCP_run();
+}
+#endif
 
 
 /*****************************************************************************
@@ -234,9 +411,7 @@ static void W7500x_Init(void)
 	/* SysTick_Config */
 	SysTick_Config((GetSystemClock()/1000));
 	
-#ifdef _MAIN_DEBUG_
-	printf("\r\n GetSystemClock : %d (Hz) \r\n", GetSystemClock());  
-#endif
+	LOG_INFO1("GetSystemClock: %d (Hz)", GetSystemClock());
 }
 
 static void W7500x_WZTOE_Init(void)
@@ -252,37 +427,29 @@ static void W7500x_WZTOE_Init(void)
 	/* Structure for TCP timeout control: RTR, RCR */
 	wiz_NetTimeout * net_timeout;
 	
-#ifdef _MAIN_DEBUG_
+#if (LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG)
 	uint8_t i;
 #endif
 	
 	/* Set WZ_100US Register */
 	setTIC100US((GetSystemClock()/10000));
-#ifdef _MAIN_DEBUG_
-	printf(" GetSystemClock: %X, getTIC100US: %X, (%X) \r\n", GetSystemClock(), getTIC100US(), *(uint32_t *)WZTOE_TIC100US); // for debugging
-#endif
+	LOG_DEBUG3("GetSystemClock: %X, getTIC100US: %X, (%X)", GetSystemClock(), getTIC100US(), *(uint32_t *)WZTOE_TIC100US);
 	/* Set TCP Timeout: retry count / timeout val */
 	// Retry count default: [8], Timeout val default: [2000]
 	net_timeout->retry_cnt = 8;
 	net_timeout->time_100us = 2500;
 	wizchip_settimeout(net_timeout);
 	
-#ifdef _MAIN_DEBUG_
+#if (LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG)
 	wizchip_gettimeout(net_timeout); // TCP timeout settings
-	printf(" Network Timeout Settings - RCR: %d, RTR: %dms\r\n", net_timeout->retry_cnt, net_timeout->time_100us);
 #endif
+	LOG_DEBUG2("Network Timeout Settings - RCR: %d, RTR: %dms", net_timeout->retry_cnt, net_timeout->time_100us);
 	
 	/* Set Network Configuration */
 	wizchip_init(tx_size, rx_size);
 	
-#ifdef _MAIN_DEBUG_
-	printf(" WZTOE H/W Socket Buffer Settings (kB)\r\n");
-	printf(" [Tx] ");
-	for(i = 0; i < _WIZCHIP_SOCK_NUM_; i++) printf("%d ", getSn_TXBUF_SIZE(i));
-	printf("\r\n");
-	printf(" [Rx] ");
-	for(i = 0; i < _WIZCHIP_SOCK_NUM_; i++) printf("%d ", getSn_RXBUF_SIZE(i));
-	printf("\r\n");
+#if (LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG)
+	for(i = 0; i < _WIZCHIP_SOCK_NUM_; i++) LOG_DEBUG3("WZTOE H/W Socket %d Buffer Settings - Tx: %dkB, Rx: %dkB", i, getSn_TXBUF_SIZE(i), getSn_RXBUF_SIZE(i));
 #endif
 }
 
@@ -318,6 +485,31 @@ void display_Dev_Info_http(void)
 	printf(" # HTTP Server Port: %d\r\n", HTTP_SERVER_PORT);
 }
 
+void display_Dev_Info_wdt(void)
+{
+	const st_wdt_record * last = get_wdt_last_reset();
+	
+	if(last == NULL) return;
+	
+	printf(" # Watchdog reset [%u since power on]: '%s' missed its deadline by %ums", get_wdt_resets(), last->subsys, last->late);
+	if(last->task[0] != '\0') printf(", task '%s' running", last->task);
+	printf(", uptime %ums\r\n", last->uptime);
+	printf("%s\r\n", STR_BAR);
+}
+
+void display_Dev_Info_crash(void)
+{
+	const st_crash_record * last = get_crash_last();
+	
+	if(last == NULL) return;
+	
+	printf(" # HardFault: PC 0x%08X, LR 0x%08X, SP 0x%08X", last->pc, last->lr, last->sp);
+	if(last->task[0] != '\0') printf(", task '%s' running", last->task);
+	printf(", uptime %ums\r\n", last->uptime);
+	printf(" # Details: /diag/crash\r\n");
+	printf("%s\r\n", STR_BAR);
+}
+
 #ifdef _USE_DHCP
 
 int8_t process_dhcp(void)
@@ -325,9 +517,7 @@ int8_t process_dhcp(void)
 	uint8_t ret = 0;
 	uint8_t dhcp_retry = 0;
 
-#ifdef _MAIN_DEBUG_
-	printf(" - DHCP Client running\r\n");
-#endif
+	LOG_INFO("DHCP Client running");
 	DHCP_init(SOCK_DHCP, g_send_buf);
 	reg_dhcp_cbfunc(w7500x_dhcp_assign, w7500x_dhcp_assign, w7500x_dhcp_conflict);
 	
@@ -337,24 +527,18 @@ int8_t process_dhcp(void)
 		
 		if(ret == DHCP_IP_LEASED)
 		{
-#ifdef _MAIN_DEBUG_
-			printf(" - DHCP Success\r\n");
-#endif
+			LOG_INFO("DHCP Success");
 			break;
 		}
 		else if(ret == DHCP_FAILED)
 		{
 			dhcp_retry++;
-#ifdef _MAIN_DEBUG_
-			if(dhcp_retry <= 3) printf(" - DHCP Timeout occurred and retry [%d]\r\n", dhcp_retry);
-#endif
+			if(dhcp_retry <= 3) LOG_WARN1("DHCP Timeout occurred and retry [%d]", dhcp_retry);
 		}
 
 		if(dhcp_retry > 3)
 		{
-#ifdef _MAIN_DEBUG_
-			printf(" - DHCP Failed\r\n\r\n");
-#endif
+			LOG_WARN("DHCP Failed");
 			DHCP_stop();
 			break;
 		}
@@ -388,9 +572,7 @@ int8_t process_dns(void)
 	uint8_t dns_retry = 0;
 	uint8_t dns_server_ip[4];
 	
-#ifdef _MAIN_DEBUG_
-	printf(" - DNS Client running\r\n");
-#endif
+	LOG_INFO("DNS Client running");
 	
 	DNS_init(SOCK_DNS, g_send_buf);
 	
@@ -403,23 +585,17 @@ int8_t process_dns(void)
 	{
 		if((ret = DNS_run(dns_server_ip, (uint8_t *)dev_config->options.dns_domain_name, dev_config->network_info.remote_ip)) == 1)
 		{
-#ifdef _MAIN_DEBUG_
-			printf(" - DNS Success\r\n");
-#endif
+			LOG_INFO("DNS Success");
 			break;
 		}
 		else
 		{
 			dns_retry++;
-#ifdef _MAIN_DEBUG_
-			if(dns_retry <= 2) printf(" - DNS Timeout occurred and retry [%d]\r\n", dns_retry);
-#endif
+			if(dns_retry <= 2) LOG_WARN1("DNS Timeout occurred and retry [%d]", dns_retry);
 		}
 
 		if(dns_retry > 2) {
-#ifdef _MAIN_DEBUG_
-			printf(" - DNS Failed\r\n\r\n");
-#endif
+			LOG_WARN("DNS Failed");
 			break;
 		}
 		if(dev_config->options.dhcp_use) DHCP_run();
@@ -21,6 +21,7 @@
 
 #include <stdio.h>
 #include "W7500x_uart.h"
+#include "uartHandler.h"
 
 #define USING_UART2
 
@@ -31,8 +32,18 @@
 	#define UART_SEND_BYTE(ch)  UartPutc(UART1,ch)
 	#define UART_RECV_BYTE()    UartGetc(UART1)
 #elif defined (USING_UART2)
-	#define UART_SEND_BYTE(ch)  S_UartPutc(ch)
+	// TX ring of uartHandler.c: no wait for the UART
+	#define UART_SEND_BYTE(ch)  UART2_Putc(ch)
 	#define UART_RECV_BYTE()    S_UartGetc()
+
+static int UART2_Putc(int ch)
+{
+	uint8_t c = (uint8_t)ch;
+
+	UART2_Write(&c, 1);
+
+	return ch;
+}
 #endif
 
 
@@ -77,10 +88,14 @@ void _sys_exit(int return_code) {
 
 __attribute__ ((used))  int _write (int fd, char *ptr, int len)
 {
+#if defined (USING_UART2)
+  UART2_Write((const uint8_t *)ptr, (uint16_t)len); // copy into the TX ring
+#else
   size_t i;
   for (i=0; i<len;i++) {
     UART_SEND_BYTE(ptr[i]); // call character output function
     }
+#endif
   return len;
 }
 #else //using TOOLCHAIN_IAR